@@ -0,0 +1,138 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+// pthread_rwlock_t is POSIX, not C17.
+#define _POSIX_C_SOURCE 200809L
+
+#include "ConcurrentHashTable.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "CSE333.h"
+#include "ConcurrentHashTable_priv.h"
+#include "HashTable.h"
+#include "HashTable_priv.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+
+// Locks the segment holding "key" for reading or writing and returns it.
+static CHTSegment *LockSegment(ConcurrentHashTable *table, HTKey_t key,
+                               bool exclusive) {
+  CHTSegment *segment = &table->segments[CHTSegmentForKey(key)];
+  int res = exclusive ? pthread_rwlock_wrlock(&segment->lock)
+                      : pthread_rwlock_rdlock(&segment->lock);
+  Verify333(res == 0);
+  return segment;
+}
+
+static void UnlockSegment(CHTSegment *segment) {
+  Verify333(pthread_rwlock_unlock(&segment->lock) == 0);
+}
+
+int CHTSegmentForKey(HTKey_t key) {
+  // Segment tables pick buckets from the key's low-order bits, so we pick
+  // segments from the high-order bits of the mixed key.
+  return (int)(HTMixKey(key) >> (64 - CHT_SEGMENT_BITS));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ConcurrentHashTable implementation.
+
+ConcurrentHashTable *ConcurrentHashTable_Allocate(int num_buckets) {
+  ConcurrentHashTable *table;
+  // A Find runs under a shared lock, so it must not modify the segment's
+  // table; that rules out incremental resizing, which migrates buckets
+  // during Finds.
+  HTOptions options = { HT_ENGINE_CHAINED, false };
+  int i;
+
+  Verify333(num_buckets > 0);
+  table = (ConcurrentHashTable *)malloc(sizeof(ConcurrentHashTable));
+  Verify333(table != NULL);
+  table->segments = (CHTSegment *)aligned_alloc(
+      CHT_CACHE_LINE, CHT_NUM_SEGMENTS * sizeof(CHTSegment));
+  Verify333(table->segments != NULL);
+
+  for (i = 0; i < CHT_NUM_SEGMENTS; i++) {
+    CHTSegment *segment = &table->segments[i];
+    Verify333(pthread_rwlock_init(&segment->lock, NULL) == 0);
+    segment->table = HashTable_AllocateWithOptions(
+        (num_buckets + CHT_NUM_SEGMENTS - 1) / CHT_NUM_SEGMENTS, &options);
+  }
+  return table;
+}
+
+void ConcurrentHashTable_Free(ConcurrentHashTable *table,
+                              ValueFreeFnPtr value_free_function) {
+  int i;
+
+  Verify333(table != NULL);
+  for (i = 0; i < CHT_NUM_SEGMENTS; i++) {
+    CHTSegment *segment = &table->segments[i];
+    HashTable_Free(segment->table, value_free_function);
+    Verify333(pthread_rwlock_destroy(&segment->lock) == 0);
+  }
+  free(table->segments);
+  free(table);
+}
+
+int ConcurrentHashTable_NumElements(ConcurrentHashTable *table) {
+  int i, num_elements = 0;
+
+  Verify333(table != NULL);
+  for (i = 0; i < CHT_NUM_SEGMENTS; i++) {
+    CHTSegment *segment = &table->segments[i];
+    Verify333(pthread_rwlock_rdlock(&segment->lock) == 0);
+    num_elements += HashTable_NumElements(segment->table);
+    UnlockSegment(segment);
+  }
+  return num_elements;
+}
+
+bool ConcurrentHashTable_Insert(ConcurrentHashTable *table,
+                                HTKeyValue_t newkeyvalue,
+                                HTKeyValue_t *oldkeyvalue) {
+  CHTSegment *segment;
+  bool res;
+
+  Verify333(table != NULL);
+  segment = LockSegment(table, newkeyvalue.key, true);
+  res = HashTable_Insert(segment->table, newkeyvalue, oldkeyvalue);
+  UnlockSegment(segment);
+  return res;
+}
+
+bool ConcurrentHashTable_Find(ConcurrentHashTable *table, HTKey_t key,
+                              HTKeyValue_t *keyvalue) {
+  CHTSegment *segment;
+  bool res;
+
+  Verify333(table != NULL);
+  segment = LockSegment(table, key, false);
+  res = HashTable_Find(segment->table, key, keyvalue);
+  UnlockSegment(segment);
+  return res;
+}
+
+bool ConcurrentHashTable_Remove(ConcurrentHashTable *table, HTKey_t key,
+                                HTKeyValue_t *keyvalue) {
+  CHTSegment *segment;
+  bool res;
+
+  Verify333(table != NULL);
+  segment = LockSegment(table, key, true);
+  res = HashTable_Remove(segment->table, key, keyvalue);
+  UnlockSegment(segment);
+  return res;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_CONCURRENTHASHTABLE_H_
+#define HW1_CONCURRENTHASHTABLE_H_
+
+#include <stdbool.h>    // for bool type (true, false)
+
+#include "./HashTable.h"  // for HTKey_t, HTKeyValue_t, ValueFreeFnPtr
+
+///////////////////////////////////////////////////////////////////////////////
+// A ConcurrentHashTable is a HashTable that many threads may use at once.
+//
+// Rather than serializing every operation on one lock, the table is split
+// into a fixed number of segments, each an ordinary HashTable guarded by
+// its own reader/writer lock.  A key always lives in the same segment, so
+// operations on keys in different segments never contend, and any number
+// of Finds may run in the same segment at once.  Each segment resizes
+// itself while holding only its own lock, so a resize stalls just the
+// keys in that segment.
+//
+// Insert, Find and Remove have the same contracts as their HashTable
+// counterparts.  Note that Find hands back a copy of the (key,value)
+// pair: if another thread removes and frees that value, the copy dangles,
+// so callers sharing values across threads must manage their lifetime.
+//
+// As with our other types, the struct is defined in
+// ConcurrentHashTable_priv.h.
+typedef struct cht ConcurrentHashTable;
+
+// Allocate and return a new, empty table.
+//
+// Arguments:
+// - num_buckets: the total number of buckets to start with, spread over
+//   the segments; MUST be greater than zero.
+//
+// Returns:
+// - the newly-allocated table (never NULL).
+ConcurrentHashTable* ConcurrentHashTable_Allocate(int num_buckets);
+
+// Free a table and everything it contains.  Unlike the other functions,
+// this is NOT thread-safe: no other thread may be using the table.
+//
+// Arguments:
+// - table: the table to free.
+// - value_free_function: invoked once per value; may be NULL.
+void ConcurrentHashTable_Free(ConcurrentHashTable *table,
+                              ValueFreeFnPtr value_free_function);
+
+// Returns the number of elements in the table.  While other threads are
+// modifying the table, this is only a snapshot.
+int ConcurrentHashTable_NumElements(ConcurrentHashTable *table);
+
+// Thread-safe versions of HashTable_Insert, HashTable_Find and
+// HashTable_Remove; see HashTable.h for their contracts.
+bool ConcurrentHashTable_Insert(ConcurrentHashTable *table,
+                                HTKeyValue_t newkeyvalue,
+                                HTKeyValue_t *oldkeyvalue);
+bool ConcurrentHashTable_Find(ConcurrentHashTable *table,
+                              HTKey_t key,
+                              HTKeyValue_t *keyvalue);
+bool ConcurrentHashTable_Remove(ConcurrentHashTable *table,
+                                HTKey_t key,
+                                HTKeyValue_t *keyvalue);
+
+#endif  // HW1_CONCURRENTHASHTABLE_H_
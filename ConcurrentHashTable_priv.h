@@ -0,0 +1,54 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_CONCURRENTHASHTABLE_PRIV_H_
+#define HW1_CONCURRENTHASHTABLE_PRIV_H_
+
+#include <pthread.h>   // for pthread_rwlock_t
+#include <stdalign.h>  // for alignas
+
+#include "./ConcurrentHashTable.h"
+#include "./HashTable.h"
+
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+// Internal structures for our ConcurrentHashTable implementation, broken
+// out into a "private .h" so that our unittests can peek inside.
+//
+// Customers should not include this file or assume anything based on
+// its contents.
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+// The number of segments (and locks); a power of two.  A key's segment is
+// chosen by the top CHT_SEGMENT_BITS bits of its mixed hash.
+#define CHT_SEGMENT_BITS 6
+#define CHT_NUM_SEGMENTS (1 << CHT_SEGMENT_BITS)
+
+// Segments are padded out to a cache line so that threads taking locks in
+// neighbouring segments don't bounce a shared line between their cores.
+#define CHT_CACHE_LINE 64
+
+// One segment: an ordinary (non-thread-safe) HashTable and the lock that
+// guards it.  Finds take the lock shared; Inserts and Removes, which may
+// resize the segment's table, take it exclusive.
+typedef struct cht_segment {
+  alignas(CHT_CACHE_LINE) pthread_rwlock_t lock;
+  HashTable *table;
+} CHTSegment;
+
+// The table itself is just the segment array.
+typedef struct cht {
+  CHTSegment *segments;  // CHT_NUM_SEGMENTS segments
+} ConcurrentHashTable;
+
+// Returns the segment that holds (or would hold) "key".
+int CHTSegmentForKey(HTKey_t key);
+
+#endif  // HW1_CONCURRENTHASHTABLE_PRIV_H_
@@ -0,0 +1,393 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_HASHMAP_H_
+#define HW1_HASHMAP_H_
+
+#include <stddef.h>  // for size_t, ptrdiff_t
+#include <stdint.h>  // for uint64_t
+
+#include <functional>   // for std::hash, std::equal_to
+#include <iterator>     // for std::forward_iterator_tag
+#include <memory>       // for std::unique_ptr
+#include <tuple>        // for std::forward_as_tuple
+#include <type_traits>  // for std::conditional_t
+#include <utility>      // for std::pair, std::move, std::forward
+
+///////////////////////////////////////////////////////////////////////////////
+// A HashMap is a C++17, header-only HashTable for typed keys and values.
+//
+// It has the same design as a chained HashTable: a power-of-two array of
+// buckets, each heading a chain of nodes, with the same load policy (grow
+// once there are 3 elements per bucket on average) and the same mixer as
+// a pow2_buckets table.  What the C API can't do, HashMap does at compile
+// time:
+//
+// - Keys and values are any types, stored inline in the chain nodes,
+//   rather than a uint64_t and a void* to a separately allocated value.
+// - Values are moved or constructed in place (Insert takes forwarding
+//   references, TryEmplace constructs from arguments), never copied
+//   unless the caller passes an lvalue.  Move-only values work.
+// - Hashing and key equality are template parameters, so they (and the
+//   value destructors, in place of a ValueFreeFnPtr) are inlined.
+//
+// Each node also caches its key's hash, so resizing never rehashes a key,
+// and a chain walk only calls KeyEqual on nodes whose hash matches.
+//
+// A HashMap owns its elements; it can be moved but not copied.  As with
+// HashTable, any modification invalidates existing iterators, but
+// pointers returned by Find stay valid until their element is removed,
+// even across resizes.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace hw1 {
+
+// HashMap's bucket mixer: HTMixKey, inlined.  std::hash is the identity
+// for integers, so without this, keys with a common stride would pile into
+// a few of the power-of-two buckets.
+constexpr uint64_t HashMapMix(uint64_t h) {
+  h ^= h >> 32;
+  h *= 0xd6e8feb86659fd93ULL;
+  h ^= h >> 32;
+  h *= 0xd6e8feb86659fd93ULL;
+  h ^= h >> 32;
+  return h;
+}
+
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class HashMap {
+ private:
+  struct Node;
+  template <bool kConst> class Iterator;
+
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<const K, V>;
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+
+  // The HashTable defaults: grow when the load factor reaches 3, by a
+  // factor of 8 (the power of two nearest HashTable's 9).
+  static constexpr size_t kMaxLoadFactor = 3;
+  static constexpr size_t kGrowthFactor = 8;
+
+  // Constructs an empty map with at least num_buckets buckets.
+  explicit HashMap(size_t num_buckets = 1, const Hash &hash = Hash(),
+                   const KeyEqual &equal = KeyEqual())
+      : hash_(hash), equal_(equal) {
+    AllocateBuckets(RoundUpPow2(num_buckets));
+  }
+
+  HashMap(HashMap &&other) noexcept
+      : buckets_(std::move(other.buckets_)),
+        num_buckets_(other.num_buckets_),
+        num_elements_(other.num_elements_),
+        resize_at_(other.resize_at_),
+        hash_(std::move(other.hash_)),
+        equal_(std::move(other.equal_)) {
+    other.LeaveEmpty();
+  }
+
+  HashMap &operator=(HashMap &&other) noexcept {
+    if (this != &other) {
+      Clear();
+      buckets_ = std::move(other.buckets_);
+      num_buckets_ = other.num_buckets_;
+      num_elements_ = other.num_elements_;
+      resize_at_ = other.resize_at_;
+      hash_ = std::move(other.hash_);
+      equal_ = std::move(other.equal_);
+      other.LeaveEmpty();
+    }
+    return *this;
+  }
+
+  HashMap(const HashMap &) = delete;
+  HashMap &operator=(const HashMap &) = delete;
+
+  ~HashMap() { Clear(); }
+
+  size_t size() const { return num_elements_; }
+  bool empty() const { return num_elements_ == 0; }
+  size_t bucket_count() const { return num_buckets_; }
+
+  // Inserts (key,value), replacing the value if the key is already present.
+  // The key and value are moved in if they are rvalues.
+  //
+  // Returns true if the key was already present (and its value replaced),
+  // like HashTable_Insert.
+  template <typename VV>
+  bool Insert(const K &key, VV &&value) {
+    return InsertImpl(key, std::forward<VV>(value));
+  }
+  template <typename VV>
+  bool Insert(K &&key, VV &&value) {
+    return InsertImpl(std::move(key), std::forward<VV>(value));
+  }
+
+  // If key is absent, inserts it with a value constructed in place from
+  // args; otherwise does nothing (and doesn't touch args).
+  //
+  // Returns the key's value, and whether it was inserted.
+  template <typename... Args>
+  std::pair<V *, bool> TryEmplace(const K &key, Args &&...args) {
+    size_t hash = hash_(key);
+    if (Node *node = num_elements_ ? FindNode(key, hash) : nullptr) {
+      return {&node->kv.second, false};
+    }
+    Node *node = new Node(hash, std::piecewise_construct,
+                          std::forward_as_tuple(key),
+                          std::forward_as_tuple(std::forward<Args>(args)...));
+    Link(node);
+    return {&node->kv.second, true};
+  }
+
+  // Returns the key's value, inserting a value-initialized one if the key
+  // is absent.
+  V &operator[](const K &key) { return *TryEmplace(key).first; }
+
+  // Returns a pointer to the key's value, or nullptr if it's absent.
+  V *Find(const K &key) {
+    if (num_elements_ == 0) return nullptr;
+    Node *node = FindNode(key, hash_(key));
+    return node ? &node->kv.second : nullptr;
+  }
+  const V *Find(const K &key) const {
+    return const_cast<HashMap *>(this)->Find(key);
+  }
+
+  // Removes the key, if present, first moving its value into *removed if
+  // removed is non-null.
+  //
+  // Returns true if the key was present.
+  bool Remove(const K &key, V *removed = nullptr) {
+    if (num_elements_ == 0) return false;
+    size_t hash = hash_(key);
+    Node **link = &buckets_[BucketOf(hash)];
+    for (; *link != nullptr; link = &(*link)->next) {
+      Node *node = *link;
+      if (node->hash == hash && equal_(node->kv.first, key)) {
+        if (removed != nullptr) {
+          *removed = std::move(node->kv.second);
+        }
+        *link = node->next;
+        delete node;
+        num_elements_--;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Makes room for num_elements elements without further resizing, like
+  // HashTable_Reserve.
+  void Reserve(size_t num_elements) {
+    if (num_elements <= resize_at_) return;
+    Rehash(RoundUpPow2((num_elements + kMaxLoadFactor - 1) / kMaxLoadFactor));
+  }
+
+  // Removes every element, keeping the buckets.
+  void Clear() {
+    if (buckets_ == nullptr) return;
+    for (size_t i = 0; i < num_buckets_; i++) {
+      Node *node = buckets_[i];
+      while (node != nullptr) {
+        delete std::exchange(node, node->next);
+      }
+      buckets_[i] = nullptr;
+    }
+    num_elements_ = 0;
+  }
+
+  iterator begin() { return iterator(buckets_.get(), num_buckets_); }
+  iterator end() { return iterator(); }
+  const_iterator begin() const {
+    return const_iterator(buckets_.get(), num_buckets_);
+  }
+  const_iterator end() const { return const_iterator(); }
+
+ private:
+  struct Node {
+    template <typename... Args>
+    explicit Node(size_t hash, Args &&...args)
+        : next(nullptr), hash(hash), kv(std::forward<Args>(args)...) {}
+
+    Node       *next;
+    size_t      hash;  // hash_(kv.first), before mixing
+    value_type  kv;
+  };
+
+  // Iterators walk the buckets in order, and each chain front to back.  A
+  // default-constructed iterator is the end.
+  template <bool kConst>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = HashMap::value_type;
+    using difference_type = ptrdiff_t;
+    using pointer = std::conditional_t<kConst, const value_type *,
+                                       value_type *>;
+    using reference = std::conditional_t<kConst, const value_type &,
+                                         value_type &>;
+
+    Iterator() = default;
+
+    // Every iterator converts to a const_iterator.
+    operator Iterator<true>() const {  // NOLINT(runtime/explicit)
+      return Iterator<true>(buckets_, num_buckets_, bucket_, node_);
+    }
+
+    reference operator*() const { return node_->kv; }
+    pointer operator->() const { return &node_->kv; }
+
+    Iterator &operator++() {
+      node_ = node_->next;
+      if (node_ == nullptr) {
+        SkipEmptyBuckets(bucket_ + 1);
+      }
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const Iterator &other) const {
+      return node_ == other.node_;
+    }
+    bool operator!=(const Iterator &other) const {
+      return node_ != other.node_;
+    }
+
+   private:
+    friend class HashMap;
+    template <bool> friend class Iterator;
+
+    Iterator(Node *const *buckets, size_t num_buckets)
+        : buckets_(buckets), num_buckets_(num_buckets) {
+      SkipEmptyBuckets(0);
+    }
+    Iterator(Node *const *buckets, size_t num_buckets, size_t bucket,
+             Node *node)
+        : buckets_(buckets), num_buckets_(num_buckets), bucket_(bucket),
+          node_(node) {}
+
+    // Points at the first node in bucket b or later, or at the end.
+    void SkipEmptyBuckets(size_t b) {
+      for (; b < num_buckets_; b++) {
+        if (buckets_[b] != nullptr) {
+          bucket_ = b;
+          node_ = buckets_[b];
+          return;
+        }
+      }
+      node_ = nullptr;
+    }
+
+    Node *const *buckets_ = nullptr;
+    size_t       num_buckets_ = 0;
+    size_t       bucket_ = 0;
+    Node        *node_ = nullptr;
+  };
+
+  static size_t RoundUpPow2(size_t n) {
+    size_t pow2 = 1;
+    while (pow2 < n) {
+      pow2 *= 2;
+    }
+    return pow2;
+  }
+
+  size_t BucketOf(size_t hash) const {
+    return HashMapMix(hash) & (num_buckets_ - 1);
+  }
+
+  void AllocateBuckets(size_t num_buckets) {
+    buckets_.reset(new Node *[num_buckets]());
+    num_buckets_ = num_buckets;
+    resize_at_ = num_buckets * kMaxLoadFactor;
+  }
+
+  // A moved-from map has no buckets at all, until its next insert.
+  void LeaveEmpty() {
+    buckets_.reset();
+    num_buckets_ = 0;
+    num_elements_ = 0;
+    resize_at_ = 0;
+  }
+
+  // MUST NOT be called on a map with no elements, which may have no
+  // buckets.
+  Node *FindNode(const K &key, size_t hash) const {
+    Node *node = buckets_[BucketOf(hash)];
+    for (; node != nullptr; node = node->next) {
+      if (node->hash == hash && equal_(node->kv.first, key)) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  template <typename KK, typename VV>
+  bool InsertImpl(KK &&key, VV &&value) {
+    size_t hash = hash_(key);
+    if (Node *node = num_elements_ ? FindNode(key, hash) : nullptr) {
+      node->kv.second = std::forward<VV>(value);
+      return true;
+    }
+    Link(new Node(hash, std::forward<KK>(key), std::forward<VV>(value)));
+    return false;
+  }
+
+  // Adds a new node to its chain, first growing if the table is full.
+  void Link(Node *node) {
+    if (num_elements_ >= resize_at_) {
+      Rehash(num_buckets_ ? num_buckets_ * kGrowthFactor : 1);
+    }
+    Node **head = &buckets_[BucketOf(node->hash)];
+    node->next = *head;
+    *head = node;
+    num_elements_++;
+  }
+
+  // Moves every node into a new array of num_buckets buckets, using the
+  // cached hashes.
+  void Rehash(size_t num_buckets) {
+    std::unique_ptr<Node *[]> old = std::move(buckets_);
+    size_t old_num_buckets = num_buckets_;
+
+    AllocateBuckets(num_buckets);
+    for (size_t i = 0; i < old_num_buckets; i++) {
+      Node *node = old[i];
+      while (node != nullptr) {
+        Node *next = node->next;
+        Node **head = &buckets_[BucketOf(node->hash)];
+        node->next = *head;
+        *head = node;
+        node = next;
+      }
+    }
+  }
+
+  std::unique_ptr<Node *[]> buckets_;
+  size_t                    num_buckets_ = 0;  // a power of two
+  size_t                    num_elements_ = 0;
+  size_t                    resize_at_ = 0;    // grow on reaching this
+  Hash                      hash_;
+  KeyEqual                  equal_;
+};
+
+}  // namespace hw1
+
+#endif  // HW1_HASHMAP_H_
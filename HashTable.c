@@ -9,15 +9,21 @@
  * author.
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "HashTable.h"
 
+#include <limits.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "CSE333.h"
 #include "HashTable_priv.h"
 #include "LinkedList.h"
+#include "LinkedList_priv.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // Internal helper functions.
@@ -28,15 +34,230 @@
 // factor has become too high.
 static void MaybeResize(HashTable *ht);
 
+// Rebuilds the chained table "ht" with new_num_buckets buckets, either all
+// at once or (for an incremental_resize table) by starting a migration.
+static void Resize(HashTable *ht, int new_num_buckets);
+
+// Shrinks the hashtable if a Remove has left its load factor too low.
+static void MaybeShrink(HashTable *ht);
+
+// Returns the number of buckets that leaves ht at the load factor its
+// policy resizes to, for its current number of elements.
+static int FittedNumBuckets(HashTable *ht);
+
+// Recomputes ht's resize_at and shrink_at for its current number of
+// buckets.
+static void UpdateThresholds(HashTable *ht);
+
+// HashTable_Remove, except that the table shrinks afterwards only if
+// may_shrink is set.  HTIterator_Remove can't let the table shrink out
+// from under its iterator.
+static bool RemoveKey(HashTable *table, HTKey_t key, HTKeyValue_t *keyvalue,
+                      bool may_shrink);
+
+// Points an iterator at the first element of "table", or leaves it
+// invalid if the table is empty, without touching next_table and its
+// state.  Like HTIterator_Allocate, it finishes any in-progress
+// incremental resize.
+static void HTIteratorInit(HTIterator *iter, HashTable *table);
+
+// HTIterator_Next, except that it stops at the end of the iterator's
+// current table rather than moving on to its next_table.
+static bool NextInTable(HTIterator *iter);
+
+// Rounds n up to a power of two.
+static int RoundUpPow2(int n);
+
+// Rounds x up to an int, saturating at INT_MAX.
+static int CeilToInt(double x);
+
+// Moves up to max_buckets old buckets into the new bucket array, if a resize
+// is in progress.  Frees the old array once every bucket has been moved.
+static void MigrateBuckets(HashTable *ht, int max_buckets);
+
+// Returns the chain that holds (or would hold) "key", taking an in-progress
+// resize into account.  ChainSlotForKey returns the bucket array slot that
+// points at that chain.  If "bucket" isn't NULL, the chain's index in
+// ht->buckets is returned through it, or INVALID_IDX if the chain is in
+// ht->old_buckets.
+static LinkedList *ChainForKey(HashTable *ht, HTKey_t key, int *bucket);
+static LinkedList **ChainSlotForKey(HashTable *ht, HTKey_t key, int *bucket);
+
+// Allocates an all-clear occupancy bitmap for num_buckets buckets.
+static uint64_t *AllocateBitmap(int num_buckets);
+
+// Sets or clears a bucket's bit in ht's occupancy bitmap.
+static inline void MarkOccupied(HashTable *ht, int bucket) {
+  ht->occupied[bucket >> 6] |= 1ULL << (bucket & 63);
+}
+
+static inline void MarkEmpty(HashTable *ht, int bucket) {
+  ht->occupied[bucket >> 6] &= ~(1ULL << (bucket & 63));
+}
+
+// Returns the first non-empty bucket at or after "start", or INVALID_IDX
+// if there are none.
+static int NextOccupied(HashTable *ht, int start);
+
+// Prefetches everything a lookup of each of keys[0, n) will touch: for a
+// chained table, the bucket slot, the chain's LinkedList and up to
+// HT_BATCH_PREFETCH_NODES of its nodes; for a swiss table, the first
+// probed group.  n is at most HT_BATCH_GROUP.  For a chained table,
+// slots[i] and buckets[i] are set to what ChainSlotForKey returns for
+// keys[i]; they stay valid until the table is next resized or migrates
+// buckets.
+static void PrefetchChains(HashTable *ht, const HTKey_t *keys, int n,
+                           LinkedList ***slots, int *buckets);
+
+// The chained half of HashTable_Insert: inserts newkeyvalue into the chain
+// in "slot", which is bucket number "bucket" (or INVALID_IDX for a bucket
+// in old_buckets), as found by ChainSlotForKey.
+static bool InsertIntoChain(HashTable *table, LinkedList **slot, int bucket,
+                            HTKeyValue_t newkeyvalue,
+                            HTKeyValue_t *oldkeyvalue);
+
+// The values of HTLookup.stage: what the lookup's "next" points at.
+enum {
+  LOOKUP_SWISS,  // the swiss table; its first group was prefetched
+  LOOKUP_SLOT,   // the bucket array slot for the key
+  LOOKUP_CHAIN,  // the key's chain
+  LOOKUP_NODE,   // a chain node
+};
+
+// A bucket that has never held an entry is NULL, rather than a LinkedList
+// of its own.  Reading one goes through ChainInSlot, which hands back this
+// shared, empty chain instead; reading that behaves just like reading any
+// other empty chain, so lookups needn't tell the difference.  It MUST NOT
+// be modified, so anything that adds to a chain first calls
+// MaterializeChain.
+static LinkedList kEmptyChain;
+
+// Allocates an array of num_buckets empty (NULL) buckets, zeroed by
+// calloc, so that pages of the array no bucket has used yet needn't be
+// touched at all.
+static LinkedList **AllocateBuckets(int num_buckets);
+
+// Returns the chain in bucket array slot "slot": kEmptyChain if the
+// bucket has no chain of its own.
+static inline LinkedList *ChainInSlot(LinkedList *const *slot);
+
+// Returns the chain in bucket array slot "slot", first giving the bucket a
+// chain of its own (allocated the way ht allocates chains) if it doesn't
+// have one yet.
+static LinkedList *MaterializeChain(HashTable *ht, LinkedList **slot);
+
+// Frees chains [first, last) of "buckets" along with their entries, then
+// the array itself.
+static void FreeBuckets(HashTable *ht, LinkedList **buckets, int first,
+                        int last, ValueFreeFnPtr value_free_function);
+
+// Allocates a chain node the same way ht's chains allocate their nodes, so
+// that the chains can later free it.
+static HTChainNode *NewChainNode(HashTable *ht);
+
+// Counts one Find that made num_probes probes (key comparisons along a
+// chain, or swiss groups), if ht is a collect_stats table.
+static inline void CountFind(HashTable *ht, int num_probes);
+
+// Should MigrateBuckets time itself?  A stop-the-world migration is part
+// of the resize, so it always is; an incremental one spreads over many
+// ops, and is timed only for a collect_stats table.
+static inline bool TimeMigrations(HashTable *ht) {
+  return ht->collect_stats || !ht->incremental_resize;
+}
+
+// Returns a monotonic timestamp in nanoseconds.
+static uint64_t NowNanos(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// The hash that chooses a key's bucket: the key itself, or for a
+// pow2_buckets table the mixed key.
+static inline uint64_t BucketHash(HashTable *ht, HTKey_t key) {
+  return ht->pow2_buckets ? HTMixKey(key) : key;
+}
+
+// Maps a BucketHash to a bucket in an array of num_buckets buckets.
+static inline int HashToBucketNum(HashTable *ht, int num_buckets,
+                                  uint64_t hash) {
+  if (ht->pow2_buckets) {
+    return hash & (uint64_t)(num_buckets - 1);
+  }
+  return hash % num_buckets;
+}
+
+uint64_t HTMixKey(HTKey_t key) {
+  uint64_t h = key;
+  h ^= h >> 32;
+  h *= 0xd6e8feb86659fd93ULL;
+  h ^= h >> 32;
+  h *= 0xd6e8feb86659fd93ULL;
+  h ^= h >> 32;
+  return h;
+}
+
 int HashKeyToBucketNum(HashTable *ht, HTKey_t key) {
-  return key % ht->num_buckets;
+  return HashToBucketNum(ht, ht->num_buckets, BucketHash(ht, key));
 }
 
 // Deallocation functions that do nothing.  Useful if we want to deallocate
 // the structure (eg, the linked list) without deallocating its elements or
 // if we know that the structure is empty.
 static void LLNoOpFree(LLPayload_t freeme) {}
-static void HTNoOpFree(HTValue_t freeme) {}
+
+// The 64 bit FNV-1a parameters.
+static const uint64_t FNV1_64_INIT = 0xcbf29ce484222325ULL;
+static const uint64_t FNV_64_PRIME = 0x100000001b3ULL;
+
+// How many buffers FNVHash64_Batch hashes in lockstep.  Each lane is an
+// independent xor/multiply chain; four of them are enough to keep a
+// pipelined 64-bit multiplier busy.  (The lockstep loop is written out
+// for exactly this many lanes.)
+#define FNV_BATCH_LANES 4
+
+// The wyhash mixing constants.
+static const uint64_t WIDE_SECRET[4] = {
+  0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+  0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+// Sets (*a, *b) to the low and high halves of the 128-bit product *a * *b.
+static inline void WideMultiply(uint64_t *a, uint64_t *b) {
+#ifdef __SIZEOF_INT128__
+  __extension__ typedef unsigned __int128 uint128;
+  uint128 r = (uint128)*a * *b;
+  *a = (uint64_t)r;
+  *b = (uint64_t)(r >> 64);
+#else
+  uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32), c = t < rl, lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+// Folds the 128-bit product of a and b down to 64 bits.
+static inline uint64_t WideMix(uint64_t a, uint64_t b) {
+  WideMultiply(&a, &b);
+  return a ^ b;
+}
+
+// Unaligned little-endian-host reads.
+static inline uint64_t WideRead8(const unsigned char *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint64_t WideRead4(const unsigned char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 // HashTable implementation.
@@ -45,8 +266,6 @@ HTKey_t FNVHash64(unsigned char *buffer, int len) {
   // This code is adapted from code by Landon Curt Noll
   // and Bonelli Nicola:
   //     http://code.google.com/p/nicola-bonelli-repo/
-  static const uint64_t FNV1_64_INIT = 0xcbf29ce484222325ULL;
-  static const uint64_t FNV_64_PRIME = 0x100000001b3ULL;
   unsigned char *bp = (unsigned char *)buffer;
   unsigned char *be = bp + len;
   uint64_t hval = FNV1_64_INIT;
@@ -61,54 +280,243 @@ HTKey_t FNVHash64(unsigned char *buffer, int len) {
   return hval;
 }
 
+void FNVHash64_Batch(unsigned char **buffers, const int *lens, int count,
+                     HTKey_t *hashes) {
+  int i;
+
+  Verify333(count >= 0);
+  for (i = 0; i + FNV_BATCH_LANES <= count; i += FNV_BATCH_LANES) {
+    const unsigned char *b0 = buffers[i], *b1 = buffers[i + 1];
+    const unsigned char *b2 = buffers[i + 2], *b3 = buffers[i + 3];
+    uint64_t h0 = FNV1_64_INIT, h1 = FNV1_64_INIT;
+    uint64_t h2 = FNV1_64_INIT, h3 = FNV1_64_INIT;
+    int common = INT_MAX;
+    int lane, pos;
+
+    for (lane = 0; lane < FNV_BATCH_LANES; lane++) {
+      Verify333(lens[i + lane] >= 0);
+      if (lens[i + lane] < common) {
+        common = lens[i + lane];
+      }
+    }
+
+    // Hash the prefix that every lane has in lockstep.  The four chains
+    // don't depend on one another, so their multiplies overlap in the
+    // pipeline instead of each waiting on the last.
+    for (pos = 0; pos < common; pos++) {
+      h0 = (h0 ^ b0[pos]) * FNV_64_PRIME;
+      h1 = (h1 ^ b1[pos]) * FNV_64_PRIME;
+      h2 = (h2 ^ b2[pos]) * FNV_64_PRIME;
+      h3 = (h3 ^ b3[pos]) * FNV_64_PRIME;
+    }
+    hashes[i] = h0;
+    hashes[i + 1] = h1;
+    hashes[i + 2] = h2;
+    hashes[i + 3] = h3;
+
+    // Finish off whatever is left of each lane on its own.
+    for (lane = 0; lane < FNV_BATCH_LANES; lane++) {
+      unsigned char *bp = buffers[i + lane] + common;
+      unsigned char *be = buffers[i + lane] + lens[i + lane];
+      uint64_t hval = hashes[i + lane];
+      while (bp < be) {
+        hval ^= (uint64_t)*bp++;
+        hval *= FNV_64_PRIME;
+      }
+      hashes[i + lane] = hval;
+    }
+  }
+
+  // Leftover buffers that don't fill a whole batch.
+  for (; i < count; i++) {
+    Verify333(lens[i] >= 0);
+    hashes[i] = FNVHash64(buffers[i], lens[i]);
+  }
+}
+
+HTKey_t WideHash64(unsigned char *buffer, int len) {
+  const unsigned char *p = buffer;
+  uint64_t seed = WideMix(WIDE_SECRET[0], WIDE_SECRET[1]);
+  size_t n = (size_t)len;
+  uint64_t a, b;
+
+  Verify333(len >= 0);
+  if (n <= 16) {
+    if (n >= 4) {
+      // Two (possibly overlapping) pairs of 4-byte reads cover the buffer.
+      size_t off = (n >> 3) << 2;
+      a = (WideRead4(p) << 32) | WideRead4(p + off);
+      b = (WideRead4(p + n - 4) << 32) | WideRead4(p + n - 4 - off);
+    } else if (n > 0) {
+      a = ((uint64_t)p[0] << 16) | ((uint64_t)p[n >> 1] << 8) | p[n - 1];
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = n;
+    if (i > 48) {
+      // Three independent 16-byte lanes per iteration.
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = WideMix(WideRead8(p) ^ WIDE_SECRET[1],
+                       WideRead8(p + 8) ^ seed);
+        see1 = WideMix(WideRead8(p + 16) ^ WIDE_SECRET[2],
+                       WideRead8(p + 24) ^ see1);
+        see2 = WideMix(WideRead8(p + 32) ^ WIDE_SECRET[3],
+                       WideRead8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = WideMix(WideRead8(p) ^ WIDE_SECRET[1], WideRead8(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    // The last 16 bytes, which may overlap bytes we've already mixed in.
+    a = WideRead8(p + i - 16);
+    b = WideRead8(p + i - 8);
+  }
+
+  a ^= WIDE_SECRET[1];
+  b ^= seed;
+  WideMultiply(&a, &b);
+  return WideMix(a ^ WIDE_SECRET[0] ^ n, b ^ WIDE_SECRET[1]);
+}
+
 HashTable *HashTable_Allocate(int num_buckets) {
+  return HashTable_AllocateWithOptions(num_buckets, NULL);
+}
+
+HashTable *HashTable_AllocateWithOptions(int num_buckets,
+                                         const HTOptions *options) {
   HashTable *ht;
-  int i;
 
   Verify333(num_buckets > 0);
 
   // Allocate the hash table record.
-  ht = (HashTable *)malloc(sizeof(HashTable));
+  ht = (HashTable *)aligned_alloc(
+      HT_CACHE_LINE,
+      (sizeof(HashTable) + HT_CACHE_LINE - 1) / HT_CACHE_LINE * HT_CACHE_LINE);
   Verify333(ht != NULL);
 
   // Initialize the record.
-  ht->num_buckets = num_buckets;
   ht->num_elements = 0;
-  ht->buckets = (LinkedList **)malloc(num_buckets * sizeof(LinkedList *));
-  Verify333(ht->buckets != NULL);
-  for (i = 0; i < num_buckets; i++) {
-    ht->buckets[i] = LinkedList_Allocate();
+  ht->engine = (options != NULL) ? options->engine : HT_ENGINE_CHAINED;
+  ht->swiss = NULL;
+  ht->incremental_resize = (options != NULL) && options->incremental_resize;
+  ht->old_buckets = NULL;
+  ht->old_num_buckets = 0;
+  ht->migrate_idx = 0;
+  ht->node_pool = NULL;
+  ht->pow2_buckets = (options != NULL) && options->pow2_buckets;
+  ht->max_load_factor = HT_DEFAULT_MAX_LOAD_FACTOR;
+  ht->growth_factor = ht->pow2_buckets ? 8 : HT_DEFAULT_GROWTH_FACTOR;
+  if (options != NULL && options->max_load_factor != 0) {
+    Verify333(options->max_load_factor > 0);
+    ht->max_load_factor = options->max_load_factor;
+  }
+  if (options != NULL && options->growth_factor != 0) {
+    Verify333(options->growth_factor >= 2);
+    ht->growth_factor = ht->pow2_buckets ?
+        RoundUpPow2(options->growth_factor) : options->growth_factor;
+  }
+  ht->min_load_factor = 0;
+  if (options != NULL && options->min_load_factor != 0) {
+    Verify333(options->min_load_factor > 0);
+    Verify333(options->min_load_factor <
+              ht->max_load_factor / ht->growth_factor);
+    ht->min_load_factor = options->min_load_factor;
+  }
+  ht->num_resizes = 0;
+  ht->resize_nanos = 0;
+  ht->collect_stats = (options != NULL) && options->collect_stats;
+  ht->num_finds = 0;
+  ht->num_probes = 0;
+
+  if (ht->engine == HT_ENGINE_SWISS) {
+    // The swiss engine owns all of the storage; we just mirror its size.
+    ht->swiss = SwissTable_Allocate(num_buckets);
+    ht->num_buckets = ht->swiss->capacity;
+    ht->buckets = NULL;
+    ht->occupied = NULL;
+    return ht;
   }
 
+  if (options != NULL && options->use_pool) {
+    ht->node_pool = MemPool_Allocate(sizeof(HTChainNode));
+  }
+
+  if (ht->pow2_buckets) {
+    num_buckets = RoundUpPow2(num_buckets);
+  }
+
+  ht->num_buckets = num_buckets;
+  ht->min_buckets = num_buckets;
+  ht->buckets = AllocateBuckets(num_buckets);
+  ht->occupied = AllocateBitmap(num_buckets);
+  UpdateThresholds(ht);
   return ht;
 }
 
-void HashTable_Free(HashTable *table, ValueFreeFnPtr value_free_function) {
-  int i;
+void HashTable_Reserve(HashTable *table, int num_elements) {
+  int num_buckets;
 
   Verify333(table != NULL);
+  Verify333(num_elements >= 0);
+
+  if (table->engine == HT_ENGINE_SWISS) {
+    int8_t *old_ctrl = table->swiss->ctrl;
+    uint64_t start = NowNanos();
+    SwissTable_Reserve(table->swiss, num_elements);
+    if (table->swiss->ctrl != old_ctrl) {
+      table->num_resizes++;
+      table->resize_nanos += NowNanos() - start;
+    }
+    table->num_buckets = table->swiss->capacity;
+    return;
+  }
 
-  // Free each bucket's chain.
-  for (i = 0; i < table->num_buckets; i++) {
-    LinkedList *bucket = table->buckets[i];
-    HTKeyValue_t *kv;
+  // A table grows once num_elements reaches resize_at, so all we need is
+  // a threshold of at least num_elements.
+  if (num_elements <= table->resize_at) return;
+  num_buckets = CeilToInt(num_elements / table->max_load_factor);
+  Verify333(num_buckets < INT_MAX);
+  if (table->pow2_buckets) {
+    num_buckets = RoundUpPow2(num_buckets);
+  }
 
-    // Pop elements off the chain list one at a time.  We can't do a single
-    // call to LinkedList_Free since we need to use the passed-in
-    // value_free_function -- which takes a HTValue_t, not an LLPayload_t -- to
-    // free the caller's memory.
-    while (LinkedList_NumElements(bucket) > 0) {
-      Verify333(LinkedList_Pop(bucket, (LLPayload_t *)&kv));
-      value_free_function(kv->value);
-      free(kv);
-    }
-    // The chain is empty, so we can pass in the
-    // null free function to LinkedList_Free.
-    LinkedList_Free(bucket, LLNoOpFree);
+  // Having reserved the room, we mustn't shrink away from it.
+  table->min_buckets = num_buckets;
+  Resize(table, num_buckets);
+}
+
+void HashTable_Free(HashTable *table, ValueFreeFnPtr value_free_function) {
+  Verify333(table != NULL);
+
+  if (table->engine == HT_ENGINE_SWISS) {
+    SwissTable_Free(table->swiss, value_free_function);
+    free(table);
+    return;
   }
 
-  // Free the bucket array within the table, then free the table record itself.
-  free(table->buckets);
+  // Free each bucket's chain, including any not-yet-migrated old ones.
+  FreeBuckets(table, table->buckets, 0, table->num_buckets,
+              value_free_function);
+  if (table->old_buckets != NULL) {
+    FreeBuckets(table, table->old_buckets, table->migrate_idx,
+                table->old_num_buckets, value_free_function);
+  }
+
+  // Pooled nodes are all released at once.
+  if (table->node_pool != NULL) {
+    MemPool_Free(table->node_pool);
+  }
+  free(table->occupied);
+
+  // Free the table record itself.
   free(table);
 }
 
@@ -119,37 +527,64 @@ int HashTable_NumElements(HashTable *table) {
 
 // Declaration before definition
 // Helper function created mainly for STEP 1 but also the other steps
-// Inserts a (key,value) pair into the HashTable.
+// Looks for a key within a single chain.
+//
+// The search uses caller-provided iterator storage (typically on the
+// caller's stack), so it never allocates.  On success the iterator is left
+// pointing at the matching node, so the caller can unlink it with
+// LLIterator_Remove without walking the chain a second time.
 //
 // Arguments:
-// - table: the HashTable to insert into.
-// - oldpair_ptr: a return parameter; if a previous pair is found,
-//   the popped keyvalue is returned through this parameter. This is
-//   a double pointer because we want to send addresses too
-// - newkey: the new key we are tring to find. Just sending this seperately
-//   instead of relying on oldpair_ptr is just unneccesary headache
-// - chain: the actual linkedlist chain we want to insert into
+// - chain: the actual linkedlist chain we want to search
+// - newkey: the key we are trying to find
+// - iter: caller-owned iterator storage; initialized by this function
+// - oldpair_ptr: a return parameter; if the key is found, a pointer to
+//   the pair (which lives inside the chain node) is returned through it
+// - num_probes: if not NULL, a return parameter through which the number
+//   of keys compared (up to and including the match) is returned
 //
 // Returns:
-//  - false: if the newkeyvalue was not found and there was no
-//    existing (key,value) with that key.
-//  - true: if the newkeyvalue was found and an old value
-//    with the same key was also found and returned through
-//    the oldpair_ptr return parameter.
-bool HashTable_FindKey(HashTable *table, HTKeyValue_t **oldpair_ptr,
-                       HTKey_t newkey, LinkedList *chain);
+//  - false: if there was no existing (key,value) with that key.
+//  - true: if a (key,value) with the same key was found and returned
+//    through the oldpair_ptr return parameter.
+static bool HashTable_FindKey(LinkedList *chain, HTKey_t newkey,
+                              LLIterator *iter, HTKeyValue_t **oldpair_ptr,
+                              int *num_probes);
 
 bool HashTable_Insert(HashTable *table, HTKeyValue_t newkeyvalue,
                       HTKeyValue_t *oldkeyvalue) {
+  LinkedList **slot;
   int bucket;
-  LinkedList *chain;
 
   Verify333(table != NULL);
+
+  if (table->engine == HT_ENGINE_SWISS) {
+    // The swiss table can only rehash once it has run out of room, so
+    // that's the only time we need to watch the clock.
+    int8_t *old_ctrl = table->swiss->ctrl;
+    uint64_t start = (table->swiss->growth_left == 0) ? NowNanos() : 0;
+    bool replaced = SwissTable_Insert(table->swiss, newkeyvalue, oldkeyvalue);
+    if (table->swiss->ctrl != old_ctrl) {
+      table->num_resizes++;
+      table->resize_nanos += NowNanos() - start;
+    }
+    table->num_elements = table->swiss->num_elements;
+    table->num_buckets = table->swiss->capacity;
+    return replaced;
+  }
+
+  MigrateBuckets(table, HT_MIGRATE_BUCKETS_PER_OP);
   MaybeResize(table);
 
   // Calculate which bucket and chain we're inserting into.
-  bucket = HashKeyToBucketNum(table, newkeyvalue.key);
-  chain = table->buckets[bucket];
+  slot = ChainSlotForKey(table, newkeyvalue.key, &bucket);
+  return InsertIntoChain(table, slot, bucket, newkeyvalue, oldkeyvalue);
+}
+
+static bool InsertIntoChain(HashTable *table, LinkedList **slot, int bucket,
+                            HTKeyValue_t newkeyvalue,
+                            HTKeyValue_t *oldkeyvalue) {
+  LinkedList *chain = ChainInSlot(slot);
 
   // STEP 1: finish the implementation of InsertHashTable.
   // This is a fairly complex task, so you might decide you want
@@ -159,10 +594,11 @@ bool HashTable_Insert(HashTable *table, HTKeyValue_t newkeyvalue,
   // can be reused in steps 2 and 3.
 
   HTKeyValue_t *temp;
+  LLIterator iter;
   // must use temp because we need to both change oldkeyvalue and
   // also return it
 
-  if (HashTable_FindKey(table, &temp, newkeyvalue.key, chain)) {
+  if (HashTable_FindKey(chain, newkeyvalue.key, &iter, &temp, NULL)) {
     // No need to remove/add nodes, just change the payload
     // FindKey just needs key value, we get the address of temp for
     // a double pointer
@@ -173,12 +609,18 @@ bool HashTable_Insert(HashTable *table, HTKeyValue_t newkeyvalue,
 
     return true;
   } else {
-    HTKeyValue_t *newpair_ptr = (HTKeyValue_t *)malloc(sizeof(HTKeyValue_t));
-    *newpair_ptr = newkeyvalue;
-    // we malloced space, but didnt copy that data in yet
-    LinkedList_Append(chain, (LLPayload_t)newpair_ptr);
-    // Must malloc new struct because it is sent as a copy as parameter
-    // Also, llpayload_t is a pointer!!!!!
+    // The pair lives inside the chain node itself, so this is the only
+    // allocation an insert makes.
+    HTChainNode *node = NewChainNode(table);
+    node->kv = newkeyvalue;
+#ifdef HT_CACHE_HASH
+    node->hash = BucketHash(table, newkeyvalue.key);
+#endif
+    node->link.payload = (LLPayload_t)&node->kv;
+    LLAppendNode(MaterializeChain(table, slot), &node->link);
+    if (bucket != INVALID_IDX) {
+      MarkOccupied(table, bucket);
+    }
 
     table->num_elements++;
     return false;
@@ -186,30 +628,32 @@ bool HashTable_Insert(HashTable *table, HTKeyValue_t newkeyvalue,
 }
 
 // Declared right above the insert function
-bool HashTable_FindKey(HashTable *table, HTKeyValue_t **oldpair_ptr,
-                       HTKey_t newkey, LinkedList *chain) {
-  LLIterator *iter = LLIterator_Allocate(chain);
-  HTKeyValue_t *payload;
-  // getting back HTKeyValue_t
-
-  while (LLIterator_IsValid(iter)) {
-    LLIterator_Get(iter, (LLPayload_t *)&payload);
-    // because get expects a pointer (llpayload is a pointer) and then
-    // derefernces that, we send it the casted version of the address
-    // of our payload
-
-    if (payload->key == newkey) {
-      // since payload was sent into get as a double pointer, we got the
-      // address of our new struct, so we can set the dereferenced double
-      // pointer to the address of our struct instead
-      *oldpair_ptr = payload;
-      LLIterator_Free(iter);
-      return true;
+static bool HashTable_FindKey(LinkedList *chain, HTKey_t newkey,
+                              LLIterator *iter, HTKeyValue_t **oldpair_ptr,
+                              int *num_probes) {
+  bool found = false;
+  int probes = 0;
+
+  LLIteratorInit(iter, chain);
+
+  // We step through the nodes directly rather than via LLIterator_Get and
+  // LLIterator_Next: every node is an HTChainNode, so its key sits right
+  // next to its link and costs no extra pointer chase.
+  while (iter->node != NULL) {
+    HTChainNode *node = (HTChainNode *)iter->node;
+
+    probes++;
+    if (node->kv.key == newkey) {
+      *oldpair_ptr = &node->kv;
+      found = true;
+      break;
     }
-    LLIterator_Next(iter);
+    iter->node = iter->node->next;
   }
-  LLIterator_Free(iter);
-  return false;
+  if (num_probes != NULL) {
+    *num_probes = probes;
+  }
+  return found;
 }
 
 // We wrote a helper function for insert, but it turns out that
@@ -219,12 +663,22 @@ bool HashTable_Find(HashTable *table, HTKey_t key, HTKeyValue_t *keyvalue) {
 
   // STEP 2: implement HashTable_Find.
 
+  int probes;
+
+  if (table->engine == HT_ENGINE_SWISS) {
+    bool found = SwissTable_Find(table->swiss, key, keyvalue, &probes);
+    CountFind(table, probes);
+    return found;
+  }
+
   // Moved over this code from insert with some slight changes
-  int bucket = HashKeyToBucketNum(table, key);
-  LinkedList *chain = table->buckets[bucket];
+  MigrateBuckets(table, HT_MIGRATE_BUCKETS_PER_OP);
+  LinkedList *chain = ChainForKey(table, key, NULL);
 
   HTKeyValue_t *temp = NULL;
-  bool toReturn = HashTable_FindKey(table, &temp, key, chain);
+  LLIterator iter;
+  bool toReturn = HashTable_FindKey(chain, key, &iter, &temp, &probes);
+  CountFind(table, probes);
   // as mentioned before, we send in a double pointer such that
   // when we set another dereferenced double pointer equal to this
   // dereferenced double pointer, we are just sending a address from temp
@@ -235,40 +689,198 @@ bool HashTable_Find(HashTable *table, HTKey_t key, HTKeyValue_t *keyvalue) {
   return toReturn;
 }
 
+int HashTable_InsertBatch(HashTable *table, const HTKeyValue_t *newkeyvalues,
+                          int count, HTKeyValue_t *oldkeyvalues,
+                          bool *replaced) {
+  HTKey_t keys[HT_BATCH_GROUP];
+  LinkedList **slots[HT_BATCH_GROUP];
+  int buckets[HT_BATCH_GROUP];
+  int i, j, n, num_replaced = 0;
+
+  Verify333(table != NULL);
+  Verify333(count >= 0);
+  for (i = 0; i < count; i += HT_BATCH_GROUP) {
+    n = (count - i < HT_BATCH_GROUP) ? count - i : HT_BATCH_GROUP;
+    for (j = 0; j < n; j++) {
+      keys[j] = newkeyvalues[i + j].key;
+    }
+
+    if (table->engine == HT_ENGINE_SWISS) {
+      PrefetchChains(table, keys, n, NULL, NULL);
+      for (j = i; j < i + n; j++) {
+        replaced[j] = HashTable_Insert(table, newkeyvalues[j],
+                                       &oldkeyvalues[j]);
+        num_replaced += replaced[j];
+      }
+      continue;
+    }
+
+    // Do the group's share of any migration, and any resize one of its
+    // inserts would trigger, up front, so that no chain moves while we
+    // resolve the group from the slots we prefetched.  (So the table may
+    // grow up to a group's worth of inserts sooner than it otherwise
+    // would.)
+    MigrateBuckets(table, n * HT_MIGRATE_BUCKETS_PER_OP);
+    while (table->num_elements + n - 1 >= table->resize_at) {
+      Resize(table, table->num_buckets * table->growth_factor);
+    }
+    PrefetchChains(table, keys, n, slots, buckets);
+
+    // Each insert re-reads its slot, since an earlier insert in the group
+    // may have given the bucket a chain of its own.
+    for (j = 0; j < n; j++) {
+      replaced[i + j] = InsertIntoChain(table, slots[j], buckets[j],
+                                        newkeyvalues[i + j],
+                                        &oldkeyvalues[i + j]);
+      num_replaced += replaced[i + j];
+    }
+  }
+  return num_replaced;
+}
+
+int HashTable_FindBatch(HashTable *table, const HTKey_t *keys, int count,
+                        HTKeyValue_t *keyvalues, bool *found) {
+  LinkedList **slots[HT_BATCH_GROUP];
+  int i, j, n, num_found = 0;
+
+  Verify333(table != NULL);
+  Verify333(count >= 0);
+  for (i = 0; i < count; i += HT_BATCH_GROUP) {
+    n = (count - i < HT_BATCH_GROUP) ? count - i : HT_BATCH_GROUP;
+
+    if (table->engine == HT_ENGINE_SWISS) {
+      PrefetchChains(table, keys + i, n, NULL, NULL);
+      for (j = i; j < i + n; j++) {
+        int probes;
+        found[j] = SwissTable_Find(table->swiss, keys[j], &keyvalues[j],
+                                   &probes);
+        CountFind(table, probes);
+        num_found += found[j];
+      }
+      continue;
+    }
+
+    // Do the group's share of any migration up front, so that no bucket
+    // moves while we resolve the group from the chains we prefetched.
+    MigrateBuckets(table, n * HT_MIGRATE_BUCKETS_PER_OP);
+    PrefetchChains(table, keys + i, n, slots, NULL);
+    for (j = 0; j < n; j++) {
+      LinkedList *chain = ChainInSlot(slots[j]);
+      HTKeyValue_t *pair;
+      LLIterator iter;
+      int probes;
+      found[i + j] = HashTable_FindKey(chain, keys[i + j], &iter, &pair,
+                                       &probes);
+      CountFind(table, probes);
+      if (found[i + j]) {
+        keyvalues[i + j] = *pair;
+        num_found++;
+      }
+    }
+  }
+  return num_found;
+}
+
+void HashTable_LookupStart(HashTable *table, HTKey_t key, HTLookup *lookup) {
+  Verify333(table != NULL);
+  Verify333(lookup != NULL);
+
+  lookup->table = table;
+  lookup->key = key;
+  lookup->probes = 0;
+  if (table->engine == HT_ENGINE_SWISS) {
+    SwissTable_Prefetch(table->swiss, key);
+    lookup->next = table->swiss;
+    lookup->stage = LOOKUP_SWISS;
+  } else {
+    lookup->next = ChainSlotForKey(table, key, NULL);
+    lookup->stage = LOOKUP_SLOT;
+  }
+  __builtin_prefetch(lookup->next);
+}
+
+HTLookupStatus_t HashTable_LookupStep(HTLookup *lookup,
+                                      HTKeyValue_t *keyvalue) {
+  const HTChainNode *node;
+
+  switch (lookup->stage) {
+    case LOOKUP_SWISS: {
+      int probes;
+      bool found = SwissTable_Find(lookup->table->swiss, lookup->key,
+                                   keyvalue, &probes);
+      CountFind(lookup->table, probes);
+      return found ? HT_LOOKUP_FOUND : HT_LOOKUP_MISSING;
+    }
+
+    case LOOKUP_SLOT:
+      lookup->next = ChainInSlot((LinkedList *const *)lookup->next);
+      lookup->stage = LOOKUP_CHAIN;
+      break;
+
+    case LOOKUP_CHAIN:
+      // The node's linkage comes first, so a node is its link.
+      lookup->next = ((const LinkedList *)lookup->next)->head;
+      lookup->stage = LOOKUP_NODE;
+      break;
+
+    default:
+      Verify333(lookup->stage == LOOKUP_NODE);
+      node = (const HTChainNode *)lookup->next;
+      lookup->probes++;
+      if (node->kv.key == lookup->key) {
+        *keyvalue = node->kv;
+        CountFind(lookup->table, lookup->probes);
+        return HT_LOOKUP_FOUND;
+      }
+      lookup->next = node->link.next;
+      break;
+  }
+
+  if (lookup->next == NULL) {
+    CountFind(lookup->table, lookup->probes);
+    return HT_LOOKUP_MISSING;
+  }
+  __builtin_prefetch(lookup->next);
+  return HT_LOOKUP_PENDING;
+}
+
 bool HashTable_Remove(HashTable *table, HTKey_t key, HTKeyValue_t *keyvalue) {
+  return RemoveKey(table, key, keyvalue, true);
+}
+
+static bool RemoveKey(HashTable *table, HTKey_t key, HTKeyValue_t *keyvalue,
+                      bool may_shrink) {
   Verify333(table != NULL);
 
   // STEP 3: implement HashTable_Remove.
 
-  int bucket = HashKeyToBucketNum(table, key);
-  LinkedList *chain = table->buckets[bucket];
+  if (table->engine == HT_ENGINE_SWISS) {
+    bool removed = SwissTable_Remove(table->swiss, key, keyvalue);
+    table->num_elements = table->swiss->num_elements;
+    return removed;
+  }
+
+  MigrateBuckets(table, HT_MIGRATE_BUCKETS_PER_OP);
+  int bucket;
+  LinkedList *chain = ChainForKey(table, key, &bucket);
   HTKeyValue_t *temp;
+  LLIterator iter;
   // similar reasoning as in find
-  if (HashTable_FindKey(table, &temp, key, chain)) {
-    LLIterator *iter = LLIterator_Allocate(chain);
-    HTKeyValue_t *tempValue;
-    // we need ANOTHER temp as the first one was an output parameter
-    // do not want to override out value of keyvalue
-
-    while (LLIterator_IsValid(iter)) {
-      LLIterator_Get(iter, (LLPayload_t *)&tempValue);
-      // through output parameters, will put value in tempValue output
-      // double pointer
-
-      if (tempValue->key == key) {
-        LLIterator_Remove(iter, LLNoOpFree);
-        break;
-      }
-
-      LLIterator_Next(iter);
-    }
-    // Actually copy over from temp structure into temp
+  if (HashTable_FindKey(chain, key, &iter, &temp, NULL)) {
+    // Actually copy over from temp structure into keyvalue.  This must
+    // happen before the unlink, since the pair lives inside the node it
+    // frees.  FindKey left the iterator on that node, so there's no need
+    // for a second walk down the chain.
     *keyvalue = *temp;
-    LLIterator_Free(iter);
-    free(tempValue);
-    // must be free iterator too because we used it specially to help
+    LLIterator_Remove(&iter, LLNoOpFree);
+    if (bucket != INVALID_IDX && LinkedList_NumElements(chain) == 0) {
+      MarkEmpty(table, bucket);
+    }
 
     table->num_elements--;
+    if (may_shrink) {
+      MaybeShrink(table);
+    }
     return true;
 
   } else {
@@ -276,47 +888,205 @@ bool HashTable_Remove(HashTable *table, HTKey_t key, HTKeyValue_t *keyvalue) {
   }
 }
 
+void HashTable_Compact(HashTable *table) {
+  LinkedList **old_buckets;
+  MemPool *old_pool, *pool;
+  int old_num_buckets, num_buckets, i;
+  uint64_t start;
+
+  Verify333(table != NULL);
+  start = NowNanos();
+
+  if (table->engine == HT_ENGINE_SWISS) {
+    if (SwissTable_Compact(table->swiss)) {
+      table->num_resizes++;
+      table->num_buckets = table->swiss->capacity;
+      table->resize_nanos += NowNanos() - start;
+    }
+    return;
+  }
+
+  // Only then does every chain hang off the one bucket array.
+  MigrateBuckets(table, table->old_num_buckets);
+  old_buckets = table->buckets;
+  old_num_buckets = table->num_buckets;
+  old_pool = table->node_pool;
+  num_buckets = FittedNumBuckets(table);
+  if (num_buckets > old_num_buckets) {
+    num_buckets = old_num_buckets;
+  }
+
+  // First relink every node into the new chains, as a resize would (unless
+  // the bucket array is already the right size)...
+  if (num_buckets != old_num_buckets) {
+    table->num_resizes++;
+    table->num_buckets = num_buckets;
+    table->buckets = AllocateBuckets(num_buckets);
+    free(table->occupied);
+    table->occupied = AllocateBitmap(num_buckets);
+    UpdateThresholds(table);
+    for (i = 0; i < old_num_buckets; i++) {
+      LinkedList *old_chain = ChainInSlot(&old_buckets[i]);
+      while (LinkedList_NumElements(old_chain) > 0) {
+        HTChainNode *node = (HTChainNode *)old_chain->head;
+#ifdef HT_CACHE_HASH
+        int bucket = HashToBucketNum(table, num_buckets, node->hash);
+#else
+        int bucket = HashKeyToBucketNum(table, node->kv.key);
+#endif
+        Verify333(LLMoveHeadToTail(old_chain,
+                                   MaterializeChain(table,
+                                                    &table->buckets[bucket])));
+        MarkOccupied(table, bucket);
+      }
+      if (old_chain != &kEmptyChain) {
+        LinkedList_Free(old_chain, LLNoOpFree);
+      }
+    }
+    free(old_buckets);
+  }
+
+  // ...then copy the nodes into a fresh pool in chain order, so that each
+  // chain, and each run of neighbouring chains, is contiguous.  Each chain
+  // switches over to the new pool once its nodes are all in it.
+  pool = MemPool_Allocate(sizeof(HTChainNode));
+  for (i = 0; i < num_buckets; i++) {
+    LinkedList *chain = table->buckets[i];
+    LinkedListNode *ln, *prev = NULL;
+
+    if (chain == NULL) {
+      continue;
+    }
+
+    ln = chain->head;
+    while (ln != NULL) {
+      LinkedListNode *next = ln->next;
+      HTChainNode *node = (HTChainNode *)MemPool_AllocObject(pool);
+
+      *node = *(HTChainNode *)ln;
+      node->link.payload = (LLPayload_t)&node->kv;
+      node->link.prev = prev;
+      node->link.next = NULL;
+      if (prev != NULL) {
+        prev->next = &node->link;
+      } else {
+        chain->head = &node->link;
+      }
+      prev = &node->link;
+
+      // A pooled node goes when its whole pool does.
+      if (old_pool == NULL) {
+        free(ln);
+      }
+      ln = next;
+    }
+    chain->tail = prev;
+    chain->pool = pool;
+  }
+  table->node_pool = pool;
+  if (old_pool != NULL) {
+    MemPool_Free(old_pool);
+  }
+  table->resize_nanos += NowNanos() - start;
+}
+
+void HashTable_GetStats(HashTable *table, HTStats *stats) {
+  int i, len;
+
+  Verify333(table != NULL);
+  Verify333(stats != NULL);
+
+  memset(stats, 0, sizeof(HTStats));
+  stats->num_elements = table->num_elements;
+  stats->num_buckets = table->num_buckets;
+  stats->load_factor = (double)table->num_elements / table->num_buckets;
+  stats->num_resizes = table->num_resizes;
+  stats->resize_seconds = table->resize_nanos / 1e9;
+  stats->num_finds = table->num_finds;
+  if (table->num_finds > 0) {
+    stats->avg_probes_per_find =
+        (double)table->num_probes / table->num_finds;
+  }
+
+  if (table->engine == HT_ENGINE_SWISS) {
+    // Measure each entry's probe sequence by looking it up again.
+    stats->empty_buckets = table->swiss->capacity - table->num_elements;
+    for (i = SwissTable_NextFull(table->swiss, 0); i != INVALID_IDX;
+         i = SwissTable_NextFull(table->swiss, i + 1)) {
+      len = SwissTable_ProbeLength(table->swiss,
+                                   table->swiss->slots[i].key);
+      stats->max_chain_length = (len > stats->max_chain_length) ?
+          len : stats->max_chain_length;
+      stats->chain_length_histogram[(len < HT_STATS_HISTOGRAM_BINS) ?
+                                    len : HT_STATS_HISTOGRAM_BINS - 1]++;
+    }
+    return;
+  }
+
+  // Only then does every chain hang off the one bucket array.
+  MigrateBuckets(table, table->old_num_buckets);
+  for (i = 0; i < table->num_buckets; i++) {
+    len = LinkedList_NumElements(ChainInSlot(&table->buckets[i]));
+    if (len == 0) {
+      stats->empty_buckets++;
+    }
+    stats->max_chain_length = (len > stats->max_chain_length) ?
+        len : stats->max_chain_length;
+    stats->chain_length_histogram[(len < HT_STATS_HISTOGRAM_BINS) ?
+                                  len : HT_STATS_HISTOGRAM_BINS - 1]++;
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // HTIterator implementation.
 
 HTIterator *HTIterator_Allocate(HashTable *table) {
   HTIterator *iter;
-  int i;
 
   Verify333(table != NULL);
 
   iter = (HTIterator *)malloc(sizeof(HTIterator));
   Verify333(iter != NULL);
+  iter->next_table = NULL;
+  iter->tables = NULL;
+  iter->table_idx = 0;
+  HTIteratorInit(iter, table);
+  return iter;
+}
 
+static void HTIteratorInit(HTIterator *iter, HashTable *table) {
   // If the hash table is empty, the iterator is immediately invalid,
   // since it can't point to anything.
   if (table->num_elements == 0) {
     iter->ht = table;
     iter->bucket_it = NULL;
     iter->bucket_idx = INVALID_IDX;
-    return iter;
+    return;
   }
 
   // Initialize the iterator.  There is at least one element in the
   // table, so find the first element and point the iterator at it.
   iter->ht = table;
-  for (i = 0; i < table->num_buckets; i++) {
-    if (LinkedList_NumElements(table->buckets[i]) > 0) {
-      iter->bucket_idx = i;
-      break;
-    }
+
+  // Iterators only understand a single bucket array, so finish any
+  // in-progress resize first.  Iterating is O(n) anyway.
+  MigrateBuckets(table, table->old_num_buckets);
+  if (table->engine == HT_ENGINE_SWISS) {
+    iter->bucket_it = NULL;
+    iter->bucket_idx = SwissTable_NextFull(table->swiss, 0);
+    Verify333(iter->bucket_idx != INVALID_IDX);  // make sure we found it.
+    return;
   }
-  Verify333(i < table->num_buckets);  // make sure we found it.
-  iter->bucket_it = LLIterator_Allocate(table->buckets[iter->bucket_idx]);
-  return iter;
+  iter->bucket_idx = NextOccupied(table, 0);
+  Verify333(iter->bucket_idx != INVALID_IDX);  // make sure we found it.
+  iter->bucket_it = &iter->bucket_storage;
+  LLIteratorInit(iter->bucket_it,
+                 ChainInSlot(&table->buckets[iter->bucket_idx]));
 }
 
 void HTIterator_Free(HTIterator *iter) {
   Verify333(iter != NULL);
-  if (iter->bucket_it != NULL) {
-    LLIterator_Free(iter->bucket_it);
-    iter->bucket_it = NULL;
-  }
+  // bucket_it (if any) points into the iterator itself.
   free(iter);
 }
 
@@ -325,6 +1095,10 @@ bool HTIterator_IsValid(HTIterator *iter) {
 
   // STEP 4: implement HTIterator_IsValid.
 
+  if (iter->ht->engine == HT_ENGINE_SWISS) {
+    return iter->bucket_idx != INVALID_IDX && iter->ht->num_elements != 0;
+  }
+
   if (iter->bucket_it == NULL || iter->bucket_idx == INVALID_IDX ||
       iter->ht->num_elements == 0) {
     return false;
@@ -343,9 +1117,37 @@ bool HTIterator_IsValid(HTIterator *iter) {
 bool HTIterator_Next(HTIterator *iter) {
   Verify333(iter != NULL);
 
+  if (NextInTable(iter)) {
+    return true;
+  }
+  // Out of elements in this table; move on to the next non-empty one, if
+  // the iterator walks several.
+  while (iter->next_table != NULL) {
+    HashTable *next = iter->next_table(iter);
+    if (next == NULL) {
+      return false;
+    }
+    if (next->num_elements > 0) {
+      HTIteratorInit(iter, next);
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool NextInTable(HTIterator *iter) {
   // STEP 5: implement HTIterator_Next.
 
-  if (!LLIterator_IsValid(iter->bucket_it)) {
+  if (iter->ht->engine == HT_ENGINE_SWISS) {
+    if (iter->bucket_idx == INVALID_IDX) {
+      return false;
+    }
+    iter->bucket_idx = SwissTable_NextFull(iter->ht->swiss,
+                                           iter->bucket_idx + 1);
+    return iter->bucket_idx != INVALID_IDX;
+  }
+
+  if (iter->bucket_it == NULL || !LLIterator_IsValid(iter->bucket_it)) {
     return false;
   }
 
@@ -354,22 +1156,17 @@ bool HTIterator_Next(HTIterator *iter) {
 
   // Will exit when we do find a valid next or the table ends
   if (!LLIterator_IsValid(iter->bucket_it)) {
-    iter->bucket_idx += 1;
-    // Increment bucket index to check the next bucket.
-
-    // Keep advancing until we find a non-empty bucket or run out of buckets.
-    while (iter->bucket_idx < iter->ht->num_buckets &&
-           LinkedList_NumElements(iter->ht->buckets[iter->bucket_idx]) == 0) {
-      iter->bucket_idx += 1;
-    }
-
-    if (iter->bucket_idx == iter->ht->num_buckets) {
+    // Jump straight to the next non-empty bucket, if there is one; the
+    // bitmap saves us from looking at each empty bucket's chain.
+    iter->bucket_idx = NextOccupied(iter->ht, iter->bucket_idx + 1);
+    if (iter->bucket_idx == INVALID_IDX) {
+      iter->bucket_idx = iter->ht->num_buckets;
       return false;
     }
-    // If we find a non-empty bucket, free the old iterator for the old chain
-    LLIterator_Free(iter->bucket_it);
-
-    iter->bucket_it = LLIterator_Allocate(iter->ht->buckets[iter->bucket_idx]);
+    // If we find a non-empty bucket, point the chain iterator at it; the
+    // iterator's storage is reused, so there's nothing to free.
+    LLIteratorInit(iter->bucket_it,
+                   ChainInSlot(&iter->ht->buckets[iter->bucket_idx]));
 
     // Like the malloc null checks
     if (!LLIterator_IsValid(iter->bucket_it)) {
@@ -390,6 +1187,11 @@ bool HTIterator_Get(HTIterator *iter, HTKeyValue_t *keyvalue) {
     return false;
   }
 
+  if (iter->ht->engine == HT_ENGINE_SWISS) {
+    *keyvalue = iter->ht->swiss->slots[iter->bucket_idx];
+    return true;
+  }
+
   LLIterator_Get(iter->bucket_it, (LLPayload_t *)&payload);
   // As mentioned before:
   // because get expects a pointer (llpayload is a pointer) and then
@@ -402,9 +1204,11 @@ bool HTIterator_Get(HTIterator *iter, HTKeyValue_t *keyvalue) {
 }
 
 bool HTIterator_Remove(HTIterator *iter, HTKeyValue_t *keyvalue) {
+  HashTable *ht;
   HTKeyValue_t kv;
 
   Verify333(iter != NULL);
+  ht = iter->ht;  // HTIterator_Next may move the iterator to another table
 
   // Try to get what the iterator is pointing to.
   if (!HTIterator_Get(iter, &kv)) {
@@ -418,7 +1222,7 @@ bool HTIterator_Remove(HTIterator *iter, HTKeyValue_t *keyvalue) {
 
   // Lastly, remove the element.  Again, we know this call will succeed
   // due to the successful HTIterator_Get above.
-  Verify333(HashTable_Remove(iter->ht, kv.key, keyvalue));
+  Verify333(RemoveKey(ht, kv.key, keyvalue, false));
   Verify333(kv.key == keyvalue->key);
   Verify333(kv.value == keyvalue->value);
 
@@ -426,36 +1230,295 @@ bool HTIterator_Remove(HTIterator *iter, HTKeyValue_t *keyvalue) {
 }
 
 static void MaybeResize(HashTable *ht) {
-  HashTable *newht;
-  HashTable tmp;
-  HTIterator *it;
-
-  // Resize if the load factor is > 3.
-  if (ht->num_elements < 3 * ht->num_buckets) return;
-
-  // This is the resize case.  Allocate a new hashtable,
-  // iterate over the old hashtable, do the surgery on
-  // the old hashtable record and free up the new hashtable
-  // record.
-  newht = HashTable_Allocate(ht->num_buckets * 9);
-
-  // Loop through the old ht copying its elements over into the new one.
-  for (it = HTIterator_Allocate(ht); HTIterator_IsValid(it);
-       HTIterator_Next(it)) {
-    HTKeyValue_t item, unused;
-
-    Verify333(HTIterator_Get(it, &item));
-    HashTable_Insert(newht, item, &unused);
-  }
-
-  // Swap the new table onto the old, then free the old table (tricky!).  We
-  // use the "no-op free" because we don't actually want to free the elements;
-  // they're owned by the new table.
-  tmp = *ht;
-  *ht = *newht;
-  *newht = tmp;
-
-  // Done!  Clean up our iterator and temporary table.
-  HTIterator_Free(it);
-  HashTable_Free(newht, &HTNoOpFree);
+  // Resize if the load factor has reached max_load_factor.
+  if (ht->num_elements < ht->resize_at) return;
+  Resize(ht, ht->num_buckets * ht->growth_factor);
+}
+
+static void MaybeShrink(HashTable *ht) {
+  int num_buckets;
+
+  // shrink_at is zero unless the table has a min_load_factor.
+  if (ht->num_elements >= ht->shrink_at) return;
+  num_buckets = FittedNumBuckets(ht);
+  if (num_buckets < ht->num_buckets) {
+    Resize(ht, num_buckets);
+  }
+}
+
+static int FittedNumBuckets(HashTable *ht) {
+  int num_buckets = CeilToInt(ht->num_elements * (double)ht->growth_factor /
+                              ht->max_load_factor);
+
+  if (ht->pow2_buckets) {
+    num_buckets = RoundUpPow2(num_buckets);
+  }
+  return (num_buckets < ht->min_buckets) ? ht->min_buckets : num_buckets;
+}
+
+static void Resize(HashTable *ht, int new_num_buckets) {
+  uint64_t start;
+
+  // We never start a resize while another is still migrating.
+  MigrateBuckets(ht, ht->old_num_buckets);
+
+  // Park the current buckets as the old array and allocate a fresh one;
+  // MigrateBuckets then relinks the existing chain nodes into it without
+  // reallocating any of them.
+  ht->old_buckets = ht->buckets;
+  ht->old_num_buckets = ht->num_buckets;
+  ht->migrate_idx = 0;
+  ht->num_buckets = new_num_buckets;
+  UpdateThresholds(ht);
+  start = NowNanos();
+  ht->buckets = AllocateBuckets(ht->num_buckets);
+  free(ht->occupied);
+  ht->occupied = AllocateBitmap(ht->num_buckets);
+  ht->num_resizes++;
+  ht->resize_nanos += NowNanos() - start;
+
+  // A stop-the-world table finishes the whole migration right now.
+  if (!ht->incremental_resize) {
+    MigrateBuckets(ht, ht->old_num_buckets);
+  }
+}
+
+static void UpdateThresholds(HashTable *ht) {
+  int threshold = CeilToInt(ht->max_load_factor * ht->num_buckets);
+
+  // A tiny load factor still lets every table hold one element.
+  ht->resize_at = (threshold < 1) ? 1 : threshold;
+
+  // This rounds down, and min_load_factor is below the load factor a
+  // shrink leaves, so a table doesn't shrink twice in a row.
+  ht->shrink_at = (int)(ht->min_load_factor * ht->num_buckets);
+}
+
+static int CeilToInt(double x) {
+  int n;
+
+  if (x >= INT_MAX) {
+    return INT_MAX;
+  }
+  n = (int)x;
+  return (n < x) ? n + 1 : n;
+}
+
+static int RoundUpPow2(int n) {
+  int pow2 = 1;
+  while (pow2 < n) {
+    pow2 *= 2;
+  }
+  return pow2;
+}
+
+static void MigrateBuckets(HashTable *ht, int max_buckets) {
+  uint64_t start = 0;
+  int end;
+
+  if (ht->old_buckets == NULL) return;
+  if (TimeMigrations(ht)) {
+    start = NowNanos();
+  }
+
+  end = ht->migrate_idx + max_buckets;
+  if (end > ht->old_num_buckets) {
+    end = ht->old_num_buckets;
+  }
+
+  while (ht->migrate_idx < end) {
+    LinkedList *old_chain = ChainInSlot(&ht->old_buckets[ht->migrate_idx]);
+
+    while (LinkedList_NumElements(old_chain) > 0) {
+      HTChainNode *node = (HTChainNode *)old_chain->head;
+#ifdef HT_CACHE_HASH
+      int bucket = HashToBucketNum(ht, ht->num_buckets, node->hash);
+#else
+      int bucket = HashKeyToBucketNum(ht, node->kv.key);
+#endif
+      Verify333(LLMoveHeadToTail(old_chain,
+                                 MaterializeChain(ht, &ht->buckets[bucket])));
+      MarkOccupied(ht, bucket);
+    }
+    if (old_chain != &kEmptyChain) {
+      LinkedList_Free(old_chain, LLNoOpFree);
+    }
+    ht->migrate_idx++;
+  }
+  if (TimeMigrations(ht)) {
+    ht->resize_nanos += NowNanos() - start;
+  }
+
+  if (ht->migrate_idx == ht->old_num_buckets) {
+    free(ht->old_buckets);
+    ht->old_buckets = NULL;
+    ht->old_num_buckets = 0;
+    ht->migrate_idx = 0;
+  }
+}
+
+static LinkedList **ChainSlotForKey(HashTable *ht, HTKey_t key,
+                                    int *bucket) {
+  int new_bucket;
+
+  if (ht->old_buckets != NULL) {
+    int old_bucket = HashToBucketNum(ht, ht->old_num_buckets,
+                                     BucketHash(ht, key));
+    if (old_bucket >= ht->migrate_idx) {
+      // Not migrated yet, so the key is (or belongs) in the old array.
+      if (bucket != NULL) {
+        *bucket = INVALID_IDX;
+      }
+      return &ht->old_buckets[old_bucket];
+    }
+  }
+  new_bucket = HashKeyToBucketNum(ht, key);
+  if (bucket != NULL) {
+    *bucket = new_bucket;
+  }
+  return &ht->buckets[new_bucket];
+}
+
+static LinkedList *ChainForKey(HashTable *ht, HTKey_t key, int *bucket) {
+  return ChainInSlot(ChainSlotForKey(ht, key, bucket));
+}
+
+static uint64_t *AllocateBitmap(int num_buckets) {
+  uint64_t *bitmap = (uint64_t *)calloc((num_buckets + 63) / 64,
+                                        sizeof(uint64_t));
+  Verify333(bitmap != NULL);
+  return bitmap;
+}
+
+static int NextOccupied(HashTable *ht, int start) {
+  int word = start >> 6;
+  int num_words = (ht->num_buckets + 63) / 64;
+  uint64_t bits;
+
+  if (start >= ht->num_buckets) {
+    return INVALID_IDX;
+  }
+
+  // Ignore buckets before "start" in the first word we look at.  Bits past
+  // num_buckets are never set, so we needn't mask off the last word.
+  bits = ht->occupied[word] & (~0ULL << (start & 63));
+  while (bits == 0) {
+    if (++word == num_words) {
+      return INVALID_IDX;
+    }
+    bits = ht->occupied[word];
+  }
+  return word * 64 + __builtin_ctzll(bits);
+}
+
+static void PrefetchChains(HashTable *ht, const HTKey_t *keys, int n,
+                           LinkedList ***slots, int *buckets) {
+  LinkedListNode *nodes[HT_BATCH_GROUP];
+  int i, depth;
+
+  if (ht->engine == HT_ENGINE_SWISS) {
+    for (i = 0; i < n; i++) {
+      SwissTable_Prefetch(ht->swiss, keys[i]);
+    }
+    return;
+  }
+
+  // Each stage loads what the previous stage prefetched.  The first load
+  // of a stage may still stall, but by then the rest of the group's
+  // misses are in flight alongside it.
+  for (i = 0; i < n; i++) {
+    slots[i] = ChainSlotForKey(ht, keys[i],
+                               (buckets != NULL) ? &buckets[i] : NULL);
+    __builtin_prefetch(slots[i]);
+  }
+  for (i = 0; i < n; i++) {
+    __builtin_prefetch(*slots[i]);
+  }
+  for (i = 0; i < n; i++) {
+    nodes[i] = ChainInSlot(slots[i])->head;
+    __builtin_prefetch(nodes[i]);
+  }
+  for (depth = 1; depth < HT_BATCH_PREFETCH_NODES; depth++) {
+    for (i = 0; i < n; i++) {
+      if (nodes[i] != NULL) {
+        nodes[i] = nodes[i]->next;
+        __builtin_prefetch(nodes[i]);
+      }
+    }
+  }
+}
+
+static LinkedList **AllocateBuckets(int num_buckets) {
+  LinkedList **buckets;
+
+  buckets = (LinkedList **)calloc(num_buckets, sizeof(LinkedList *));
+  Verify333(buckets != NULL);
+  return buckets;
+}
+
+static inline LinkedList *ChainInSlot(LinkedList *const *slot) {
+  return (*slot != NULL) ? *slot : &kEmptyChain;
+}
+
+static LinkedList *MaterializeChain(HashTable *ht, LinkedList **slot) {
+  if (*slot == NULL) {
+    if (ht->node_pool != NULL) {
+      *slot = LLAllocateWithPool(ht->node_pool);
+    } else {
+      *slot = LinkedList_Allocate();
+    }
+  }
+  return *slot;
+}
+
+static void FreeBuckets(HashTable *ht, LinkedList **buckets, int first,
+                        int last, ValueFreeFnPtr value_free_function) {
+  int i;
+
+  for (i = first; i < last; i++) {
+    LinkedList *bucket = buckets[i];
+    LinkedListNode *ln;
+
+    if (bucket == NULL) {
+      continue;
+    }
+
+    // We can't just pass value_free_function to LinkedList_Free, since it
+    // takes a HTValue_t rather than an LLPayload_t; instead, free the values
+    // ourselves and then let the list free the (pair-embedding) nodes.
+    if (value_free_function != NULL) {
+      for (ln = bucket->head; ln != NULL; ln = ln->next) {
+        value_free_function(((HTChainNode *)ln)->kv.value);
+      }
+    }
+
+    if (ht->node_pool != NULL) {
+      // The nodes live in the table's pool, which the caller releases
+      // wholesale, so we don't visit them again.
+      LLFreeShell(bucket);
+    } else {
+      LinkedList_Free(bucket, NULL);
+    }
+  }
+
+  // Free the bucket array itself.
+  free(buckets);
+}
+
+static HTChainNode *NewChainNode(HashTable *ht) {
+  HTChainNode *node;
+  if (ht->node_pool != NULL) {
+    node = (HTChainNode *)MemPool_AllocObject(ht->node_pool);
+  } else {
+    node = (HTChainNode *)malloc(sizeof(HTChainNode));
+  }
+  Verify333(node != NULL);
+  return node;
+}
+
+static inline void CountFind(HashTable *ht, int num_probes) {
+  if (ht->collect_stats) {
+    ht->num_finds++;
+    ht->num_probes += num_probes;
+  }
 }
@@ -30,6 +30,9 @@
 // will start to grow.  This implementation will dynamically resize the
 // hashtable when the load factor exceeds 3.  It will multiple the number
 // of buckets in the hashtable by 9, so that post-resize load factor is 1/3.
+// (That describes the default policy of the default chained engine; see
+// HTOptions below for changing the policy, HashTable_Reserve for avoiding
+// resizes altogether, and HTEngine_t for the open-addressing alternative.)
 //
 // To hide the implementation of HashTable, we declare the "struct ht"
 // structure and its associated typedef here, but we *define* the structure
@@ -76,6 +79,105 @@ typedef void(*ValueFreeFnPtr)(HTValue_t value);
 //   use in a HTKeyValue_t.
 HTKey_t FNVHash64(unsigned char *buffer, int len);
 
+// Batched FNV hash.
+//
+// FNV is one long dependency chain (each byte's multiply waits on the last
+// one), so hashing one buffer at a time leaves most of the CPU idle.  This
+// hashes several buffers in lockstep so that their chains overlap.  The
+// results are identical to calling FNVHash64 on each buffer in turn.
+//
+// Arguments:
+// - buffers: an array of count pointers to buffers of unsigned chars.
+// - lens: an array of count buffer lengths; lens[i] is the length of
+//   buffers[i], and MUST be non-negative.
+// - count: how many buffers there are.
+// - hashes: an array of count keys; on return, hashes[i] holds
+//   FNVHash64(buffers[i], lens[i]).
+void FNVHash64_Batch(unsigned char **buffers, const int *lens, int count,
+                     HTKey_t *hashes);
+
+// Wide-word hash implementation.
+//
+// A faster alternative to FNVHash64 in the style of wyhash: it consumes the
+// buffer eight bytes at a time and mixes with 64x64->128-bit multiplies, so
+// it does far less work per byte and every input bit affects every output
+// bit.  Its values differ from FNVHash64's, so a given table must use one
+// hash function consistently.
+//
+// Arguments:
+// - buffer: a pointer to a len-size buffer of unsigned chars.
+// - len: how many bytes are in the buffer.
+//
+// Returns:
+// - a nicely distributed 64-bit hash value suitable for
+//   use in a HTKeyValue_t.
+HTKey_t WideHash64(unsigned char *buffer, int len);
+
+
+// The storage engines a HashTable can be built on.  Every engine supports
+// the full HashTable and HTIterator interface below; they differ only in
+// memory layout and performance.
+typedef enum {
+  // The default: an array of buckets, each a linked list of (key,value)
+  // pairs.  Resizes as described at the top of this file.
+  HT_ENGINE_CHAINED = 0,
+
+  // Open addressing ("Swiss table"): the (key,value) pairs are stored
+  // inline in a flat slot array, and a parallel array of one-byte control
+  // tags is probed a group at a time with SIMD compares.  A lookup
+  // typically touches one or two cache lines.  num_buckets is interpreted
+  // as the initial number of slots; the table doubles when 7/8 full.
+  HT_ENGINE_SWISS,
+} HTEngine_t;
+
+// Options for HashTable_AllocateWithOptions.  A zero-initialized HTOptions
+// requests the defaults (ie, the same table HashTable_Allocate returns).
+typedef struct {
+  HTEngine_t engine;    // which storage engine backs the table
+
+  // Chained engine only.  If true, a resize allocates the larger bucket
+  // array and then migrates a few old buckets per Insert/Find/Remove,
+  // instead of rehashing every element inside the Insert that triggered
+  // it.  Lookups consult whichever array currently holds the key.
+  bool incremental_resize;
+
+  // Chained engine only.  If true, the table's chain nodes are carved out
+  // of a per-table slab (see MemPool.h) instead of being malloc'd one at a
+  // time, and HashTable_Free releases them all at once.
+  bool use_pool;
+
+  // Chained engine only.  If true, the bucket count is always a power of
+  // two (num_buckets is rounded up, and resizes grow 8x rather than 9x).
+  // Keys are put through a fast 64-bit mixer and the bucket is chosen with
+  // a mask instead of a 64-bit division, which is both cheaper and robust
+  // against sequential or stride-aligned keys.
+  bool pow2_buckets;
+
+  // If true, the table counts the probes made by every Find, so that
+  // HashTable_GetStats can report the average.  A table without it pays
+  // nothing for the statistics beyond the cost of GetStats itself.
+  bool collect_stats;
+
+  // Chained engine only.  The growth policy: the table grows once it holds
+  // max_load_factor elements per bucket, multiplying its bucket count by
+  // growth_factor.  A lower load factor buys shorter chains with memory; a
+  // lower growth factor leaves less of the bucket array unused after a
+  // resize, at the cost of resizing more often.  Zero selects the
+  // defaults, 3 and 9 (8 for a pow2_buckets table, whose growth factor is
+  // always rounded up to a power of two).  If nonzero, max_load_factor
+  // MUST be positive and growth_factor MUST be at least 2.
+  double max_load_factor;
+  int growth_factor;
+
+  // Chained engine only.  If positive, a Remove that leaves fewer than
+  // min_load_factor elements per bucket shrinks the table back to the
+  // load factor a resize would have left it at (max_load_factor /
+  // growth_factor), though never below the number of buckets it was
+  // allocated with.  It MUST be less than that post-resize load factor,
+  // so that the table can't flip-flop between growing and shrinking.
+  // Zero (the default) never shrinks.
+  double min_load_factor;
+} HTOptions;
 
 // Allocate and return a new HashTable.
 //
@@ -86,6 +188,56 @@ HTKey_t FNVHash64(unsigned char *buffer, int len);
 // Returns a pointer to the newly allocated HashTable.
 HashTable* HashTable_Allocate(int num_buckets);
 
+// Allocate and return a new HashTable configured by "options".
+//
+// Arguments:
+// - num_buckets: the number of buckets the hash table should
+//   initially contain; MUST be greater than zero.
+// - options: the table's configuration, or NULL for the defaults.
+//
+// Returns a pointer to the newly allocated HashTable.
+HashTable* HashTable_AllocateWithOptions(int num_buckets,
+                                         const HTOptions *options);
+
+// Presizes a HashTable so that it can hold num_elements elements without
+// resizing again.
+//
+// Use this before a bulk load: growing one step at a time rehashes every
+// element at each step, and can leave the bucket array up to
+// growth_factor times larger than it needs to be.  If the table is
+// already large enough, this does nothing; it never shrinks a table.
+//
+// Arguments:
+// - table: the HashTable to presize.
+// - num_elements: the number of elements the table should have room for;
+//   MUST be non-negative.
+void HashTable_Reserve(HashTable *table, int num_elements);
+
+// Shrinks a HashTable to fit its current contents and repacks them.
+//
+// After a mass removal, the bucket array is left sized for the table's
+// peak, and the surviving entries are scattered across memory.  This
+// shrinks the bucket array (as for HTOptions.min_load_factor, but
+// regardless of that setting) and then copies every entry of a chained
+// table into a fresh slab, a chain at a time, so that each chain's nodes
+// are contiguous.  Note that this makes a malloc-backed table pooled:
+// afterwards it allocates its nodes from that slab, as though it had been
+// allocated with use_pool.  For a swiss table, this rehashes into the
+// smallest capacity that is at most half full, dropping any tombstones.
+//
+// If the bucket array is already the size that fits, as it usually is
+// once removals have shrunk the table, the array is left alone and this
+// isn't counted in HTStats.num_resizes, but a chained table's entries are
+// still repacked.  A swiss table of the right capacity with no tombstones
+// is left alone entirely.
+//
+// This visits every entry, so it costs about as much as a resize.  Any
+// existing iterators become undefined.
+//
+// Arguments:
+// - table: the HashTable to compact.
+void HashTable_Compact(HashTable *table);
+
 // Free a HashTable and its entries.
 //
 // Arguments:
@@ -93,7 +245,9 @@ HashTable* HashTable_Allocate(int num_buckets);
 //   after this function returns.
 //
 // - value_free_function:  this argument is a pointer to a value
-//   freeing function; see above for details.
+//   freeing function; see above for details.  May be NULL if the values
+//   don't need freeing, in which case a pooled table is freed without
+//   visiting any of its entries.
 void HashTable_Free(HashTable *table, ValueFreeFnPtr value_free_function);
 
 // Figure out the number of elements in the hash table.
@@ -148,6 +302,91 @@ bool HashTable_Find(HashTable *table,
                     HTKey_t key,
                     HTKeyValue_t *keyvalue);
 
+// Batched versions of HashTable_Insert and HashTable_Find.
+//
+// A lookup in a table much larger than the cache stalls on a cache miss
+// at every step: the bucket array, the chain, each chain node.  These
+// work through their arrays a group at a time: they find every
+// operation's bucket once, prefetch its chain a node at a time across the
+// whole group, and then resolve the operations against those chains, so a
+// group's misses overlap instead of following one another.  The results
+// are exactly those of calling HashTable_Insert or HashTable_Find on each
+// element in order, though InsertBatch may resize the table up to a
+// group's worth of inserts early.
+//
+// Arguments:
+// - table: the HashTable to insert into / look in.
+// - newkeyvalues / keys: an array of count pairs to insert, or keys to
+//   look up.
+// - count: the number of elements in the arrays.
+// - oldkeyvalues / keyvalues: arrays of count elements; element i
+//   receives the result that HashTable_Insert's oldkeyvalue or
+//   HashTable_Find's keyvalue would for element i.
+// - replaced / found: arrays of count elements; element i receives what
+//   HashTable_Insert or HashTable_Find would return for element i.
+//
+// Returns:
+// - the number of elements for which replaced[i] / found[i] is true.
+int HashTable_InsertBatch(HashTable *table,
+                          const HTKeyValue_t *newkeyvalues,
+                          int count,
+                          HTKeyValue_t *oldkeyvalues,
+                          bool *replaced);
+int HashTable_FindBatch(HashTable *table,
+                        const HTKey_t *keys,
+                        int count,
+                        HTKeyValue_t *keyvalues,
+                        bool *found);
+
+// A lookup that can be advanced one memory access at a time, so that a
+// caller can interleave many lookups and hide each one's cache misses
+// behind the others' work.  (HashTableLookup.h drives these from C++20
+// coroutines.)
+//
+// HashTable_LookupStart begins a lookup and prefetches the first thing it
+// needs to examine.  Each HashTable_LookupStep examines what the previous
+// call prefetched, and then either finishes the lookup or prefetches the
+// next thing (the chain, then each chain node in turn) and returns
+// HT_LOOKUP_PENDING.
+//
+// Unlike HashTable_Find, a stepped lookup never migrates buckets for an
+// incremental resize; it doesn't modify the table at all, beyond counting
+// itself in a collect_stats table's HTStats.  The table MUST NOT be
+// modified while any lookup on it is still pending.
+typedef enum {
+  HT_LOOKUP_PENDING = 0,  // call HashTable_LookupStep again
+  HT_LOOKUP_FOUND,        // done: the key was found
+  HT_LOOKUP_MISSING,      // done: the key isn't in the table
+} HTLookupStatus_t;
+
+// The state of one stepped lookup.  The caller provides the storage, but
+// should treat the fields as private to HashTable.c.
+typedef struct {
+  HashTable  *table;
+  HTKey_t     key;
+  const void *next;    // what the next step examines
+  int         stage;   // what kind of thing "next" points at
+  int         probes;  // keys compared so far, for HTStats
+} HTLookup;
+
+// Begins a lookup of "key" in "table", storing its state in "lookup".
+void HashTable_LookupStart(HashTable *table, HTKey_t key, HTLookup *lookup);
+
+// Advances "lookup" by one step.
+//
+// Arguments:
+// - lookup: a lookup begun by HashTable_LookupStart that is still
+//   pending.
+// - keyvalue: if the lookup finds its key, a copy of the (key,value) is
+//   returned via this return parameter, as for HashTable_Find.
+//
+// Returns:
+// - HT_LOOKUP_PENDING: the lookup needs more steps.
+// - HT_LOOKUP_FOUND: the key was found and returned through keyvalue.
+// - HT_LOOKUP_MISSING: the key isn't in the table.
+HTLookupStatus_t HashTable_LookupStep(HTLookup *lookup,
+                                      HTKeyValue_t *keyvalue);
+
 // Removes a (key,value) from the HashTable and returns it to the
 // caller.
 //
@@ -170,6 +409,49 @@ bool HashTable_Remove(HashTable *table,
                       HTKey_t key,
                       HTKeyValue_t *keyvalue);
 
+// The number of bins in HTStats.chain_length_histogram.
+#define HT_STATS_HISTOGRAM_BINS 16
+
+// A snapshot of how well a table's keys are spread out; see
+// HashTable_GetStats.
+//
+// For a chained table, a "chain" is a bucket's list of entries and a probe
+// is one key comparison along a chain.  For a swiss table, a chain is the
+// probe sequence that a lookup of one entry follows, measured in groups:
+// chain_length_histogram[i] counts the entries found in their i'th probed
+// group, and a probe is one group examined.
+typedef struct {
+  int      num_elements;      // HashTable_NumElements(table)
+  int      num_buckets;       // # of buckets (or swiss slots)
+  double   load_factor;       // num_elements / num_buckets
+  int      empty_buckets;     // # of empty buckets (or swiss slots)
+  int      max_chain_length;  // the longest chain
+
+  // chain_length_histogram[i] is the number of chains of length i; the
+  // last bin also counts every longer chain.
+  int      chain_length_histogram[HT_STATS_HISTOGRAM_BINS];
+
+  int      num_resizes;       // # of times the table has been resized
+  double   resize_seconds;    // total time spent resizing
+
+  // Only counted if the table was allocated with collect_stats; otherwise
+  // both are zero.  Finds include those made by HashTable_FindBatch and by
+  // stepped lookups (HashTable_LookupStep, and so InterleavedFind).
+  uint64_t num_finds;            // # of Finds since allocation
+  double   avg_probes_per_find;  // mean # of probes those Finds made
+} HTStats;
+
+// Reports the distribution of a table's entries.
+//
+// This scans the whole table, so it costs about as much as a full
+// iteration; it's meant for monitoring, not for hot paths.  Like
+// HTIterator_Allocate, it finishes any in-progress incremental resize.
+//
+// Arguments:
+// - table: the table to examine.
+// - stats: a return parameter through which the statistics are returned.
+void HashTable_GetStats(HashTable *table, HTStats *stats);
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // HashTable iterator
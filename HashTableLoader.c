@@ -0,0 +1,301 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+// pthreads and posix_fadvise are POSIX, not C17.
+#define _POSIX_C_SOURCE 200809L
+
+#include "HashTableLoader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "CSE333.h"
+#include "HashTable.h"
+
+// How much of the file each read fetches.  Two chunks are in flight at
+// once: one being read, one being parsed.
+#define HT_LOAD_CHUNK_BYTES (1 << 20)
+
+// How many parsed records go to each HashTable_InsertBatch.
+#define HT_LOAD_BATCH 256
+
+// The hand-off between the reader thread and the parsing thread.  Each
+// chunk is either full (read, waiting to be parsed) or not (free for the
+// reader to fill); the two threads take turns on the chunks, in order.
+typedef struct {
+  int              fd;
+  char            *chunk[2];  // each HT_LOAD_CHUNK_BYTES bytes
+  ssize_t          len[2];    // bytes read into the chunk; 0 at EOF,
+                              // -1 on a read error
+  bool             full[2];
+  int              error;     // errno of the failed read, if any
+  pthread_mutex_t  lock;      // guards len, full and error
+  pthread_cond_t   cond;      // signalled whenever a chunk changes hands
+} LoadPipe;
+
+// A record that straddles two chunks, being reassembled.
+typedef struct {
+  char   *buf;
+  size_t  len;
+  size_t  capacity;
+} LoadCarry;
+
+// Parsed records waiting to be inserted.
+typedef struct {
+  HashTable          *table;
+  HTRecordParseFnPtr  parse;
+  void               *parse_arg;
+  ValueFreeFnPtr      value_free_function;
+  int                 num_loaded;  // # of records inserted so far
+
+  int                 count;       // # of records in the arrays below
+  HTKeyValue_t        records[HT_LOAD_BATCH];
+  HTKeyValue_t        old[HT_LOAD_BATCH];
+  bool                replaced[HT_LOAD_BATCH];
+} LoadBatch;
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+
+// Reads until buf is full or the file ends, retrying short reads.
+// Returns the number of bytes read, or -1 on error.
+static ssize_t ReadFully(int fd, char *buf, size_t len) {
+  size_t total = 0;
+  while (total < len) {
+    ssize_t n = read(fd, buf + total, len - total);
+    if (n == 0) break;
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return -1;
+    }
+    total += (size_t)n;
+  }
+  return (ssize_t)total;
+}
+
+// Counts the records in a file (its newlines, plus an unterminated last
+// line), using buf as scratch, and then rewinds the file.  Returns -1 on
+// error.
+static ssize_t CountRecords(int fd, char *buf) {
+  ssize_t count = 0, n;
+  char last = '\n';
+
+  while ((n = ReadFully(fd, buf, HT_LOAD_CHUNK_BYTES)) > 0) {
+    const char *p = buf, *end = buf + n;
+    while ((p = memchr(p, '\n', end - p)) != NULL) {
+      count++;
+      p++;
+    }
+    last = buf[n - 1];
+  }
+  if (n < 0 || lseek(fd, 0, SEEK_SET) != 0) {
+    return -1;
+  }
+  return count + (last != '\n');
+}
+
+// The reader thread: fills the chunks in turn until the file ends or a
+// read fails, and then stops.
+static void *ReaderMain(void *arg) {
+  LoadPipe *pipe = (LoadPipe *)arg;
+  int slot = 0;
+  ssize_t n = 0;
+
+  do {
+    Verify333(pthread_mutex_lock(&pipe->lock) == 0);
+    while (pipe->full[slot]) {
+      Verify333(pthread_cond_wait(&pipe->cond, &pipe->lock) == 0);
+    }
+    Verify333(pthread_mutex_unlock(&pipe->lock) == 0);
+
+    n = ReadFully(pipe->fd, pipe->chunk[slot], HT_LOAD_CHUNK_BYTES);
+
+    Verify333(pthread_mutex_lock(&pipe->lock) == 0);
+    pipe->len[slot] = n;
+    if (n < 0) {
+      pipe->error = errno;
+    }
+    pipe->full[slot] = true;
+    Verify333(pthread_cond_broadcast(&pipe->cond) == 0);
+    Verify333(pthread_mutex_unlock(&pipe->lock) == 0);
+    slot ^= 1;
+  } while (n > 0);
+  return NULL;
+}
+
+// Inserts the batched records, freeing any values they replace.
+static void FlushBatch(LoadBatch *batch) {
+  int i;
+
+  HashTable_InsertBatch(batch->table, batch->records, batch->count,
+                        batch->old, batch->replaced);
+  if (batch->value_free_function != NULL) {
+    for (i = 0; i < batch->count; i++) {
+      if (batch->replaced[i]) {
+        batch->value_free_function(batch->old[i].value);
+      }
+    }
+  }
+  batch->num_loaded += batch->count;
+  batch->count = 0;
+}
+
+// Parses one NUL-terminated record into the batch.
+static void AddRecord(LoadBatch *batch, const char *record, size_t len) {
+  if (len == 0) return;
+  if (batch->parse(record, len, batch->parse_arg,
+                   &batch->records[batch->count])) {
+    if (++batch->count == HT_LOAD_BATCH) {
+      FlushBatch(batch);
+    }
+  }
+}
+
+// Appends len bytes to the straddling record, keeping it NUL-terminated.
+static void AppendCarry(LoadCarry *carry, const char *bytes, size_t len) {
+  if (carry->len + len + 1 > carry->capacity) {
+    carry->capacity = 2 * (carry->len + len + 1);
+    carry->buf = (char *)realloc(carry->buf, carry->capacity);
+    Verify333(carry->buf != NULL);
+  }
+  memcpy(carry->buf + carry->len, bytes, len);
+  carry->len += len;
+  carry->buf[carry->len] = '\0';
+}
+
+// Parses every complete record in a chunk.  Records are terminated in
+// place, so the chunk is clobbered.  A record that starts in an earlier
+// chunk is finished from carry, and the chunk's own unfinished last record
+// is left there for the next chunk.
+static void ParseChunk(LoadBatch *batch, LoadCarry *carry,
+                       char *chunk, size_t len) {
+  char *p = chunk, *end = chunk + len, *newline;
+
+  while ((newline = memchr(p, '\n', end - p)) != NULL) {
+    if (carry->len > 0) {
+      AppendCarry(carry, p, newline - p);
+      AddRecord(batch, carry->buf, carry->len);
+      carry->len = 0;
+    } else {
+      *newline = '\0';
+      AddRecord(batch, p, newline - p);
+    }
+    p = newline + 1;
+  }
+  if (p < end) {
+    AppendCarry(carry, p, end - p);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HashTable_LoadFile implementation.
+
+int HashTable_LoadFile(HashTable *table, const char *path,
+                       HTRecordParseFnPtr parse, void *parse_arg,
+                       int size_hint, ValueFreeFnPtr value_free_function) {
+  LoadPipe pipe;
+  LoadCarry carry = { NULL, 0, 0 };
+  LoadBatch *batch;
+  pthread_t reader;
+  int64_t num_records = size_hint;
+  int slot = 0, error = 0;
+  ssize_t n = 0;
+
+  Verify333(table != NULL);
+  Verify333(path != NULL);
+  Verify333(parse != NULL);
+  Verify333(size_hint >= 0);
+
+  memset(&pipe, 0, sizeof(pipe));
+  pipe.fd = open(path, O_RDONLY);
+  if (pipe.fd < 0) {
+    return -1;
+  }
+  // Only a hint, so it doesn't matter if the file system ignores it.
+  posix_fadvise(pipe.fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  pipe.chunk[0] = (char *)malloc(HT_LOAD_CHUNK_BYTES);
+  pipe.chunk[1] = (char *)malloc(HT_LOAD_CHUNK_BYTES);
+  Verify333(pipe.chunk[0] != NULL && pipe.chunk[1] != NULL);
+
+  if (num_records == 0) {
+    num_records = CountRecords(pipe.fd, pipe.chunk[0]);
+    if (num_records < 0) {
+      error = errno;
+      goto done;
+    }
+  }
+  num_records += HashTable_NumElements(table);
+  HashTable_Reserve(table, num_records < INT_MAX ? (int)num_records
+                                                 : INT_MAX - 1);
+
+  batch = (LoadBatch *)malloc(sizeof(LoadBatch));
+  Verify333(batch != NULL);
+  batch->table = table;
+  batch->parse = parse;
+  batch->parse_arg = parse_arg;
+  batch->value_free_function = value_free_function;
+  batch->num_loaded = 0;
+  batch->count = 0;
+
+  Verify333(pthread_mutex_init(&pipe.lock, NULL) == 0);
+  Verify333(pthread_cond_init(&pipe.cond, NULL) == 0);
+  Verify333(pthread_create(&reader, NULL, &ReaderMain, &pipe) == 0);
+
+  for (;;) {
+    Verify333(pthread_mutex_lock(&pipe.lock) == 0);
+    while (!pipe.full[slot]) {
+      Verify333(pthread_cond_wait(&pipe.cond, &pipe.lock) == 0);
+    }
+    n = pipe.len[slot];
+    error = pipe.error;
+    Verify333(pthread_mutex_unlock(&pipe.lock) == 0);
+    if (n <= 0) break;  // the reader has stopped
+
+    ParseChunk(batch, &carry, pipe.chunk[slot], (size_t)n);
+
+    Verify333(pthread_mutex_lock(&pipe.lock) == 0);
+    pipe.full[slot] = false;
+    Verify333(pthread_cond_broadcast(&pipe.cond) == 0);
+    Verify333(pthread_mutex_unlock(&pipe.lock) == 0);
+    slot ^= 1;
+  }
+  Verify333(pthread_join(reader, NULL) == 0);
+  Verify333(pthread_cond_destroy(&pipe.cond) == 0);
+  Verify333(pthread_mutex_destroy(&pipe.lock) == 0);
+
+  // Even after an error, whatever we parsed goes into the table, or else
+  // the values would leak.
+  if (error == 0 && carry.len > 0) {
+    AddRecord(batch, carry.buf, carry.len);
+  }
+  FlushBatch(batch);
+  n = batch->num_loaded;
+  free(batch);
+
+ done:
+  close(pipe.fd);
+  free(pipe.chunk[0]);
+  free(pipe.chunk[1]);
+  free(carry.buf);
+  if (error != 0) {
+    errno = error;
+    return -1;
+  }
+  return (int)n;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_HASHTABLELOADER_H_
+#define HW1_HASHTABLELOADER_H_
+
+#include <stdbool.h>    // for bool type (true, false)
+#include <stddef.h>     // for size_t
+
+#include "./HashTable.h"  // for HashTable, HTKeyValue_t, ValueFreeFnPtr
+
+///////////////////////////////////////////////////////////////////////////////
+// Bulk-loading a HashTable from a file of newline-separated records.
+//
+// Rather than reading the file a line at a time and inserting each record
+// as it is parsed, HashTable_LoadFile runs a small pipeline:
+//
+// - the table is presized for the whole file up front (from a size hint,
+//   or else from a quick pass that counts the lines), so it never resizes
+//   partway through the load;
+// - a reader thread reads the file sequentially in large chunks, into one
+//   buffer while the caller's thread parses the other, so that the file's
+//   I/O overlaps with parsing and hashing;
+// - parsed records are inserted with HashTable_InsertBatch, which
+//   prefetches each batch's buckets before touching them.
+
+// When loading a file, customers pass a pointer to a function that parses
+// one record into a (key,value).  "record" is a line of the file, without
+// its newline, and NUL-terminated; len is its length.  The record's memory
+// is reused once the function returns, so the value must not point into
+// it.  arg is the parse_arg that was passed to HashTable_LoadFile.
+//
+// Returns true if the record was parsed into *keyvalue, or false to skip
+// the record (eg, a malformed or comment line).
+typedef bool (*HTRecordParseFnPtr)(const char *record,
+                                   size_t len,
+                                   void *arg,
+                                   HTKeyValue_t *keyvalue);
+
+// Inserts every record in a file into a table.
+//
+// Records are inserted in file order, so if a key appears more than once,
+// its last record wins.  Empty lines are skipped without being parsed.
+//
+// Arguments:
+// - table: the table to load into.  It needn't be empty.
+// - path: the file to load.
+// - parse: parses each record; see above.
+// - parse_arg: passed through to each call of parse.
+// - size_hint: the number of records in the file, if the caller knows it
+//   (an estimate is fine).  If 0, the file is read once to count its
+//   lines before it is loaded; a hint saves that pass.  MUST be
+//   non-negative.
+// - value_free_function: called on each value that a record replaces,
+//   whether it was already in the table or came from an earlier record in
+//   the file.  May be NULL if values don't need freeing.
+//
+// Returns:
+// - the number of records inserted (including those that replaced a
+//   key's value), on success.
+// - -1 if the file couldn't be read; errno describes why.  The table then
+//   holds whichever records were read before the error.
+int HashTable_LoadFile(HashTable *table,
+                       const char *path,
+                       HTRecordParseFnPtr parse,
+                       void *parse_arg,
+                       int size_hint,
+                       ValueFreeFnPtr value_free_function);
+
+#endif  // HW1_HASHTABLELOADER_H_
@@ -0,0 +1,151 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_HASHTABLELOOKUP_H_
+#define HW1_HASHTABLELOOKUP_H_
+
+#include <coroutine>  // for std::coroutine_handle, std::suspend_always
+#include <exception>  // for std::terminate
+#include <utility>    // for std::exchange
+#include <vector>     // for std::vector
+
+extern "C" {
+  #include "./CSE333.h"
+  #include "./HashTable.h"
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Interleaved HashTable lookups for C++20 callers.
+//
+// Looking keys up one HashTable_Find at a time in a table much larger than
+// the cache costs a full memory latency for every bucket, chain and chain
+// node visited, with the core idle in between.  InterleavedFind instead
+// runs many lookups as coroutines: each one issues a prefetch for the next
+// thing it needs (via HashTable_LookupStep), then suspends so that the
+// others can run while the line arrives.  With enough lookups in flight,
+// a lookup's miss is overlapped with the others' misses.
+//
+// The table MUST NOT be modified during a call to InterleavedFind.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace hw1 {
+
+// The default number of lookups InterleavedFind keeps in flight: enough
+// to cover a DRAM access with a few dozen cycles of work per step.
+constexpr int kDefaultLookupWidth = 16;
+
+// A coroutine that is resumed by hand until it completes.  It starts out
+// suspended, and stays suspended at its end so that done() can be asked.
+class LookupTask {
+ public:
+  struct promise_type {
+    LookupTask get_return_object() {
+      return LookupTask(
+          std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  LookupTask(LookupTask &&other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {}
+  LookupTask(const LookupTask &) = delete;
+  LookupTask &operator=(const LookupTask &) = delete;
+  ~LookupTask() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool done() const { return handle_.done(); }
+  void resume() { handle_.resume(); }
+
+ private:
+  explicit LookupTask(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// The work shared by one InterleavedFind call's coroutines.
+struct InterleavedFindState {
+  HashTable     *table;
+  const HTKey_t *keys;
+  int            count;
+  HTKeyValue_t  *keyvalues;
+  bool          *found;
+  int            next;       // the next key no coroutine has claimed
+  int            num_found;
+};
+
+// One of InterleavedFind's coroutines.  It claims keys until none are
+// left, suspending after every step of every lookup.  Reusing a few
+// coroutines for all the keys, rather than starting one per key, keeps
+// coroutine frame allocation out of the per-key cost.
+inline LookupTask InterleavedFindWorker(InterleavedFindState *state) {
+  while (state->next < state->count) {
+    int i = state->next++;
+    HTLookup lookup;
+    HTLookupStatus_t status;
+
+    HashTable_LookupStart(state->table, state->keys[i], &lookup);
+    do {
+      co_await std::suspend_always{};
+      status = HashTable_LookupStep(&lookup, &state->keyvalues[i]);
+    } while (status == HT_LOOKUP_PENDING);
+
+    state->found[i] = (status == HT_LOOKUP_FOUND);
+    state->num_found += state->found[i];
+  }
+}
+
+// Looks up every key in "keys", keeping up to "width" lookups in flight;
+// width MUST be positive.  The other arguments and the results are exactly
+// those of HashTable_FindBatch, except that the table isn't modified (see
+// HashTable_LookupStart).
+//
+// Returns the number of elements for which found[i] is true.
+inline int InterleavedFind(HashTable *table, const HTKey_t *keys, int count,
+                           HTKeyValue_t *keyvalues, bool *found,
+                           int width = kDefaultLookupWidth) {
+  InterleavedFindState state = {table, keys, count, keyvalues, found, 0, 0};
+  std::vector<LookupTask> tasks;
+  int running;
+
+  Verify333(table != NULL);
+  Verify333(count >= 0);
+  Verify333(width > 0);
+  if (width > count) {
+    width = count;
+  }
+  tasks.reserve(width);
+  for (int i = 0; i < width; i++) {
+    tasks.push_back(InterleavedFindWorker(&state));
+  }
+
+  // Round-robin over the coroutines until every one has run out of keys.
+  running = width;
+  while (running > 0) {
+    for (LookupTask &task : tasks) {
+      if (!task.done()) {
+        task.resume();
+        running -= task.done();
+      }
+    }
+  }
+  return state.num_found;
+}
+
+}  // namespace hw1
+
+#endif  // HW1_HASHTABLELOOKUP_H_
@@ -0,0 +1,342 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "HashTableSnapshot.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CSE333.h"
+#include "HashTable.h"
+#include "HashTable_priv.h"
+#include "HashTableSnapshot_priv.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+
+// Returns the bucket that "key" lives in, in a snapshot with num_buckets
+// buckets.  This is part of the file format.
+static inline uint64_t SnapshotBucket(HTKey_t key, uint64_t num_buckets) {
+  return HTMixKey(key) & (num_buckets - 1);
+}
+
+// Rounds n up to a multiple of 8.
+static inline uint64_t Align8(uint64_t n) {
+  return (n + 7) & ~(uint64_t)7;
+}
+
+// Writes len bytes followed by enough zeros to reach an 8-byte boundary,
+// advancing *offset past them.  Returns false on a write error.
+static bool WritePadded(FILE *f, const void *bytes, uint64_t len,
+                        uint64_t *offset) {
+  static const unsigned char kZeros[8] = { 0 };
+  uint64_t padded = Align8(len);
+
+  if (len > 0 && fwrite(bytes, 1, len, f) != len) {
+    return false;
+  }
+  if (padded > len && fwrite(kZeros, 1, padded - len, f) != padded - len) {
+    return false;
+  }
+  *offset += padded;
+  return true;
+}
+
+// Does the section [offset, offset + count * size) fit in a file of
+// file_size bytes, starting on an 8-byte boundary?  Written to avoid
+// overflow even for a hostile header.
+static bool SectionFits(uint64_t offset, uint64_t count, uint64_t size,
+                        uint64_t file_size) {
+  if (offset % 8 != 0 || offset > file_size) {
+    return false;
+  }
+  return count <= (file_size - offset) / size;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// HTSnapshot implementation.
+
+bool HashTable_Save(HashTable *table, const char *path,
+                    HTValueBytesFnPtr value_bytes) {
+  HTSnapshotHeader header;
+  uint64_t *buckets = NULL, *cursor = NULL;
+  HTSnapshotEntry *entries = NULL;
+  HTValue_t *values = NULL;
+  HTIterator *it;
+  HTKeyValue_t kv;
+  uint64_t num_elements, num_buckets, b, i, offset;
+  char *tmp_path;
+  FILE *f = NULL;
+  bool ok = false;
+  int fd = -1, saved_errno;
+
+  Verify333(table != NULL);
+  Verify333(path != NULL);
+
+  num_elements = HashTable_NumElements(table);
+  num_buckets = 1;
+  while (num_buckets < num_elements) {
+    num_buckets *= 2;
+  }
+
+  // We build the file under a unique name next to its final one and
+  // rename it into place, so that a process with the old snapshot mapped
+  // never sees it truncated, and concurrent saves to the same path don't
+  // write into each other's files.
+  tmp_path = (char *)malloc(strlen(path) + sizeof(".XXXXXX"));
+  Verify333(tmp_path != NULL);
+  snprintf(tmp_path, strlen(path) + sizeof(".XXXXXX"), "%s.XXXXXX", path);
+
+  buckets = (uint64_t *)calloc(num_buckets + 1, sizeof(uint64_t));
+  cursor = (uint64_t *)malloc(num_buckets * sizeof(uint64_t));
+  entries = (HTSnapshotEntry *)malloc((num_elements + 1) *
+                                      sizeof(HTSnapshotEntry));
+  values = (HTValue_t *)malloc((num_elements + 1) * sizeof(HTValue_t));
+  Verify333(buckets != NULL && cursor != NULL);
+  Verify333(entries != NULL && values != NULL);
+
+  // Count each bucket's entries, then turn the counts into the index of
+  // each bucket's first entry.
+  it = HTIterator_Allocate(table);
+  for (; HTIterator_IsValid(it); HTIterator_Next(it)) {
+    HTIterator_Get(it, &kv);
+    buckets[SnapshotBucket(kv.key, num_buckets) + 1]++;
+  }
+  HTIterator_Free(it);
+  for (b = 0; b < num_buckets; b++) {
+    buckets[b + 1] += buckets[b];
+  }
+  Verify333(buckets[num_buckets] == num_elements);
+
+  // Drop each entry into its bucket's run.
+  memcpy(cursor, buckets, num_buckets * sizeof(uint64_t));
+  it = HTIterator_Allocate(table);
+  for (; HTIterator_IsValid(it); HTIterator_Next(it)) {
+    HTIterator_Get(it, &kv);
+    i = cursor[SnapshotBucket(kv.key, num_buckets)]++;
+    entries[i].key = kv.key;
+    values[i] = kv.value;
+  }
+  HTIterator_Free(it);
+
+  // mkstemp creates the file readable by its owner only, but a snapshot
+  // is meant to be mapped by other processes too.
+  fd = mkstemp(tmp_path);
+  if (fd < 0) {
+    goto done;
+  }
+  if (fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != 0) {
+    goto done;
+  }
+  f = fdopen(fd, "wb");
+  if (f == NULL) {
+    goto done;
+  }
+
+  // The header goes in last, once we know where everything is.
+  memset(&header, 0, sizeof(header));
+  header.magic = HT_SNAPSHOT_MAGIC;
+  header.version = HT_SNAPSHOT_VERSION;
+  header.flags = (value_bytes == NULL) ? HT_SNAPSHOT_INLINE_VALUES : 0;
+  header.num_elements = num_elements;
+  header.num_buckets = num_buckets;
+  offset = 0;
+  if (!WritePadded(f, &header, sizeof(header), &offset)) {
+    goto done;
+  }
+
+  header.buckets_offset = offset;
+  if (!WritePadded(f, buckets, (num_buckets + 1) * sizeof(uint64_t),
+                   &offset)) {
+    goto done;
+  }
+
+  // Stream the values out in entry order, noting where each one lands.
+  header.blob_offset = offset;
+  for (i = 0; i < num_elements; i++) {
+    if (value_bytes == NULL) {
+      entries[i].value_offset = (uint64_t)(uintptr_t)values[i];
+      entries[i].value_len = 0;
+    } else {
+      const void *bytes;
+      size_t len;
+      value_bytes(values[i], &bytes, &len);
+      entries[i].value_offset = offset - header.blob_offset;
+      entries[i].value_len = len;
+      if (!WritePadded(f, bytes, len, &offset)) {
+        goto done;
+      }
+    }
+  }
+  header.blob_size = offset - header.blob_offset;
+
+  header.entries_offset = offset;
+  if (!WritePadded(f, entries, num_elements * sizeof(HTSnapshotEntry),
+                   &offset)) {
+    goto done;
+  }
+
+  if (fseek(f, 0, SEEK_SET) != 0 ||
+      fwrite(&header, sizeof(header), 1, f) != 1) {
+    goto done;
+  }
+
+  // Make sure the data is on disk before the rename can be, so that a
+  // crash never leaves a truncated file under the final name.
+  if (fflush(f) != 0 || fsync(fd) != 0) {
+    goto done;
+  }
+  ok = true;
+
+ done:
+  saved_errno = errno;
+  if (f != NULL) {
+    if (fclose(f) != 0 && ok) {
+      saved_errno = errno;
+      ok = false;
+    }
+  } else if (fd >= 0) {
+    close(fd);
+  }
+  if (ok && rename(tmp_path, path) != 0) {
+    saved_errno = errno;
+    ok = false;
+  }
+  if (!ok && fd >= 0) {
+    remove(tmp_path);
+  }
+  free(tmp_path);
+  free(buckets);
+  free(cursor);
+  free(entries);
+  free(values);
+  errno = saved_errno;
+  return ok;
+}
+
+HTSnapshot *HashTable_MapFile(const char *path) {
+  const HTSnapshotHeader *header;
+  HTSnapshot *snapshot;
+  struct stat st;
+  uint64_t size;
+  void *map;
+  int fd;
+
+  Verify333(path != NULL);
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(HTSnapshotHeader)) {
+    close(fd);
+    return NULL;
+  }
+  size = (uint64_t)st.st_size;
+  map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);  // the mapping keeps the file alive
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+
+  // Check the header, and that every section lies within the file, so
+  // that lookups can trust the offsets.  We deliberately don't look at
+  // the sections themselves: that would fault in the whole file.
+  header = (const HTSnapshotHeader *)map;
+  if (header->magic != HT_SNAPSHOT_MAGIC ||
+      header->version != HT_SNAPSHOT_VERSION ||
+      header->num_buckets == 0 ||
+      (header->num_buckets & (header->num_buckets - 1)) != 0 ||
+      !SectionFits(header->buckets_offset, header->num_buckets,
+                   sizeof(uint64_t), size - sizeof(uint64_t)) ||
+      !SectionFits(header->entries_offset, header->num_elements,
+                   sizeof(HTSnapshotEntry), size) ||
+      !SectionFits(header->blob_offset, header->blob_size, 1, size) ||
+      header->num_elements > INT32_MAX) {
+    munmap(map, size);
+    return NULL;
+  }
+
+  snapshot = (HTSnapshot *)malloc(sizeof(HTSnapshot));
+  Verify333(snapshot != NULL);
+  snapshot->map = map;
+  snapshot->map_size = size;
+  snapshot->header = header;
+  snapshot->buckets =
+      (const uint64_t *)((const char *)map + header->buckets_offset);
+  snapshot->entries =
+      (const HTSnapshotEntry *)((const char *)map + header->entries_offset);
+  snapshot->blob = (const unsigned char *)map + header->blob_offset;
+  return snapshot;
+}
+
+void HTSnapshot_Unmap(HTSnapshot *snapshot) {
+  Verify333(snapshot != NULL);
+  munmap(snapshot->map, snapshot->map_size);
+  free(snapshot);
+}
+
+int HTSnapshot_NumElements(HTSnapshot *snapshot) {
+  Verify333(snapshot != NULL);
+  return (int)snapshot->header->num_elements;
+}
+
+bool HTSnapshot_Find(HTSnapshot *snapshot, HTKey_t key,
+                     HTKeyValue_t *keyvalue, size_t *value_len) {
+  const HTSnapshotHeader *header;
+  const HTSnapshotEntry *entry;
+  uint64_t b, i, end;
+
+  Verify333(snapshot != NULL);
+  Verify333(keyvalue != NULL);
+
+  header = snapshot->header;
+  b = SnapshotBucket(key, header->num_buckets);
+  i = snapshot->buckets[b];
+  end = snapshot->buckets[b + 1];
+
+  // A damaged file may have bucket boundaries or value offsets that point
+  // outside their sections; we treat those entries as missing.
+  if (end > header->num_elements) {
+    return false;
+  }
+  for (; i < end; i++) {
+    entry = &snapshot->entries[i];
+    if (entry->key != key) {
+      continue;
+    }
+
+    keyvalue->key = key;
+    if (header->flags & HT_SNAPSHOT_INLINE_VALUES) {
+      keyvalue->value = (HTValue_t)(uintptr_t)entry->value_offset;
+    } else {
+      if (entry->value_offset > header->blob_size ||
+          entry->value_len > header->blob_size - entry->value_offset) {
+        return false;
+      }
+      keyvalue->value = (HTValue_t)(snapshot->blob + entry->value_offset);
+    }
+    if (value_len != NULL) {
+      *value_len = entry->value_len;
+    }
+    return true;
+  }
+  return false;
+}
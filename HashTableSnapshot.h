@@ -0,0 +1,108 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_HASHTABLESNAPSHOT_H_
+#define HW1_HASHTABLESNAPSHOT_H_
+
+#include <stdbool.h>    // for bool type (true, false)
+#include <stddef.h>     // for size_t
+
+#include "./HashTable.h"  // for HashTable, HTKey_t, HTKeyValue_t
+
+///////////////////////////////////////////////////////////////////////////////
+// An HTSnapshot is a read-only HashTable that lives in a file.
+//
+// HashTable_Save writes a table's contents to a file in a layout that can
+// be queried in place: HashTable_MapFile just maps the file into memory
+// and checks its header, so "loading" a snapshot of any size takes
+// constant time, and each entry costs nothing until a lookup first touches
+// its page.  The layout contains only offsets, never pointers, so the file
+// can be mapped at any address, by any number of processes at once.
+//
+// Values are arbitrary byte strings stored in a blob section of the file;
+// HTSnapshot_Find hands back a pointer straight into the mapping.  See
+// HashTableSnapshot_priv.h for the on-disk format.
+//
+// As with our other types, the struct is defined in
+// HashTableSnapshot_priv.h.
+typedef struct ht_snapshot HTSnapshot;
+
+// When saving a table, customers pass a pointer to a function that
+// describes the bytes that represent each value in the file.  It should
+// set *bytes to point at *len bytes; HashTable_Save copies them before
+// describing the next value.
+typedef void (*HTValueBytesFnPtr)(HTValue_t value,
+                                  const void **bytes,
+                                  size_t *len);
+
+// Writes a snapshot of a table to a file, replacing any existing file.
+//
+// Arguments:
+// - table: the table to save.  It isn't modified, except that any
+//   in-progress incremental resize is completed.
+// - path: the file to write.
+// - value_bytes: describes each value's bytes; see above.  May be NULL if
+//   the values aren't pointers at all (eg, they are integers cast to
+//   HTValue_t), in which case each value is saved as is, and handed back
+//   by HTSnapshot_Find as the same HTValue_t.
+//
+// Returns:
+// - true: on success.
+// - false: if the file couldn't be written; errno describes why.
+bool HashTable_Save(HashTable *table, const char *path,
+                    HTValueBytesFnPtr value_bytes);
+
+// Maps a snapshot written by HashTable_Save.
+//
+// Arguments:
+// - path: the file to map.
+//
+// Returns:
+// - the mapped snapshot, which the caller must eventually pass to
+//   HTSnapshot_Unmap.
+// - NULL: if the file can't be opened or mapped, or isn't a snapshot
+//   in a format version that we understand.
+HTSnapshot* HashTable_MapFile(const char *path);
+
+// Unmaps a snapshot.  Any value pointers that HTSnapshot_Find handed out
+// become invalid.
+//
+// Arguments:
+// - snapshot: the snapshot to unmap.  It is unsafe to use it after this
+//   function returns.
+void HTSnapshot_Unmap(HTSnapshot *snapshot);
+
+// Returns the number of elements in the snapshot.
+int HTSnapshot_NumElements(HTSnapshot *snapshot);
+
+// Looks up a key in the snapshot.
+//
+// Arguments:
+// - snapshot: the snapshot to look in.
+// - key: the key to look up.
+// - keyvalue: if the key is present, its (key,value) is returned through
+//   this return parameter.  Unless the snapshot was saved without a
+//   value_bytes function, value points at the value's bytes inside the
+//   read-only mapping; they are 8-byte aligned, and stay valid until the
+//   snapshot is unmapped.
+// - value_len: if non-NULL and the key is present, the length of the
+//   value's bytes is returned through this return parameter (or 0 if the
+//   snapshot was saved without a value_bytes function).
+//
+// Returns:
+// - true: if the key was found.
+// - false: if it wasn't.
+bool HTSnapshot_Find(HTSnapshot *snapshot,
+                     HTKey_t key,
+                     HTKeyValue_t *keyvalue,
+                     size_t *value_len);
+
+#endif  // HW1_HASHTABLESNAPSHOT_H_
@@ -0,0 +1,87 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_HASHTABLESNAPSHOT_PRIV_H_
+#define HW1_HASHTABLESNAPSHOT_PRIV_H_
+
+#include <stddef.h>  // for size_t
+#include <stdint.h>  // for uint64_t, etc.
+
+#include "./HashTableSnapshot.h"
+
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+// Internal structures and the on-disk format of HTSnapshot, broken out into
+// a "private .h" so that our unittests can peek inside.
+//
+// Customers should not include this file or assume anything based on
+// its contents.
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+// A snapshot file is four sections, each starting on an 8-byte boundary:
+//
+//   header   an HTSnapshotHeader
+//   buckets  num_buckets + 1 uint64_t's: bucket b's entries are
+//            entries[buckets[b], buckets[b + 1])
+//   blob     the values' bytes, each starting on an 8-byte boundary
+//   entries  num_elements HTSnapshotEntry's, grouped by bucket
+//
+// (The writer streams the blob out before the entries that point into it;
+// readers find every section through the header's offsets.)  A lookup
+// reads one bucket boundary pair and then a run of adjacent entries, which
+// usually share a cache line, since there are at least as many buckets as
+// entries.
+//
+// num_buckets is a power of two, and a key's bucket is
+// HTMixKey(key) & (num_buckets - 1); that mixer is therefore part of the
+// format.  All integers are in the writer's byte order; a reader of the
+// other byte order sees a bad magic number and rejects the file.
+//
+// Any change to the layout or to the bucket function must bump
+// HT_SNAPSHOT_VERSION.
+#define HT_SNAPSHOT_MAGIC   0x50414e5354485748ULL  // "HWHTSNAP"
+#define HT_SNAPSHOT_VERSION 1
+
+// HTSnapshotHeader.flags: values are stored in the entries themselves,
+// rather than in the blob.
+#define HT_SNAPSHOT_INLINE_VALUES 0x1
+
+typedef struct {
+  uint64_t magic;            // HT_SNAPSHOT_MAGIC
+  uint32_t version;          // HT_SNAPSHOT_VERSION
+  uint32_t flags;            // HT_SNAPSHOT_* flags
+  uint64_t num_elements;     // # of entries
+  uint64_t num_buckets;      // # of buckets; a power of two
+  uint64_t buckets_offset;   // file offset of the buckets section
+  uint64_t entries_offset;   // file offset of the entries section
+  uint64_t blob_offset;      // file offset of the blob section
+  uint64_t blob_size;        // size in bytes of the blob section
+} HTSnapshotHeader;
+
+// One (key,value) pair.  value_offset is relative to the start of the blob
+// section, unless the snapshot has HT_SNAPSHOT_INLINE_VALUES, in which case
+// it is the HTValue_t itself and value_len is 0.
+typedef struct {
+  uint64_t key;
+  uint64_t value_offset;
+  uint64_t value_len;
+} HTSnapshotEntry;
+
+// A mapped snapshot.  Every pointer points into the mapping.
+typedef struct ht_snapshot {
+  void                   *map;       // the whole file
+  size_t                  map_size;  // its size
+  const HTSnapshotHeader *header;
+  const uint64_t         *buckets;
+  const HTSnapshotEntry  *entries;
+  const unsigned char    *blob;
+} HTSnapshot;
+
+#endif  // HW1_HASHTABLESNAPSHOT_PRIV_H_
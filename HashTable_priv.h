@@ -15,7 +15,10 @@
 #include <stdint.h>  // for uint32_t, etc.
 
 #include "./LinkedList.h"
+#include "./LinkedList_priv.h"
 #include "./HashTable.h"
+#include "./MemPool.h"
+#include "./SwissTable_priv.h"
 
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 // Internal structures and helper functions for our HashTable implementation.
@@ -31,23 +34,129 @@
 
 // The hash table implementation.
 //
-// A hash table is an array of buckets, where each bucket is a linked list
-// of HTKeyValue structs.
+// A single entry in a chained bucket.
+//
+// Each chain is a LinkedList whose nodes are HTChainNodes: the list linkage
+// comes first and the (key,value) pair is embedded right after it, with
+// link.payload pointing at kv.  An entry is therefore a single allocation,
+// and reading a node's key touches the same memory as following its link.
+//
+// If the library is built with -DHT_CACHE_HASH, each node also caches the
+// bucket hash of its key (see HashKeyToBucketNum), so resizes never need
+// to rehash keys.
+typedef struct ht_node {
+  LinkedListNode  link;   // chain linkage; MUST be first
+  HTKeyValue_t    kv;     // the entry itself
+#ifdef HT_CACHE_HASH
+  uint64_t        hash;   // BucketHash(kv.key)
+#endif
+} HTChainNode;
+
+// A chained hash table is an array of buckets, where each bucket is a
+// linked list of HTChainNodes.  A swiss-engine table instead keeps
+// its entries in "swiss"; "buckets" is then NULL and "num_buckets" mirrors
+// the swiss table's slot count.
+//
+// While a resize is in progress, "old_buckets" holds the previous bucket
+// array.  Old buckets [0, migrate_idx) have already been moved into
+// "buckets"; a key whose old bucket is >= migrate_idx still lives in
+// "old_buckets".  When no resize is in progress, old_buckets is NULL.
+//
+// Buckets are materialized lazily: every bucket that has never held an
+// entry is NULL, and reads as an empty chain, so allocating or resizing
+// the bucket array costs one calloc rather than a malloc per bucket.  A
+// bucket gets a LinkedList of its own on first insert.
+//
+// The "occupied" bitmap lets an iterator skip straight past runs of empty
+// buckets, 64 at a time, without touching their LinkedLists.  It only
+// covers "buckets"; the old array's chains are marked as they migrate.
 typedef struct ht {
   int             num_buckets;   // # of buckets in this HT?
   int             num_elements;  // # of elements currently in this HT?
   LinkedList    **buckets;       // the array of buckets
+  uint64_t       *occupied;      // bit b is set iff buckets[b] is non-empty
+  HTEngine_t      engine;        // which engine stores the entries
+  SwissTable     *swiss;         // the HT_ENGINE_SWISS table, or NULL
+
+  bool            incremental_resize;  // migrate a few buckets per op?
+  LinkedList    **old_buckets;      // the array being migrated, or NULL
+  int             old_num_buckets;  // # of buckets in old_buckets
+  int             migrate_idx;      // next old bucket to migrate
+
+  MemPool        *node_pool;   // HTChainNodes, if HTOptions.use_pool
+  bool            pow2_buckets;  // mask a mixed key instead of modulo?
+  double          max_load_factor;  // grow at this many elements/bucket
+  int             growth_factor;    // ... multiplying num_buckets by this
+  int             resize_at;        // grow once num_elements reaches this
+  double          min_load_factor;  // shrink below this many/bucket
+  int             shrink_at;        // shrink once num_elements is below
+  int             min_buckets;      // ... but to no fewer buckets than this
+
+  // Statistics for HashTable_GetStats.  Resizes are rare, so they're
+  // always counted; Finds are counted only if collect_stats is set.
+  int             num_resizes;    // # of resizes, shrinks and compactions
+  uint64_t        resize_nanos;   // time spent in them
+  bool            collect_stats;  // count Finds and their probes?
+  uint64_t        num_finds;      // # of Finds counted
+  uint64_t        num_probes;     // # of probes those Finds made
 } HashTable;
 
-// The hash table iterator.
+// How many old buckets an incrementally-resizing table migrates during each
+// Insert, Find or Remove.  With the default policy, a migration of B old
+// buckets must finish within the ~24B inserts before the next resize; any
+// value >= 1 guarantees that.  (Under a more aggressive policy, a resize
+// that catches up with an unfinished migration completes it first.)
+#define HT_MIGRATE_BUCKETS_PER_OP 4
+
+// The default growth policy; see HTOptions.
+#define HT_DEFAULT_MAX_LOAD_FACTOR 3.0
+#define HT_DEFAULT_GROWTH_FACTOR 9
+
+// HashTable_FindBatch and HashTable_InsertBatch work through their keys in
+// groups of this many, prefetching a whole group's memory before resolving
+// any of its operations.  It should be large enough to keep many misses in
+// flight, yet small enough that a group's lines stay in L1.
+#define HT_BATCH_GROUP 16
+
+// How many nodes of each chain a batch prefetches, one stage (ie, one
+// node of every chain in the group) at a time.  At the default maximum
+// load factor of 3, chains are rarely longer than this.
+#define HT_BATCH_PREFETCH_NODES 4
+
+// HashTable records are allocated on cache-line boundaries and padded out
+// to whole cache lines, so that the records of tables used by different
+// threads, eg, the shards of a ShardedHashTable, never share a line.
+#define HT_CACHE_LINE 64
+
+// The hash table iterator.  For a swiss-engine table, bucket_idx is the
+// index of the current slot and bucket_it is always NULL.  Otherwise
+// bucket_it points at bucket_storage, which is re-initialized in place as
+// the iterator moves between buckets, so iterating never allocates.
+//
+// An iterator may walk several tables in turn, eg, the shards of a
+// ShardedHashTable: "ht" is the current one, and when it runs out,
+// HTIterator_Next calls next_table for the table after it, skipping empty
+// ones, until next_table returns NULL.  next_table is NULL for an iterator
+// over a single table.  "tables" and "table_idx" are for next_table's use.
 typedef struct ht_it {
-  HashTable  *ht;          // the HT we're pointing into
-  int         bucket_idx;  // which bucket are we in?
-  LLIterator *bucket_it;   // iterator for the bucket, or NULL
+  HashTable  *ht;              // the HT we're pointing into
+  int         bucket_idx;      // which bucket are we in?
+  LLIterator *bucket_it;       // iterator for the bucket, or NULL
+  LLIterator  bucket_storage;  // the storage bucket_it points into
+  HashTable *(*next_table)(struct ht_it *iter);  // the next table, or NULL
+  void       *tables;          // what next_table picks tables from
+  int         table_idx;       // ... and where it's got to
 } HTIterator;
 
 // This is the internal hash function we use to map from HTKey_t keys to a
-// bucket number.
+// bucket number.  By default it is simply key % num_buckets; for a
+// pow2_buckets table it is HTMixKey(key) & (num_buckets - 1).
 int HashKeyToBucketNum(HashTable *ht, HTKey_t key);
 
+// The 64-bit mixer used by pow2_buckets tables: alternating xor-shifts and
+// multiplies ("xmxmx").  Two multiplies are needed for the low bits, which
+// the mask keeps, to spread sequential and stride-aligned keys as well as
+// random ones; that is still far cheaper than a 64-bit division.
+uint64_t HTMixKey(HTKey_t key);
+
 #endif  // HW1_HASHTABLE_PRIV_H_
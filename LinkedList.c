@@ -9,13 +9,263 @@
  * author.
  */
 
+// pthreads and sysconf are POSIX, not C17.
+#define _POSIX_C_SOURCE 200809L
+
 #include "LinkedList.h"
 
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "CSE333.h"
 #include "LinkedList_priv.h"
+#include "MemPool.h"
+#include "UnrolledList_priv.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+
+// Allocates a node for "list", from its pool if it has one.
+static LinkedListNode *NewNode(LinkedList *list) {
+  LinkedListNode *ln;
+  if (list->pool != NULL) {
+    ln = (LinkedListNode *)MemPool_AllocObject(list->pool);
+  } else {
+    ln = (LinkedListNode *)malloc(sizeof(LinkedListNode));
+  }
+  Verify333(ln != NULL);
+  return ln;
+}
+
+// Frees a node that was allocated by NewNode(list).
+static void FreeNode(LinkedList *list, LinkedListNode *ln) {
+  if (list->pool != NULL) {
+    MemPool_FreeObject(list->pool, ln);
+  } else {
+    free(ln);
+  }
+}
+
+// The number of pending runs LinkedList_Sort can hold; pending run i is
+// the merger of 2^i natural runs, so this is far more than enough.
+#define LL_SORT_MAX_PENDING 64
+
+// LinkedList_SortParallel uses at most this many threads, and gives each
+// thread at least LL_SORT_MIN_CHUNK elements.
+#define LL_SORT_MAX_THREADS 64
+#define LL_SORT_MIN_CHUNK   4096
+
+// Compares two payloads in the order we're sorting into.
+static inline int SortOrder(LLPayloadComparatorFnPtr comparator_function,
+                            bool ascending, LLPayload_t a, LLPayload_t b) {
+  int compare_result = comparator_function(a, b);
+  return ascending ? compare_result : -compare_result;
+}
+
+// Detaches the natural run at the front of the NULL-terminated chain
+// "*rest" and advances *rest past it.  A run is either a non-decreasing
+// stretch, or a strictly decreasing one, which we reverse; reversing
+// never reorders equal payloads, so the sort stays stable.  Only "next"
+// pointers are maintained.
+static LinkedListNode *TakeRun(LinkedListNode **rest, bool ascending,
+                               LLPayloadComparatorFnPtr comparator_function) {
+  LinkedListNode *head = *rest, *cur = head->next;
+
+  if (cur != NULL && SortOrder(comparator_function, ascending,
+                               head->payload, cur->payload) > 0) {
+    head->next = NULL;
+    while (cur != NULL && SortOrder(comparator_function, ascending,
+                                    head->payload, cur->payload) > 0) {
+      LinkedListNode *next = cur->next;
+      cur->next = head;
+      head = cur;
+      cur = next;
+    }
+    *rest = cur;
+    return head;
+  }
+
+  LinkedListNode *tail = head;
+  while (cur != NULL && SortOrder(comparator_function, ascending,
+                                  tail->payload, cur->payload) <= 0) {
+    tail = cur;
+    cur = cur->next;
+  }
+  tail->next = NULL;
+  *rest = cur;
+  return head;
+}
+
+// Stably merges two sorted, NULL-terminated chains; on ties the node from
+// "a" (which came first in the list) goes first.  Only "next" pointers
+// are maintained.
+static LinkedListNode *MergeRuns(LinkedListNode *a, LinkedListNode *b,
+                                 bool ascending,
+                                 LLPayloadComparatorFnPtr comparator_function) {
+  LinkedListNode *head = NULL, **link = &head;
+
+  while (a != NULL && b != NULL) {
+    if (SortOrder(comparator_function, ascending,
+                  a->payload, b->payload) <= 0) {
+      *link = a;
+      a = a->next;
+    } else {
+      *link = b;
+      b = b->next;
+    }
+    link = &(*link)->next;
+  }
+  *link = (a != NULL) ? a : b;
+  return head;
+}
+
+// Sorts a NULL-terminated chain of nodes and returns its new head, using a
+// bottom-up natural merge sort.  We peel natural runs off the front of the
+// chain and merge them like a binary counter: pending[i] is either empty or
+// the merger of 2^i runs, so every merge is between runs of similar size
+// and the sort takes O(n log n) comparisons (just O(n) if the chain is
+// already sorted).  Nodes are relinked, never copied or allocated; only
+// "next" pointers are maintained.
+static LinkedListNode *SortChain(LinkedListNode *rest, bool ascending,
+                                 LLPayloadComparatorFnPtr comparator_function) {
+  LinkedListNode *pending[LL_SORT_MAX_PENDING] = { NULL };
+  LinkedListNode *run;
+  int i, num_pending = 0;
+
+  while (rest != NULL) {
+    run = TakeRun(&rest, ascending, comparator_function);
+    // Runs in higher slots came earlier in the chain, so they merge from
+    // the left.
+    for (i = 0; i < LL_SORT_MAX_PENDING && pending[i] != NULL; i++) {
+      run = MergeRuns(pending[i], run, ascending, comparator_function);
+      pending[i] = NULL;
+    }
+    Verify333(i < LL_SORT_MAX_PENDING);
+    pending[i] = run;
+    if (i >= num_pending) {
+      num_pending = i + 1;
+    }
+  }
+
+  // Fold what's left, newest (rightmost) first.
+  run = NULL;
+  for (i = 0; i < num_pending; i++) {
+    if (pending[i] != NULL) {
+      run = (run == NULL) ? pending[i]
+                          : MergeRuns(pending[i], run, ascending,
+                                      comparator_function);
+    }
+  }
+  return run;
+}
+
+// Makes the sorted chain starting at "head" the contents of "list",
+// restoring the prev pointers, head and tail.
+static void RelinkSorted(LinkedList *list, LinkedListNode *head) {
+  LinkedListNode *prev = NULL, *node;
+
+  for (node = head; node != NULL; node = node->next) {
+    node->prev = prev;
+    prev = node;
+  }
+  list->head = head;
+  list->tail = prev;
+}
+
+// One unit of work for LinkedList_SortParallel: sort the chain at "head",
+// or merge it with the chain at "other".  The result replaces "head".
+typedef struct {
+  LinkedListNode           *head;
+  LinkedListNode           *other;
+  bool                      ascending;
+  LLPayloadComparatorFnPtr  comparator_function;
+} LLSortTask;
+
+static void *SortTaskMain(void *arg) {
+  LLSortTask *task = (LLSortTask *)arg;
+  task->head = SortChain(task->head, task->ascending,
+                         task->comparator_function);
+  return NULL;
+}
+
+static void *MergeTaskMain(void *arg) {
+  LLSortTask *task = (LLSortTask *)arg;
+  task->head = MergeRuns(task->head, task->other, task->ascending,
+                         task->comparator_function);
+  return NULL;
+}
+
+// Runs task_main on each of tasks[0, num_tasks): all but the first on
+// threads of their own, the first on the calling thread.
+static void RunSortTasks(LLSortTask *tasks, int num_tasks,
+                         void *(*task_main)(void *)) {
+  pthread_t threads[LL_SORT_MAX_THREADS];
+  int i;
+
+  for (i = 1; i < num_tasks; i++) {
+    Verify333(pthread_create(&threads[i], NULL, task_main, &tasks[i]) == 0);
+  }
+  if (num_tasks > 0) {
+    task_main(&tasks[0]);
+  }
+  for (i = 1; i < num_tasks; i++) {
+    Verify333(pthread_join(threads[i], NULL) == 0);
+  }
+}
+
+// Unrolled lists are sorted by copying their payloads into a temporary,
+// node-based "shadow" list, whose nodes are one array, sorting that with
+// the regular code, and copying the sorted payloads back.  ShadowNodes
+// builds the shadow of "list", and returns its nodes for UnshadowNodes to
+// copy back and free.
+static LinkedListNode *ShadowNodes(LinkedList *list, LinkedList *shadow) {
+  int i, n = list->num_elements;
+  LinkedListNode *nodes;
+  LLIterator iter;
+
+  nodes = (LinkedListNode *)malloc(n * sizeof(LinkedListNode));
+  Verify333(nodes != NULL);
+  LLIteratorInit(&iter, list);
+  for (i = 0; i < n; i++, LLIterator_Next(&iter)) {
+    LLIterator_Get(&iter, &nodes[i].payload);
+    nodes[i].prev = (i > 0) ? &nodes[i - 1] : NULL;
+    nodes[i].next = (i < n - 1) ? &nodes[i + 1] : NULL;
+  }
+
+  memset(shadow, 0, sizeof(LinkedList));
+  shadow->num_elements = n;
+  shadow->head = &nodes[0];
+  shadow->tail = &nodes[n - 1];
+  return nodes;
+}
+
+static void UnshadowNodes(LinkedList *list, LinkedList *shadow,
+                          LinkedListNode *nodes) {
+  LinkedListNode *node = shadow->head;
+  LLIterator iter;
+
+  for (LLIteratorInit(&iter, list); LLIterator_IsValid(&iter);
+       LLIterator_Next(&iter)) {
+    iter.chunk->payloads[iter.slot] = node->payload;
+    node = node->next;
+  }
+  free(nodes);
+}
+
+// A (key, node) pair for LinkedList_SortByKey.
+typedef struct {
+  uint64_t        key;
+  LinkedListNode *node;
+} LLKeyedNode;
+
+// LinkedList_SortByKey sorts a byte of the key per pass.
+#define LL_RADIX_BITS 8
+#define LL_RADIX_SIZE (1 << LL_RADIX_BITS)
+#define LL_RADIX_PASSES (64 / LL_RADIX_BITS)
 
 ///////////////////////////////////////////////////////////////////////////////
 // LinkedList implementation.
@@ -29,15 +279,53 @@ LinkedList *LinkedList_Allocate(void) {
   ll->num_elements = 0;
   ll->head = NULL;
   ll->tail = NULL;
+  ll->pool = NULL;
+  ll->owns_pool = false;
+  ll->unrolled = false;
+  ll->head_chunk = NULL;
+  ll->tail_chunk = NULL;
+  ll->spare_chunk = NULL;
 
   // Return our newly minted linked list.
   return ll;
 }
 
+LinkedList *LinkedList_AllocatePooled(void) {
+  MemPool *pool = MemPool_Allocate(sizeof(LinkedListNode));
+  LinkedList *ll = LLAllocateWithPool(pool);
+  ll->owns_pool = true;
+  return ll;
+}
+
+LinkedList *LinkedList_AllocateUnrolled(void) {
+  LinkedList *ll = LinkedList_Allocate();
+  ll->unrolled = true;
+  return ll;
+}
+
 void LinkedList_Free(LinkedList *list,
                      LLPayloadFreeFnPtr payload_free_function) {
   Verify333(list != NULL);
-  Verify333(payload_free_function != NULL);
+
+  if (list->unrolled) {
+    UnrolledList_FreeChunks(list, payload_free_function);
+    free(list);
+    return;
+  }
+
+  if (list->owns_pool) {
+    // The nodes all live in our private pool, so we only need to visit them
+    // if their payloads need freeing; the pool is released in one go.
+    LinkedListNode *ln;
+    if (payload_free_function != NULL) {
+      for (ln = list->head; ln != NULL; ln = ln->next) {
+        payload_free_function(ln->payload);
+      }
+    }
+    MemPool_Free(list->pool);
+    free(list);
+    return;
+  }
 
   // STEP 2: sweep through the list and free all of the nodes' payloads
   // (using the payload_free_function supplied as an argument) and
@@ -45,13 +333,15 @@ void LinkedList_Free(LinkedList *list,
 
   LinkedListNode *temp = NULL;
   while (list->head != NULL) {
-    payload_free_function(list->head->payload);
+    if (payload_free_function != NULL) {
+      payload_free_function(list->head->payload);
+    }
     // format -> functname(parameters)
 
     temp = list->head;
     // if we would have freed list now we couldnt have moved forward
     list->head = list->head->next;
-    free(temp);
+    FreeNode(list, temp);
     // Free the node itself with temp here. We can use free because
     // a singular listnode is also a list
   }
@@ -68,9 +358,13 @@ int LinkedList_NumElements(LinkedList *list) {
 void LinkedList_Push(LinkedList *list, LLPayload_t payload) {
   Verify333(list != NULL);
 
+  if (list->unrolled) {
+    UnrolledList_Push(list, payload);
+    return;
+  }
+
   // Allocate space for the new node.
-  LinkedListNode *ln = (LinkedListNode *)malloc(sizeof(LinkedListNode));
-  Verify333(ln != NULL);
+  LinkedListNode *ln = NewNode(list);
 
   // Set the payload
   ln->payload = payload;
@@ -105,6 +399,9 @@ bool LinkedList_Pop(LinkedList *list, LLPayload_t *payload_ptr) {
   // and (b) the general case of a list with >=2 elements in it.
   // Be sure to call free() to deallocate the memory that was
   // previously allocated by LinkedList_Push().
+  if (list->unrolled) {
+    return UnrolledList_Pop(list, payload_ptr);
+  }
   if (list->num_elements == 0) {
     return false;
   }
@@ -129,7 +426,7 @@ bool LinkedList_Pop(LinkedList *list, LLPayload_t *payload_ptr) {
     list->tail = NULL;
   }
   // free head in both cases, could also do it here
-  free(temp);
+  FreeNode(list, temp);
 
   return true;  // you may need to change this return value
 }
@@ -137,6 +434,11 @@ bool LinkedList_Pop(LinkedList *list, LLPayload_t *payload_ptr) {
 void LinkedList_Append(LinkedList *list, LLPayload_t payload) {
   Verify333(list != NULL);
 
+  if (list->unrolled) {
+    UnrolledList_Append(list, payload);
+    return;
+  }
+
   // STEP 5: implement LinkedList_Append.  It's kind of like
   // LinkedList_Push, but obviously you need to add to the end
   // instead of the beginning.
@@ -145,8 +447,7 @@ void LinkedList_Append(LinkedList *list, LLPayload_t payload) {
   // There, the logic flips to add to the end of the list instead of begining
 
   // Allocate space for the new node.
-  LinkedListNode *ln = (LinkedListNode *)malloc(sizeof(LinkedListNode));
-  Verify333(ln != NULL);
+  LinkedListNode *ln = NewNode(list);
 
   // Set the payload
   ln->payload = payload;
@@ -177,31 +478,169 @@ void LinkedList_Sort(LinkedList *list, bool ascending,
     // No sorting needed.
     return;
   }
+  if (list->unrolled) {
+    LinkedList shadow;
+    LinkedListNode *nodes = ShadowNodes(list, &shadow);
+    LinkedList_Sort(&shadow, ascending, comparator_function);
+    UnshadowNodes(list, &shadow, nodes);
+    return;
+  }
 
-  // We'll implement bubblesort! Nnice and easy, and nice and slow :)
-  int swapped;
-  do {
-    LinkedListNode *curnode;
+  RelinkSorted(list, SortChain(list->head, ascending, comparator_function));
+}
 
-    swapped = 0;
-    curnode = list->head;
-    while (curnode->next != NULL) {
-      int compare_result =
-          comparator_function(curnode->payload, curnode->next->payload);
-      if (ascending) {
-        compare_result *= -1;
-      }
-      if (compare_result < 0) {
-        // Bubble-swap the payloads.
-        LLPayload_t tmp;
-        tmp = curnode->payload;
-        curnode->payload = curnode->next->payload;
-        curnode->next->payload = tmp;
-        swapped = 1;
-      }
-      curnode = curnode->next;
+void LinkedList_SortParallel(LinkedList *list, bool ascending,
+                             LLPayloadComparatorFnPtr comparator_function,
+                             int num_threads) {
+  LLSortTask tasks[LL_SORT_MAX_THREADS];
+  LinkedListNode *node;
+  int i, chunk, num_tasks;
+
+  Verify333(list != NULL);
+  if (num_threads <= 0) {
+    num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (num_threads > LL_SORT_MAX_THREADS) {
+    num_threads = LL_SORT_MAX_THREADS;
+  }
+  // Don't bother with threads for chunks too small to repay them.
+  if (num_threads > list->num_elements / LL_SORT_MIN_CHUNK) {
+    num_threads = list->num_elements / LL_SORT_MIN_CHUNK;
+  }
+  if (num_threads <= 1) {
+    LinkedList_Sort(list, ascending, comparator_function);
+    return;
+  }
+  if (list->unrolled) {
+    LinkedList shadow;
+    LinkedListNode *nodes = ShadowNodes(list, &shadow);
+    LinkedList_SortParallel(&shadow, ascending, comparator_function,
+                            num_threads);
+    UnshadowNodes(list, &shadow, nodes);
+    return;
+  }
+
+  // Cut the list into num_threads contiguous, NULL-terminated chunks of
+  // (nearly) equal length, and sort them concurrently.
+  chunk = list->num_elements / num_threads;
+  node = list->head;
+  for (i = 0; i < num_threads; i++) {
+    int len = (i == num_threads - 1) ? list->num_elements - i * chunk : chunk;
+    tasks[i].head = node;
+    tasks[i].other = NULL;
+    tasks[i].ascending = ascending;
+    tasks[i].comparator_function = comparator_function;
+    while (--len > 0) {
+      node = node->next;
+    }
+    LinkedListNode *next = node->next;
+    node->next = NULL;
+    node = next;
+  }
+  RunSortTasks(tasks, num_threads, &SortTaskMain);
+
+  // Merge neighbouring pairs of sorted chunks, a level at a time, with
+  // each level's merges running concurrently.  Pairing neighbours, left
+  // before right, keeps the sort stable.
+  for (num_tasks = num_threads; num_tasks > 1;
+       num_tasks = (num_tasks + 1) / 2) {
+    for (i = 0; i < num_tasks / 2; i++) {
+      tasks[i].head = tasks[2 * i].head;
+      tasks[i].other = tasks[2 * i + 1].head;
     }
-  } while (swapped);
+    if (num_tasks % 2 == 1) {
+      // The odd chunk out waits for the next level.
+      tasks[i].head = tasks[num_tasks - 1].head;
+      tasks[i].other = NULL;
+    }
+    RunSortTasks(tasks, num_tasks / 2, &MergeTaskMain);
+  }
+
+  RelinkSorted(list, tasks[0].head);
+}
+
+void LinkedList_SortByKey(LinkedList *list, bool ascending,
+                          LLPayloadKeyFnPtr key_function) {
+  size_t counts[LL_RADIX_PASSES][LL_RADIX_SIZE] = { { 0 } };
+  LLKeyedNode *keyed, *scratch, *tmp;
+  LinkedListNode *node, *prev;
+  uint64_t all_or = 0, all_and = ~(uint64_t)0;
+  size_t i, n;
+  int pass, digit;
+
+  Verify333(list != NULL);
+  if (list->num_elements < 2) {
+    return;
+  }
+  if (list->unrolled) {
+    LinkedList shadow;
+    LinkedListNode *nodes = ShadowNodes(list, &shadow);
+    LinkedList_SortByKey(&shadow, ascending, key_function);
+    UnshadowNodes(list, &shadow, nodes);
+    return;
+  }
+  n = (size_t)list->num_elements;
+  keyed = (LLKeyedNode *)malloc(2 * n * sizeof(LLKeyedNode));
+  Verify333(keyed != NULL);
+  scratch = keyed + n;
+
+  // Extract every key once, counting digits for all passes as we go.
+  // Sorting the complemented keys ascending sorts descending, and keeps
+  // equal keys in order.
+  for (i = 0, node = list->head; node != NULL; i++, node = node->next) {
+    uint64_t key = key_function(node->payload);
+    if (!ascending) {
+      key = ~key;
+    }
+    keyed[i].key = key;
+    keyed[i].node = node;
+    all_or |= key;
+    all_and &= key;
+    for (pass = 0; pass < LL_RADIX_PASSES; pass++) {
+      counts[pass][(key >> (pass * LL_RADIX_BITS)) & (LL_RADIX_SIZE - 1)]++;
+    }
+  }
+
+  // One stable counting-sort pass per byte, least significant first.
+  // Bytes that are the same in every key can't change the order, so we
+  // skip them; small keys need only a pass or two.
+  for (pass = 0; pass < LL_RADIX_PASSES; pass++) {
+    int shift = pass * LL_RADIX_BITS;
+    size_t offset = 0;
+
+    if ((((all_or ^ all_and) >> shift) & (LL_RADIX_SIZE - 1)) == 0) {
+      continue;
+    }
+    for (digit = 0; digit < LL_RADIX_SIZE; digit++) {
+      size_t count = counts[pass][digit];
+      counts[pass][digit] = offset;
+      offset += count;
+    }
+    for (i = 0; i < n; i++) {
+      digit = (int)((keyed[i].key >> shift) & (LL_RADIX_SIZE - 1));
+      scratch[counts[pass][digit]++] = keyed[i];
+    }
+    tmp = keyed;
+    keyed = scratch;
+    scratch = tmp;
+  }
+
+  // Relink the nodes in sorted order.
+  prev = NULL;
+  for (i = 0; i < n; i++) {
+    node = keyed[i].node;
+    node->prev = prev;
+    if (prev != NULL) {
+      prev->next = node;
+    }
+    prev = node;
+  }
+  prev->next = NULL;
+  list->head = keyed[0].node;
+  list->tail = prev;
+
+  // One of the two halves is the start of the allocation.
+  free(keyed < scratch ? keyed : scratch);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -215,8 +654,7 @@ LLIterator *LLIterator_Allocate(LinkedList *list) {
   Verify333(li != NULL);
 
   // Set up the iterator.
-  li->list = list;
-  li->node = list->head;
+  LLIteratorInit(li, list);
 
   return li;
 }
@@ -230,12 +668,17 @@ bool LLIterator_IsValid(LLIterator *iter) {
   Verify333(iter != NULL);
   Verify333(iter->list != NULL);
 
-  return (iter->node != NULL);
+  // At most one of these is ever non-NULL.
+  return (iter->node != NULL || iter->chunk != NULL);
 }
 
 bool LLIterator_Next(LLIterator *iter) {
   Verify333(iter != NULL);
   Verify333(iter->list != NULL);
+
+  if (iter->chunk != NULL) {
+    return UnrolledList_IteratorNext(iter);
+  }
   Verify333(iter->node != NULL);
 
   // STEP 6: try to advance iterator to the next node and return true if
@@ -257,6 +700,11 @@ bool LLIterator_Next(LLIterator *iter) {
 void LLIterator_Get(LLIterator *iter, LLPayload_t *payload) {
   Verify333(iter != NULL);
   Verify333(iter->list != NULL);
+
+  if (iter->chunk != NULL) {
+    *payload = iter->chunk->payloads[iter->slot];
+    return;
+  }
   Verify333(iter->node != NULL);
 
   *payload = iter->node->payload;
@@ -266,6 +714,10 @@ bool LLIterator_Remove(LLIterator *iter,
                        LLPayloadFreeFnPtr payload_free_function) {
   Verify333(iter != NULL);
   Verify333(iter->list != NULL);
+
+  if (iter->chunk != NULL) {
+    return UnrolledList_IteratorRemove(iter, payload_free_function);
+  }
   Verify333(iter->node != NULL);
 
   // STEP 7: implement LLIterator_Remove.  This is the most
@@ -296,7 +748,7 @@ bool LLIterator_Remove(LLIterator *iter,
 
     iter->list->num_elements = 0;
 
-    free(temp);
+    FreeNode(iter->list, temp);
     return false;
   } else if (iter->node == iter->list->head) {
     iter->node = iter->node->next;
@@ -327,7 +779,7 @@ bool LLIterator_Remove(LLIterator *iter,
   iter->list->num_elements--;
 
   // Must free temp pointer as other values have been deleted
-  free(temp);
+  FreeNode(iter->list, temp);
 
   return true;  // you may need to change this return value
 }
@@ -340,6 +792,9 @@ bool LLSlice(LinkedList *list, LLPayload_t *payload_ptr) {
   Verify333(list != NULL);
 
   // STEP 8: implement LLSlice.
+  if (list->unrolled) {
+    return UnrolledList_Slice(list, payload_ptr);
+  }
   if (list->num_elements == 0) {
     return false;
   }
@@ -367,9 +822,95 @@ bool LLSlice(LinkedList *list, LLPayload_t *payload_ptr) {
     // Could use head as head and tail are the same when there is one element
   }
   // free head in both cases, could also do it here
-  free(temp);
+  FreeNode(list, temp);
 
   return true;  // you may need to change this return value
 }
 
-void LLIteratorRewind(LLIterator *iter) { iter->node = iter->list->head; }
+void LLAppendNode(LinkedList *list, LinkedListNode *node) {
+  Verify333(list != NULL);
+  Verify333(node != NULL);
+  Verify333(!list->unrolled);
+
+  node->next = NULL;
+  node->prev = list->tail;
+  if (list->tail == NULL) {
+    list->head = node;
+  } else {
+    list->tail->next = node;
+  }
+  list->tail = node;
+  list->num_elements++;
+}
+
+LinkedList *LLAllocateWithPool(MemPool *pool) {
+  Verify333(pool != NULL);
+  LinkedList *ll = LinkedList_Allocate();
+  ll->pool = pool;
+  return ll;
+}
+
+void LLFreeShell(LinkedList *list) {
+  Verify333(list != NULL);
+  Verify333(list->pool != NULL && !list->owns_pool);
+  free(list);
+}
+
+void LLIteratorInit(LLIterator *iter, LinkedList *list) {
+  Verify333(iter != NULL);
+  Verify333(list != NULL);
+
+  iter->list = list;
+  LLIteratorRewind(iter);
+}
+
+void LLIteratorRewind(LLIterator *iter) {
+  if (iter->list->unrolled) {
+    UnrolledList_IteratorInit(iter);
+    return;
+  }
+  iter->node = iter->list->head;
+  iter->chunk = NULL;
+}
+
+bool LLMoveHeadToTail(LinkedList *from, LinkedList *to) {
+  Verify333(from != NULL);
+  Verify333(to != NULL);
+  Verify333(from->pool == to->pool);
+  Verify333(from->unrolled == to->unrolled);
+
+  if (from->unrolled) {
+    // Payloads don't have nodes of their own to move.
+    LLPayload_t payload;
+    if (!UnrolledList_Pop(from, &payload)) {
+      return false;
+    }
+    UnrolledList_Append(to, payload);
+    return true;
+  }
+  if (from->num_elements == 0) {
+    return false;
+  }
+
+  // Unlink the head, exactly as LinkedList_Pop does but without the free.
+  LinkedListNode *ln = from->head;
+  from->head = ln->next;
+  if (from->head == NULL) {
+    from->tail = NULL;
+  } else {
+    from->head->prev = NULL;
+  }
+  from->num_elements--;
+
+  // Relink it at the tail, exactly as LinkedList_Append does.
+  ln->next = NULL;
+  ln->prev = to->tail;
+  if (to->tail == NULL) {
+    to->head = ln;
+  } else {
+    to->tail->next = ln;
+  }
+  to->tail = ln;
+  to->num_elements++;
+  return true;
+}
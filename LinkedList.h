@@ -56,13 +56,45 @@ typedef void(*LLPayloadFreeFnPtr)(LLPayload_t payload);
 // - the newly-allocated linked list (never NULL).
 LinkedList* LinkedList_Allocate(void);
 
-// Free a linked list that was previously allocated by LinkedList_Allocate.
+// Allocate and return a new linked list whose nodes come from a private
+// slab allocator (see MemPool.h) instead of one malloc per node.  The list
+// behaves exactly like one from LinkedList_Allocate; freeing it releases
+// all of its nodes at once.
+//
+// Arguments: none.
+//
+// Returns:
+// - the newly-allocated linked list (never NULL).
+LinkedList* LinkedList_AllocatePooled(void);
+
+// Allocate and return a new, "unrolled" linked list.  Instead of one node
+// per payload, it stores its payloads in arrays of up to 29 at a time,
+// each array a cache-line-aligned, 256-byte chunk; adjacent payloads are
+// adjacent in memory.  That cuts memory use per payload from a node's 24
+// bytes (plus malloc's overhead) to as little as 9.  An LLIterator scan
+// no longer chases a pointer per payload, so it stays fast even for a
+// large list whose nodes would have been scattered around the heap.
+//
+// The list behaves exactly like one from LinkedList_Allocate.  The cost is
+// that LLIterator_Remove has to shift the rest of the removed payload's
+// chunk.
+//
+// Arguments: none.
+//
+// Returns:
+// - the newly-allocated linked list (never NULL).
+LinkedList* LinkedList_AllocateUnrolled(void);
+
+// Free a linked list that was previously allocated by LinkedList_Allocate,
+// LinkedList_AllocatePooled or LinkedList_AllocateUnrolled.
 //
 // Arguments:
 // - list: the linked list to free.  It is unsafe to use "list" after this
 //   function returns.
 // - payload_free_function: a pointer to a payload freeing function; see above
-//   for details on what this is.
+//   for details on what this is.  May be NULL if the payloads don't need
+//   freeing, in which case a pooled list is freed without visiting any of
+//   its nodes.
 void LinkedList_Free(LinkedList *list,
                      LLPayloadFreeFnPtr payload_free_function);
 
@@ -128,6 +160,46 @@ typedef int(*LLPayloadComparatorFnPtr)(LLPayload_t payload_a,
 void LinkedList_Sort(LinkedList *list, bool ascending,
                      LLPayloadComparatorFnPtr comparator_function);
 
+// Sorts a LinkedList in place using several threads.
+//
+// The list is cut into one contiguous chunk per thread, the chunks are
+// sorted concurrently, and then neighbouring chunks are merged pairwise,
+// again concurrently, until one sorted list remains.  The result is the
+// same as LinkedList_Sort's (in particular, the sort is stable).  Lists
+// too short to benefit are simply sorted on the calling thread.
+//
+// Arguments:
+// - list: the list to sort.
+// - ascending: if false, sorts descending; else sorts ascending.
+// - comparator_function:  this argument is a pointer to a payload comparator
+//   function; see above.  It is called from several threads at once, so it
+//   must be thread-safe.
+// - num_threads: the most threads to use (including the calling thread),
+//   or 0 to use one per online CPU.
+void LinkedList_SortParallel(LinkedList *list, bool ascending,
+                             LLPayloadComparatorFnPtr comparator_function,
+                             int num_threads);
+
+// When sorting a linked list by key, customers pass in a key extractor
+// instead of a comparator.  The function accepts a payload and returns
+// its sort key; payloads are ordered by comparing their keys as unsigned
+// integers.
+typedef uint64_t(*LLPayloadKeyFnPtr)(LLPayload_t payload);
+
+// Sorts a LinkedList in place by integer key.
+//
+// This is a radix sort: it calls key_function once per element and never
+// compares payloads, so it takes time linear in the length of the list
+// rather than O(n log n) comparator calls.  Like LinkedList_Sort it is
+// stable.  It needs a temporary array of two words per element.
+//
+// Arguments:
+// - list: the list to sort.
+// - ascending: if false, sorts descending; else sorts ascending.
+// - key_function: a pointer to a payload key extractor; see above.
+void LinkedList_SortByKey(LinkedList *list, bool ascending,
+                          LLPayloadKeyFnPtr key_function);
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Linked list iterator.
@@ -13,6 +13,7 @@
 #define HW1_LINKEDLIST_PRIV_H_
 
 #include "./LinkedList.h"  // for LinkedList and LLIterator
+#include "./MemPool.h"     // for MemPool
 
 // !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
 // Internal structures and helper functions for our LinkedList implementation.
@@ -41,10 +42,24 @@ typedef struct ll_node {
 // We provided a struct declaration (but not definition) in LinkedList.h;
 // this is the associated definition.  This struct contains metadata
 // about the linked list.
+//
+// If "pool" is non-NULL, nodes are allocated from (and freed back to) it
+// instead of malloc.  The pool is either private to this list (owns_pool)
+// or shared by several lists, eg, all of the chains in a HashTable.
+//
+// An unrolled list (see LinkedList_AllocateUnrolled) keeps its payloads in
+// chunks instead, defined in UnrolledList_priv.h; its head and tail are
+// always NULL, and it never has a pool.
 typedef struct ll {
   int               num_elements;  //  # elements in the list
   LinkedListNode   *head;  // head of linked list, or NULL if empty
   LinkedListNode   *tail;  // tail of linked list, or NULL if empty
+  MemPool          *pool;       // node allocator, or NULL for malloc
+  bool              owns_pool;  // free "pool" along with the list?
+  bool              unrolled;   // payloads live in chunks, not nodes?
+  struct ll_chunk  *head_chunk;  // an unrolled list's first chunk, or NULL
+  struct ll_chunk  *tail_chunk;  // an unrolled list's last chunk, or NULL
+  struct ll_chunk  *spare_chunk;  // an emptied chunk kept for reuse, or NULL
 } LinkedList;
 
 // A linked list iterator.
@@ -52,8 +67,11 @@ typedef struct ll {
 // We expose the struct declaration in LinkedList.h, but not the definition,
 // similar to what we did above for the linked list itself.
 typedef struct ll_iter {
-  LinkedList       *list;  // the list we're for
-  LinkedListNode   *node;  // the node we are at, or NULL if broken
+  LinkedList       *list;   // the list we're for
+  LinkedListNode   *node;   // the node we are at, or NULL if broken
+  struct ll_chunk  *chunk;  // in an unrolled list, the chunk we are at,
+                            // or NULL if broken
+  int               slot;   // ... and our index into its payloads
 } LLIterator;
 
 
@@ -72,11 +90,67 @@ typedef struct ll_iter {
 // - true: on success.
 bool LLSlice(LinkedList *list, LLPayload_t *payload_ptr);
 
+// Allocate a linked list whose nodes come from a pool shared with other
+// lists.  The caller keeps ownership of the pool and must free it only
+// after freeing every list that uses it.
+//
+// Arguments:
+// - pool: a MemPool whose objects are at least sizeof(LinkedListNode).
+//
+// Returns:
+// - the newly-allocated linked list (never NULL).
+LinkedList* LLAllocateWithPool(MemPool *pool);
+
+// Link a caller-allocated node onto the tail of a list.  This lets callers
+// build "intrusive" nodes that embed their payload right after the
+// LinkedListNode fields, saving a separate payload allocation.
+//
+// The node must have been allocated the way the list allocates its own
+// nodes (ie, with malloc, or from list->pool), because the list will free
+// it the same way; the LinkedListNode must be at offset 0 of the node.
+//
+// Arguments:
+// - list: the LinkedList to append to.
+// - node: the node to append; its payload must already be set.
+void LLAppendNode(LinkedList *list, LinkedListNode *node);
+
+// Free a list allocated by LLAllocateWithPool without visiting its nodes.
+// Only safe when the caller is about to free the shared pool itself, which
+// reclaims the nodes wholesale.
+//
+// Arguments:
+// - list: the list to free.  It is unsafe to use "list" after this
+//   function returns.
+void LLFreeShell(LinkedList *list);
+
+// Initialize an iterator in caller-provided storage (eg, a local variable)
+// to point at the front of a list.  Unlike LLIterator_Allocate, this does
+// not allocate; such an iterator must NOT be passed to LLIterator_Free.
+//
+// Arguments:
+// - iter: the iterator storage to initialize.
+// - list: the list to iterate over.
+void LLIteratorInit(LLIterator *iter, LinkedList *list);
+
 // Rewind an iterator to the front of its list.
 //
 // Arguments:
 // - iter: the iterator to rewind.
 void LLIteratorRewind(LLIterator *iter);
 
+// Unlink the head node of one list and relink it as the tail of another.
+// No memory is allocated or freed; the node (and its payload) simply
+// changes lists.  Both lists must allocate their nodes the same way (ie,
+// from malloc, or from the same shared pool).
+//
+// Arguments:
+// - from: the LinkedList to take the head node from.
+// - to: the LinkedList to append the node to.
+//
+// Returns:
+// - false: on failure (eg, "from" is empty).
+// - true: on success.
+bool LLMoveHeadToTail(LinkedList *from, LinkedList *to);
+
 
 #endif  // HW1_LINKEDLIST_PRIV_H_
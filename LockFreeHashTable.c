@@ -0,0 +1,597 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+// pthread_key_t and pthread_once_t are POSIX, not C17.
+#define _POSIX_C_SOURCE 200809L
+
+#include "LockFreeHashTable.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "CSE333.h"
+#include "HashTable.h"
+#include "HashTable_priv.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal structures.
+//
+// Unlike our other types, these live here rather than in a "private .h":
+// they are built on C11 atomics, which C++ code (like our unittests) can't
+// include.  The unittests stick to the public interface.
+
+// Segment 0 of the bucket directory holds this many buckets; each later
+// segment is twice the size of the one before, so the directory never
+// has to be copied as the table grows.
+#define LF_FIRST_SEGMENT_BITS 6
+#define LF_FIRST_SEGMENT_SIZE (1ULL << LF_FIRST_SEGMENT_BITS)
+#define LF_NUM_SEGMENTS 26
+#define LF_MAX_BUCKETS (LF_FIRST_SEGMENT_SIZE << (LF_NUM_SEGMENTS - 1))
+
+// The table doubles its number of buckets once it holds more than this
+// many elements per bucket.
+#define LF_MAX_LOAD 2
+
+// The low bit of a node's next pointer marks the node itself as being
+// unlinked from the list.
+#define LF_MARK ((uintptr_t)1)
+
+// A list node: either an element or a bucket's sentinel.
+typedef struct lf_node {
+  _Atomic(uintptr_t) next;     // next node (| LF_MARK once being unlinked)
+  uint64_t           so_key;   // split-order key; odd for elements
+  HTKey_t            key;      // the element's key; 0 for sentinels
+  _Atomic(HTValue_t) value;    // the element's value, or LF_TOMBSTONE
+  struct lf_node    *limbo;    // next node awaiting reclamation
+} LFNode;
+
+struct lfht {
+  // The bucket directory; segments are allocated on first use.
+  _Atomic(_Atomic(LFNode *) *) segments[LF_NUM_SEGMENTS];
+  _Atomic(uint64_t) num_buckets;   // a power of two
+  _Atomic(int64_t)  num_elements;
+  LFNode           *head;          // bucket 0's sentinel; heads the list
+};
+
+// An element whose value is LF_TOMBSTONE has been removed, even if it is
+// still linked into the list.  Its address can't be a customer's value.
+static char lf_tombstone;
+#define LF_TOMBSTONE ((HTValue_t)&lf_tombstone)
+
+///////////////////////////////////////////////////////////////////////////////
+// Epoch-based reclamation.
+//
+// Each thread announces the global epoch it saw when starting an
+// operation.  A node unlinked while the global epoch is "e" is tagged with
+// "e"; the epoch only advances once every active thread has announced the
+// current one, so by the time it reaches e + 2 every thread that could
+// have reached the node has finished, and the node can be freed.  Each
+// thread keeps its own unlinked nodes in three "limbo" lists, one per
+// epoch modulo 3.
+//
+// When a thread exits, its limbo lists are moved onto a global "orphan"
+// list, again one per epoch modulo 3, so that they are freed by whichever
+// thread next advances the epoch far enough, rather than waiting for
+// another thread to claim the exiting thread's record.
+
+// Try to advance the global epoch after every this many retired nodes.
+#define EBR_ADVANCE_EVERY 64
+
+typedef struct ebr_record {
+  _Atomic(uint64_t)  state;     // (announced epoch << 1) | active
+  atomic_bool        in_use;    // owned by a live thread?
+  struct ebr_record *next;      // next record; fixed once published
+  uint64_t           epoch;     // the last epoch the owner saw
+  LFNode            *limbo[3];  // retired nodes, by epoch modulo 3
+  int                num_retired;
+} EBRRecord;
+
+static _Atomic(uint64_t) ebr_global_epoch;
+static _Atomic(EBRRecord *) ebr_records;
+static _Atomic(LFNode *) ebr_orphans[3];  // exited threads' retired nodes
+static pthread_once_t ebr_once = PTHREAD_ONCE_INIT;
+static pthread_key_t ebr_key;
+static _Thread_local EBRRecord *ebr_self;
+
+// Hands a record back for reuse when its thread exits, first orphaning
+// any nodes still in its limbo lists.
+static void EBRReleaseRecord(void *record) {
+  EBRRecord *self = (EBRRecord *)record;
+  LFNode *head = NULL, *tail = NULL;
+  uint64_t epoch;
+  int i;
+
+  // Every node was retired at or before the current epoch, so tagging
+  // them all with it errs only on the side of freeing them late.
+  epoch = atomic_load(&ebr_global_epoch);
+  for (i = 0; i < 3; i++) {
+    LFNode *node = self->limbo[i];
+    if (node == NULL) {
+      continue;
+    }
+    if (head == NULL) {
+      head = node;
+    } else {
+      tail->limbo = node;
+    }
+    for (tail = node; tail->limbo != NULL; tail = tail->limbo) {
+    }
+    self->limbo[i] = NULL;
+  }
+  if (head != NULL) {
+    _Atomic(LFNode *) *orphans = &ebr_orphans[epoch % 3];
+    tail->limbo = atomic_load(orphans);
+    while (!atomic_compare_exchange_weak(orphans, &tail->limbo, head)) {
+    }
+  }
+  self->num_retired = 0;
+  atomic_store(&self->in_use, false);
+}
+
+static void EBRInitKey(void) {
+  Verify333(pthread_key_create(&ebr_key, EBRReleaseRecord) == 0);
+}
+
+// Returns the calling thread's record, claiming one on first use.
+static EBRRecord *EBRSelf(void) {
+  EBRRecord *record;
+
+  if (ebr_self != NULL) {
+    return ebr_self;
+  }
+  Verify333(pthread_once(&ebr_once, EBRInitKey) == 0);
+
+  for (record = atomic_load(&ebr_records); record != NULL;
+       record = record->next) {
+    bool free_record = false;
+    if (atomic_compare_exchange_strong(&record->in_use, &free_record, true)) {
+      break;
+    }
+  }
+  if (record == NULL) {
+    record = (EBRRecord *)calloc(1, sizeof(EBRRecord));
+    Verify333(record != NULL);
+    atomic_init(&record->in_use, true);
+    record->next = atomic_load(&ebr_records);
+    while (!atomic_compare_exchange_weak(&ebr_records, &record->next,
+                                         record)) {
+    }
+  }
+  Verify333(pthread_setspecific(ebr_key, record) == 0);
+  ebr_self = record;
+  return record;
+}
+
+static void EBRFreeList(LFNode *node) {
+  while (node != NULL) {
+    LFNode *next = node->limbo;
+    free(node);
+    node = next;
+  }
+}
+
+// Advances the global epoch if every active thread has seen the current
+// one, then frees the orphans that have become safe to free.
+//
+// The caller is itself active, announcing the old epoch, so the epoch
+// can't advance again, and an exiting thread can't tag its nodes with
+// epoch + 2 (which shares their list), before it has taken those orphans.
+static void EBRTryAdvance(void) {
+  uint64_t epoch = atomic_load(&ebr_global_epoch);
+  EBRRecord *record;
+
+  for (record = atomic_load(&ebr_records); record != NULL;
+       record = record->next) {
+    uint64_t state = atomic_load(&record->state);
+    if ((state & 1) && (state >> 1) != epoch) {
+      return;
+    }
+  }
+  if (atomic_compare_exchange_strong(&ebr_global_epoch, &epoch,
+                                     epoch + 1)) {
+    // As in EBREnter: at epoch + 1, orphan list (epoch + 2) % 3 holds
+    // nodes tagged at most epoch - 1.
+    EBRFreeList(atomic_exchange(&ebr_orphans[(epoch + 2) % 3], NULL));
+  }
+}
+
+// Marks the start of an operation; until EBRExit, no node the operation
+// can reach will be freed.
+static void EBREnter(void) {
+  EBRRecord *self = EBRSelf();
+  uint64_t epoch = atomic_load(&ebr_global_epoch);
+  uint64_t e;
+
+  atomic_store(&self->state, (epoch << 1) | 1);
+
+  // For each epoch e we've moved through, limbo list (e + 1) % 3 holds
+  // nodes tagged at most e - 2, which are now safe to free.
+  for (e = self->epoch + 1; e <= epoch && e <= self->epoch + 3; e++) {
+    EBRFreeList(self->limbo[(e + 1) % 3]);
+    self->limbo[(e + 1) % 3] = NULL;
+  }
+  self->epoch = epoch;
+}
+
+static void EBRExit(void) {
+  atomic_store(&ebr_self->state, ebr_self->epoch << 1);
+}
+
+// Hands a node that has just been unlinked to the reclaimer.
+static void EBRRetire(LFNode *node) {
+  EBRRecord *self = ebr_self;
+  int slot = (int)(atomic_load(&ebr_global_epoch) % 3);
+
+  node->limbo = self->limbo[slot];
+  self->limbo[slot] = node;
+  if (++self->num_retired >= EBR_ADVANCE_EVERY) {
+    self->num_retired = 0;
+    EBRTryAdvance();
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+
+static inline LFNode *NodePtr(uintptr_t next) {
+  return (LFNode *)(next & ~LF_MARK);
+}
+
+static inline bool IsMarked(uintptr_t next) {
+  return (next & LF_MARK) != 0;
+}
+
+static uint64_t ReverseBits(uint64_t x) {
+  x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+  x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+  x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+  return __builtin_bswap64(x);
+}
+
+// Split-order keys.  An element sorts just after its bucket's sentinel
+// and before the sentinel of any bucket split off from it later.
+static inline uint64_t ElementKey(uint64_t hash) {
+  return ReverseBits(hash) | 1;
+}
+
+static inline uint64_t SentinelKey(uint64_t bucket) {
+  return ReverseBits(bucket);
+}
+
+// The list order.  Distinct keys can share a split-order key (the hash's
+// top bit is lost to the "| 1"), so ties are broken by the key itself.
+static inline int Compare(LFNode *node, uint64_t so_key, HTKey_t key) {
+  if (node->so_key != so_key) {
+    return node->so_key < so_key ? -1 : 1;
+  }
+  if (node->key != key) {
+    return node->key < key ? -1 : 1;
+  }
+  return 0;
+}
+
+static LFNode *NewNode(uint64_t so_key, HTKey_t key, HTValue_t value) {
+  LFNode *node = (LFNode *)malloc(sizeof(LFNode));
+  Verify333(node != NULL);
+  atomic_init(&node->next, (uintptr_t)0);
+  node->so_key = so_key;
+  node->key = key;
+  atomic_init(&node->value, value);
+  node->limbo = NULL;
+  return node;
+}
+
+// Searches the list, starting after "start", for the first node not less
+// than (so_key, key).  On return *prev_out is the link that points at it and
+// *cur_out is the node (NULL at the end of the list).  Returns true iff the
+// node matches exactly.
+//
+// Along the way we finish unlinking any removed nodes, so the list we
+// report contains no removed elements.
+static bool ListFind(LFNode *start, uint64_t so_key, HTKey_t key,
+                     _Atomic(uintptr_t) **prev_out, LFNode **cur_out) {
+  _Atomic(uintptr_t) *prev;
+  LFNode *cur;
+
+ retry:
+  prev = &start->next;
+  cur = NodePtr(atomic_load(prev));
+  while (cur != NULL) {
+    uintptr_t next = atomic_load(&cur->next);
+
+    if (!IsMarked(next) && atomic_load(&cur->value) == LF_TOMBSTONE) {
+      // Removed but not yet marked; help the remover along.
+      atomic_fetch_or(&cur->next, LF_MARK);
+      continue;
+    }
+    if (atomic_load(prev) != (uintptr_t)cur) {
+      // "prev" was changed (or its node marked) under us.
+      goto retry;
+    }
+    if (IsMarked(next)) {
+      uintptr_t expected = (uintptr_t)cur;
+      if (!atomic_compare_exchange_strong(prev, &expected,
+                                          (uintptr_t)NodePtr(next))) {
+        goto retry;
+      }
+      EBRRetire(cur);
+      cur = NodePtr(next);
+      continue;
+    }
+
+    int cmp = Compare(cur, so_key, key);
+    if (cmp >= 0) {
+      *prev_out = prev;
+      *cur_out = cur;
+      return cmp == 0;
+    }
+    prev = &cur->next;
+    cur = NodePtr(next);
+  }
+  *prev_out = prev;
+  *cur_out = NULL;
+  return false;
+}
+
+// Links "node" into the list after "start", unless a matching node is
+// already there.  Returns whichever node ends up in the list.
+static LFNode *ListInsert(LFNode *start, LFNode *node) {
+  for (;;) {
+    _Atomic(uintptr_t) *prev;
+    LFNode *cur;
+    uintptr_t expected;
+
+    if (ListFind(start, node->so_key, node->key, &prev, &cur)) {
+      return cur;
+    }
+    atomic_store(&node->next, (uintptr_t)cur);
+    expected = (uintptr_t)cur;
+    if (atomic_compare_exchange_strong(prev, &expected, (uintptr_t)node)) {
+      return node;
+    }
+  }
+}
+
+// Returns the directory slot for "bucket", allocating its segment if
+// need be.
+static _Atomic(LFNode *) *BucketSlot(LockFreeHashTable *table,
+                                     uint64_t bucket) {
+  int segment = 0, top;
+  uint64_t offset = bucket, size = LF_FIRST_SEGMENT_SIZE;
+  _Atomic(LFNode *) *slots;
+
+  if (bucket >= LF_FIRST_SEGMENT_SIZE) {
+    top = 63 - __builtin_clzll(bucket);
+    segment = top - LF_FIRST_SEGMENT_BITS + 1;
+    size = 1ULL << top;
+    offset = bucket - size;
+  }
+
+  slots = atomic_load(&table->segments[segment]);
+  if (slots == NULL) {
+    // Racing threads may each allocate the segment; one of them wins.
+    _Atomic(LFNode *) *fresh =
+        (_Atomic(LFNode *) *)calloc(size, sizeof(_Atomic(LFNode *)));
+    Verify333(fresh != NULL);
+    if (atomic_compare_exchange_strong(&table->segments[segment], &slots,
+                                       fresh)) {
+      slots = fresh;
+    } else {
+      free(fresh);
+    }
+  }
+  return &slots[offset];
+}
+
+// Returns bucket's sentinel, first splicing it into the list (after its
+// parent bucket's sentinel) if no thread has done so yet.
+static LFNode *BucketSentinel(LockFreeHashTable *table, uint64_t bucket) {
+  _Atomic(LFNode *) *slot = BucketSlot(table, bucket);
+  LFNode *sentinel = atomic_load(slot);
+  LFNode *parent, *fresh;
+
+  if (sentinel != NULL) {
+    return sentinel;
+  }
+
+  // The parent is the bucket this one was split from: the same bucket
+  // with its top bit cleared.  Bucket 0 always exists, so this recursion
+  // ends.
+  parent = BucketSentinel(table,
+                          bucket & ~(1ULL << (63 - __builtin_clzll(bucket))));
+  fresh = NewNode(SentinelKey(bucket), 0, NULL);
+  sentinel = ListInsert(parent, fresh);
+  if (sentinel != fresh) {
+    // Another thread got there first; ours was never published.
+    free(fresh);
+  }
+  atomic_store(slot, sentinel);
+  return sentinel;
+}
+
+// Returns the sentinel of the bucket "hash" currently falls in.
+static LFNode *SentinelForHash(LockFreeHashTable *table, uint64_t hash) {
+  uint64_t num_buckets = atomic_load(&table->num_buckets);
+  return BucketSentinel(table, hash & (num_buckets - 1));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// LockFreeHashTable implementation.
+
+LockFreeHashTable *LockFreeHashTable_Allocate(int num_buckets) {
+  LockFreeHashTable *table;
+  uint64_t buckets = 1;
+  int i;
+
+  Verify333(num_buckets > 0);
+  while (buckets < (uint64_t)num_buckets && buckets < LF_MAX_BUCKETS) {
+    buckets *= 2;
+  }
+
+  table = (LockFreeHashTable *)malloc(sizeof(LockFreeHashTable));
+  Verify333(table != NULL);
+  for (i = 0; i < LF_NUM_SEGMENTS; i++) {
+    atomic_init(&table->segments[i], NULL);
+  }
+  atomic_init(&table->num_buckets, buckets);
+  atomic_init(&table->num_elements, 0);
+
+  table->head = NewNode(SentinelKey(0), 0, NULL);
+  atomic_store(BucketSlot(table, 0), table->head);
+  return table;
+}
+
+void LockFreeHashTable_Free(LockFreeHashTable *table,
+                            ValueFreeFnPtr value_free_function) {
+  LFNode *node;
+  int i;
+
+  Verify333(table != NULL);
+  node = table->head;
+  while (node != NULL) {
+    LFNode *next = NodePtr(atomic_load(&node->next));
+    HTValue_t value = atomic_load(&node->value);
+    if ((node->so_key & 1) && value != LF_TOMBSTONE &&
+        value_free_function != NULL) {
+      value_free_function(value);
+    }
+    free(node);
+    node = next;
+  }
+  for (i = 0; i < LF_NUM_SEGMENTS; i++) {
+    free(atomic_load(&table->segments[i]));
+  }
+  free(table);
+}
+
+int LockFreeHashTable_NumElements(LockFreeHashTable *table) {
+  Verify333(table != NULL);
+  return (int)atomic_load(&table->num_elements);
+}
+
+int LockFreeHashTable_NumBuckets(LockFreeHashTable *table) {
+  Verify333(table != NULL);
+  return (int)atomic_load(&table->num_buckets);
+}
+
+bool LockFreeHashTable_Insert(LockFreeHashTable *table,
+                              HTKeyValue_t newkeyvalue,
+                              HTKeyValue_t *oldkeyvalue) {
+  uint64_t hash, num_buckets;
+  LFNode *node, *found;
+  int64_t num_elements;
+
+  Verify333(table != NULL);
+  Verify333(newkeyvalue.value != LF_TOMBSTONE);
+  hash = HTMixKey(newkeyvalue.key);
+  node = NewNode(ElementKey(hash), newkeyvalue.key, newkeyvalue.value);
+
+  EBREnter();
+  for (;;) {
+    found = ListInsert(SentinelForHash(table, hash), node);
+    if (found == node) {
+      break;
+    }
+
+    // The key is already present: swap in the new value, unless the old
+    // element is removed first, in which case we try again.
+    HTValue_t old = atomic_load(&found->value);
+    while (old != LF_TOMBSTONE) {
+      if (atomic_compare_exchange_weak(&found->value, &old,
+                                       newkeyvalue.value)) {
+        EBRExit();
+        free(node);
+        oldkeyvalue->key = newkeyvalue.key;
+        oldkeyvalue->value = old;
+        return true;
+      }
+    }
+  }
+
+  // A new element.  If the table is now too full, double the number of
+  // buckets; the new buckets' sentinels are spliced in lazily.
+  num_elements = atomic_fetch_add(&table->num_elements, 1) + 1;
+  num_buckets = atomic_load(&table->num_buckets);
+  if ((uint64_t)num_elements > num_buckets * LF_MAX_LOAD &&
+      num_buckets < LF_MAX_BUCKETS) {
+    atomic_compare_exchange_strong(&table->num_buckets, &num_buckets,
+                                   num_buckets * 2);
+  }
+  EBRExit();
+  return false;
+}
+
+bool LockFreeHashTable_Find(LockFreeHashTable *table, HTKey_t key,
+                            HTKeyValue_t *keyvalue) {
+  uint64_t hash;
+  _Atomic(uintptr_t) *prev;
+  LFNode *cur;
+  HTValue_t value = LF_TOMBSTONE;
+
+  Verify333(table != NULL);
+  hash = HTMixKey(key);
+  EBREnter();
+  if (ListFind(SentinelForHash(table, hash), ElementKey(hash), key, &prev,
+               &cur)) {
+    value = atomic_load(&cur->value);
+  }
+  EBRExit();
+
+  if (value == LF_TOMBSTONE) {
+    return false;
+  }
+  keyvalue->key = key;
+  keyvalue->value = value;
+  return true;
+}
+
+bool LockFreeHashTable_Remove(LockFreeHashTable *table, HTKey_t key,
+                              HTKeyValue_t *keyvalue) {
+  uint64_t hash;
+  _Atomic(uintptr_t) *prev;
+  LFNode *sentinel, *cur;
+  HTValue_t value;
+
+  Verify333(table != NULL);
+  hash = HTMixKey(key);
+  EBREnter();
+  sentinel = SentinelForHash(table, hash);
+  for (;;) {
+    if (!ListFind(sentinel, ElementKey(hash), key, &prev, &cur)) {
+      EBRExit();
+      return false;
+    }
+
+    // Swapping in the tombstone is what removes the element; marking and
+    // unlinking the node afterwards is just cleanup.  If someone else's
+    // tombstone beat ours, search again: ListFind unlinks their node.
+    value = atomic_load(&cur->value);
+    while (value != LF_TOMBSTONE) {
+      if (atomic_compare_exchange_weak(&cur->value, &value, LF_TOMBSTONE)) {
+        break;
+      }
+    }
+    if (value != LF_TOMBSTONE) {
+      break;
+    }
+  }
+
+  atomic_fetch_sub(&table->num_elements, 1);
+  atomic_fetch_or(&cur->next, LF_MARK);
+  ListFind(sentinel, ElementKey(hash), key, &prev, &cur);
+  EBRExit();
+
+  keyvalue->key = key;
+  keyvalue->value = value;
+  return true;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_LOCKFREEHASHTABLE_H_
+#define HW1_LOCKFREEHASHTABLE_H_
+
+#include <stdbool.h>    // for bool type (true, false)
+
+#include "./HashTable.h"  // for HTKey_t, HTKeyValue_t, ValueFreeFnPtr
+
+///////////////////////////////////////////////////////////////////////////////
+// A LockFreeHashTable is a hash table that many threads may use at once
+// without ever taking a lock.
+//
+// It is a "split-ordered list" (Shalev and Shavit, 2006): every element
+// lives in one lock-free sorted linked list, ordered by the bit-reversal of
+// its hash, and each bucket is just a pointer to a sentinel node partway
+// along that list.  Because of the ordering, doubling the number of buckets
+// only adds new sentinels; no element ever moves, so the table grows
+// without rehashing and without stalling readers.
+//
+// Removed nodes can't be freed right away, since another thread may still
+// be looking at them.  They are handed to an epoch-based reclaimer, which
+// frees them once every thread that could have seen them has finished its
+// operation.
+//
+// Insert, Find and Remove have the same contracts as their HashTable
+// counterparts, and each takes effect atomically.  As with
+// ConcurrentHashTable, Find hands back a copy of the (key,value) pair, so
+// callers sharing values across threads must manage their lifetime.
+typedef struct lfht LockFreeHashTable;
+
+// Allocate and return a new, empty table.
+//
+// Arguments:
+// - num_buckets: the number of buckets to start with (rounded up to a
+//   power of two); MUST be greater than zero.
+//
+// Returns:
+// - the newly-allocated table (never NULL).
+LockFreeHashTable* LockFreeHashTable_Allocate(int num_buckets);
+
+// Free a table and everything it contains.  Unlike the other functions,
+// this is NOT thread-safe: no other thread may be using the table.
+//
+// Arguments:
+// - table: the table to free.
+// - value_free_function: invoked once per value; may be NULL.
+void LockFreeHashTable_Free(LockFreeHashTable *table,
+                            ValueFreeFnPtr value_free_function);
+
+// Returns the number of elements in the table.  While other threads are
+// modifying the table, this is only a snapshot.
+int LockFreeHashTable_NumElements(LockFreeHashTable *table);
+
+// Returns the number of buckets the table is currently using.
+int LockFreeHashTable_NumBuckets(LockFreeHashTable *table);
+
+// Lock-free versions of HashTable_Insert, HashTable_Find and
+// HashTable_Remove; see HashTable.h for their contracts.
+bool LockFreeHashTable_Insert(LockFreeHashTable *table,
+                              HTKeyValue_t newkeyvalue,
+                              HTKeyValue_t *oldkeyvalue);
+bool LockFreeHashTable_Find(LockFreeHashTable *table,
+                            HTKey_t key,
+                            HTKeyValue_t *keyvalue);
+bool LockFreeHashTable_Remove(LockFreeHashTable *table,
+                              HTKey_t key,
+                              HTKeyValue_t *keyvalue);
+
+#endif  // HW1_LOCKFREEHASHTABLE_H_
@@ -0,0 +1,111 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "MemPool.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "CSE333.h"
+#include "MemPool_priv.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+
+// Every object (and the first object in each slab) is aligned to this.
+#define MEMPOOL_ALIGN (sizeof(max_align_t))
+
+static size_t RoundUp(size_t n) {
+  return (n + MEMPOOL_ALIGN - 1) / MEMPOOL_ALIGN * MEMPOOL_ALIGN;
+}
+
+// Allocates a new slab and makes it the bump-allocation target.
+static void AddSlab(MemPool *pool) {
+  size_t header = RoundUp(sizeof(MemPoolSlab));
+  size_t bytes = header + pool->object_size * pool->slab_objects;
+  MemPoolSlab *slab = (MemPoolSlab *)malloc(bytes);
+  Verify333(slab != NULL);
+
+  slab->next = pool->slabs;
+  pool->slabs = slab;
+  pool->num_slabs++;
+  pool->bump_next = (char *)slab + header;
+  pool->bump_end = (char *)slab + bytes;
+
+  if (pool->slab_objects < MEMPOOL_MAX_SLAB_OBJECTS) {
+    pool->slab_objects *= 2;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// MemPool implementation.
+
+MemPool *MemPool_Allocate(size_t object_size) {
+  Verify333(object_size > 0);
+
+  MemPool *pool = (MemPool *)malloc(sizeof(MemPool));
+  Verify333(pool != NULL);
+
+  // Freed objects hold the free-list link, so they must fit a pointer.
+  if (object_size < sizeof(void *)) {
+    object_size = sizeof(void *);
+  }
+  pool->object_size = RoundUp(object_size);
+  pool->free_list = NULL;
+  pool->bump_next = NULL;
+  pool->bump_end = NULL;
+  pool->slabs = NULL;
+  pool->num_slabs = 0;
+  pool->slab_objects = MEMPOOL_FIRST_SLAB_OBJECTS;
+  pool->num_live = 0;
+  return pool;
+}
+
+void MemPool_Free(MemPool *pool) {
+  Verify333(pool != NULL);
+
+  // One free() per slab, no matter how many objects are outstanding.
+  while (pool->slabs != NULL) {
+    MemPoolSlab *next = pool->slabs->next;
+    free(pool->slabs);
+    pool->slabs = next;
+  }
+  free(pool);
+}
+
+void *MemPool_AllocObject(MemPool *pool) {
+  void *object;
+
+  Verify333(pool != NULL);
+
+  if (pool->free_list != NULL) {
+    // Reuse the most recently freed object; it's likely still in cache.
+    object = pool->free_list;
+    pool->free_list = *(void **)object;
+  } else {
+    if (pool->bump_next == pool->bump_end) {
+      AddSlab(pool);
+    }
+    object = pool->bump_next;
+    pool->bump_next += pool->object_size;
+  }
+  pool->num_live++;
+  return object;
+}
+
+void MemPool_FreeObject(MemPool *pool, void *object) {
+  Verify333(pool != NULL);
+  Verify333(object != NULL);
+
+  *(void **)object = pool->free_list;
+  pool->free_list = object;
+  pool->num_live--;
+}
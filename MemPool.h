@@ -0,0 +1,65 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_MEMPOOL_H_
+#define HW1_MEMPOOL_H_
+
+#include <stddef.h>     // for size_t
+
+///////////////////////////////////////////////////////////////////////////////
+// A MemPool is a slab allocator for fixed-size objects.
+//
+// Objects are carved out of large slabs obtained from malloc, and freed
+// objects go onto a free list for reuse, so allocating and freeing an
+// object is a handful of instructions and never calls into malloc.  The
+// slabs are only returned to the system when the whole pool is freed,
+// which takes time proportional to the number of slabs, not objects.
+//
+// LinkedList and HashTable can opt into a pool for their internal nodes;
+// see LinkedList_AllocatePooled and HTOptions.use_pool.
+//
+// As with our other types, the struct is defined in MemPool_priv.h.
+typedef struct mempool MemPool;
+
+// Allocate and return a new, empty pool.
+//
+// Arguments:
+// - object_size: the size in bytes of every object the pool hands out;
+//   MUST be greater than zero.
+//
+// Returns:
+// - the newly-allocated pool (never NULL).
+MemPool* MemPool_Allocate(size_t object_size);
+
+// Free a pool and every slab it owns.  Any objects still handed out
+// become invalid; it is unsafe to use "pool" after this function returns.
+//
+// Arguments:
+// - pool: the pool to free.
+void MemPool_Free(MemPool *pool);
+
+// Hand out one object.  Its contents are uninitialized.
+//
+// Arguments:
+// - pool: the pool to allocate from.
+//
+// Returns:
+// - a pointer to object_size bytes, aligned for any type (never NULL).
+void* MemPool_AllocObject(MemPool *pool);
+
+// Return an object to the pool it was allocated from.
+//
+// Arguments:
+// - pool: the pool "object" was allocated from.
+// - object: the object to free.  Don't use it after freeing it.
+void MemPool_FreeObject(MemPool *pool, void *object);
+
+#endif  // HW1_MEMPOOL_H_
@@ -0,0 +1,52 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_MEMPOOL_PRIV_H_
+#define HW1_MEMPOOL_PRIV_H_
+
+#include <stddef.h>  // for size_t
+
+#include "./MemPool.h"
+
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+// Internal structures for our MemPool implementation, broken out into a
+// "private .h" so that our unittests can peek inside.
+//
+// Customers should not include this file or assume anything based on
+// its contents.
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+// The first slab holds this many objects; each later slab holds twice as
+// many as the one before, up to the maximum.  Small pools stay small, and
+// big pools need few slabs.
+#define MEMPOOL_FIRST_SLAB_OBJECTS 16
+#define MEMPOOL_MAX_SLAB_OBJECTS   4096
+
+// A slab is a single malloc'd block: this header followed by the objects.
+typedef struct mempool_slab {
+  struct mempool_slab *next;  // next (older) slab, or NULL
+} MemPoolSlab;
+
+// The pool.  Freed objects are threaded onto free_list through their first
+// word.  Objects that have never been handed out are bump-allocated from
+// [bump_next, bump_end) in the newest slab.
+typedef struct mempool {
+  size_t       object_size;   // rounded up to a multiple of the alignment
+  void        *free_list;     // most recently freed object, or NULL
+  char        *bump_next;     // next never-used object in the newest slab
+  char        *bump_end;      // end of the newest slab
+  MemPoolSlab *slabs;         // newest slab, or NULL
+  int          num_slabs;     // # of slabs allocated
+  int          slab_objects;  // # of objects the next slab will hold
+  int          num_live;      // # of objects currently handed out
+} MemPool;
+
+#endif  // HW1_MEMPOOL_PRIV_H_
@@ -0,0 +1,196 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+// sysconf is POSIX, not C17.
+#define _POSIX_C_SOURCE 200809L
+
+#include "ShardedHashTable.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "CSE333.h"
+#include "HashTable.h"
+#include "HashTable_priv.h"
+#include "ShardedHashTable_priv.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+
+// Locks the shard holding "key" and returns it.
+static SHTShard *LockShard(ShardedHashTable *table, HTKey_t key) {
+  SHTShard *shard = &table->shards[ShardedHashTable_ShardOf(table, key)];
+  Verify333(pthread_mutex_lock(&shard->lock) == 0);
+  return shard;
+}
+
+static void UnlockShard(SHTShard *shard) {
+  Verify333(pthread_mutex_unlock(&shard->lock) == 0);
+}
+
+// A sharded table iterator's next_table: the table of the shard after
+// the current one, or NULL (staying put, so that calling HTIterator_Next
+// again is harmless) after the last.
+static HashTable *NextShardTable(HTIterator *iter) {
+  ShardedHashTable *table = (ShardedHashTable *)iter->tables;
+
+  if (iter->table_idx + 1 >= table->num_shards) {
+    return NULL;
+  }
+  return table->shards[++iter->table_idx].table;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ShardedHashTable implementation.
+
+ShardedHashTable *ShardedHashTable_Allocate(int num_shards,
+                                            int num_buckets) {
+  ShardedHashTable *table;
+  int i;
+
+  Verify333(num_buckets > 0);
+  if (num_shards <= 0) {
+    num_shards = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (num_shards < 1) {
+    num_shards = 1;
+  } else if (num_shards > SHT_MAX_SHARDS) {
+    num_shards = SHT_MAX_SHARDS;
+  }
+
+  table = (ShardedHashTable *)malloc(sizeof(ShardedHashTable));
+  Verify333(table != NULL);
+  table->shard_bits = 0;
+  while ((1 << table->shard_bits) < num_shards) {
+    table->shard_bits++;
+  }
+  table->num_shards = 1 << table->shard_bits;
+  table->shards = (SHTShard *)aligned_alloc(
+      SHT_CACHE_LINE, table->num_shards * sizeof(SHTShard));
+  Verify333(table->shards != NULL);
+
+  for (i = 0; i < table->num_shards; i++) {
+    SHTShard *shard = &table->shards[i];
+    Verify333(pthread_mutex_init(&shard->lock, NULL) == 0);
+    shard->table = HashTable_Allocate(
+        (num_buckets + table->num_shards - 1) / table->num_shards);
+  }
+  return table;
+}
+
+void ShardedHashTable_Free(ShardedHashTable *table,
+                           ValueFreeFnPtr value_free_function) {
+  int i;
+
+  Verify333(table != NULL);
+  for (i = 0; i < table->num_shards; i++) {
+    SHTShard *shard = &table->shards[i];
+    HashTable_Free(shard->table, value_free_function);
+    Verify333(pthread_mutex_destroy(&shard->lock) == 0);
+  }
+  free(table->shards);
+  free(table);
+}
+
+int ShardedHashTable_NumShards(ShardedHashTable *table) {
+  Verify333(table != NULL);
+  return table->num_shards;
+}
+
+int ShardedHashTable_ShardOf(ShardedHashTable *table, HTKey_t key) {
+  Verify333(table != NULL);
+  if (table->shard_bits == 0) {
+    return 0;  // (a 64-bit shift would be undefined)
+  }
+  // Shard tables pick buckets from the key itself, or the low-order bits
+  // of its mixed hash, so we pick shards from the high-order bits.
+  return (int)(HTMixKey(key) >> (64 - table->shard_bits));
+}
+
+int ShardedHashTable_NumElements(ShardedHashTable *table) {
+  int i, num_elements = 0;
+
+  Verify333(table != NULL);
+  for (i = 0; i < table->num_shards; i++) {
+    SHTShard *shard = &table->shards[i];
+    Verify333(pthread_mutex_lock(&shard->lock) == 0);
+    num_elements += HashTable_NumElements(shard->table);
+    UnlockShard(shard);
+  }
+  return num_elements;
+}
+
+bool ShardedHashTable_Insert(ShardedHashTable *table,
+                             HTKeyValue_t newkeyvalue,
+                             HTKeyValue_t *oldkeyvalue) {
+  SHTShard *shard;
+  bool res;
+
+  Verify333(table != NULL);
+  shard = LockShard(table, newkeyvalue.key);
+  res = HashTable_Insert(shard->table, newkeyvalue, oldkeyvalue);
+  UnlockShard(shard);
+  return res;
+}
+
+bool ShardedHashTable_Find(ShardedHashTable *table, HTKey_t key,
+                           HTKeyValue_t *keyvalue) {
+  SHTShard *shard;
+  bool res;
+
+  Verify333(table != NULL);
+  shard = LockShard(table, key);
+  res = HashTable_Find(shard->table, key, keyvalue);
+  UnlockShard(shard);
+  return res;
+}
+
+bool ShardedHashTable_Remove(ShardedHashTable *table, HTKey_t key,
+                             HTKeyValue_t *keyvalue) {
+  SHTShard *shard;
+  bool res;
+
+  Verify333(table != NULL);
+  shard = LockShard(table, key);
+  res = HashTable_Remove(shard->table, key, keyvalue);
+  UnlockShard(shard);
+  return res;
+}
+
+HashTable *ShardedHashTable_AcquireShard(ShardedHashTable *table,
+                                         int shard) {
+  Verify333(table != NULL);
+  Verify333(shard >= 0 && shard < table->num_shards);
+  Verify333(pthread_mutex_lock(&table->shards[shard].lock) == 0);
+  return table->shards[shard].table;
+}
+
+void ShardedHashTable_ReleaseShard(ShardedHashTable *table, int shard) {
+  Verify333(table != NULL);
+  Verify333(shard >= 0 && shard < table->num_shards);
+  UnlockShard(&table->shards[shard]);
+}
+
+HTIterator *ShardedHashTable_IteratorAllocate(ShardedHashTable *table) {
+  HTIterator *iter;
+
+  Verify333(table != NULL);
+  iter = HTIterator_Allocate(table->shards[0].table);
+  iter->next_table = NextShardTable;
+  iter->tables = table;
+  iter->table_idx = 0;
+  if (!HTIterator_IsValid(iter)) {
+    HTIterator_Next(iter);  // skip ahead to the first non-empty shard
+  }
+  return iter;
+}
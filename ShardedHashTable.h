@@ -0,0 +1,122 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_SHARDEDHASHTABLE_H_
+#define HW1_SHARDEDHASHTABLE_H_
+
+#include <stdbool.h>    // for bool type (true, false)
+
+#include "./HashTable.h"  // for HTKey_t, HTKeyValue_t, HTIterator
+
+///////////////////////////////////////////////////////////////////////////////
+// A ShardedHashTable is a HashTable split into shards, typically one per
+// core, for workloads in which each thread mostly works on its own keys,
+// eg, per-thread counters that are only merged at the end.
+//
+// Each shard is an ordinary HashTable with its own mutex, and a key always
+// lives in the shard picked by ShardedHashTable_ShardOf.  There is no lock
+// or counter shared between shards, and each shard's lock and table live
+// on cache lines of their own, so threads that work on different shards
+// never touch the same memory.  If each thread sticks to the keys of "its"
+// shard, writes scale with the number of cores.
+//
+// Insert, Find and Remove may be called by any thread, on any key; they
+// lock just the key's shard.  An owning thread can instead lock its shard
+// once with ShardedHashTable_AcquireShard and then use the full HashTable
+// interface on the shard's table, without a lock round trip per operation.
+//
+// As with our other types, the struct is defined in
+// ShardedHashTable_priv.h.
+typedef struct sht ShardedHashTable;
+
+// Allocate and return a new, empty table.
+//
+// Arguments:
+// - num_shards: the number of shards, rounded up to a power of two; if it
+//   is zero or negative, the table gets one shard per online CPU.
+// - num_buckets: the total number of buckets to start with, spread over
+//   the shards; MUST be greater than zero.
+//
+// Returns:
+// - the newly-allocated table (never NULL).
+ShardedHashTable* ShardedHashTable_Allocate(int num_shards, int num_buckets);
+
+// Free a table and everything it contains.  Unlike most of the other
+// functions, this is NOT thread-safe: no other thread may be using the
+// table.
+//
+// Arguments:
+// - table: the table to free.
+// - value_free_function: invoked once per value; may be NULL.
+void ShardedHashTable_Free(ShardedHashTable *table,
+                           ValueFreeFnPtr value_free_function);
+
+// Returns the number of shards, a power of two.
+int ShardedHashTable_NumShards(ShardedHashTable *table);
+
+// Returns the shard, in [0, ShardedHashTable_NumShards), that holds (or
+// would hold) "key".  Shards are picked by the high bits of a hash of the
+// key, so every shard gets a fair share of any set of keys.
+int ShardedHashTable_ShardOf(ShardedHashTable *table, HTKey_t key);
+
+// Returns the number of elements in the table.  While other threads are
+// modifying the table, this is only a snapshot.
+int ShardedHashTable_NumElements(ShardedHashTable *table);
+
+// Thread-safe versions of HashTable_Insert, HashTable_Find and
+// HashTable_Remove; see HashTable.h for their contracts.  As with
+// ConcurrentHashTable_Find, Find hands back a copy of the (key,value) pair,
+// which dangles if another thread removes and frees the value.
+bool ShardedHashTable_Insert(ShardedHashTable *table,
+                             HTKeyValue_t newkeyvalue,
+                             HTKeyValue_t *oldkeyvalue);
+bool ShardedHashTable_Find(ShardedHashTable *table,
+                           HTKey_t key,
+                           HTKeyValue_t *keyvalue);
+bool ShardedHashTable_Remove(ShardedHashTable *table,
+                             HTKey_t key,
+                             HTKeyValue_t *keyvalue);
+
+// Locks a shard and returns its table, which the caller may then use with
+// any of the HashTable functions until it releases the shard.  Meanwhile,
+// other threads' Inserts, Finds and Removes of the shard's keys wait.
+//
+// The caller must only insert keys that belong to the shard (see
+// ShardedHashTable_ShardOf); a key inserted into the wrong shard can't be
+// found, nor removed, through the ShardedHashTable functions.
+//
+// Arguments:
+// - table: the table.
+// - shard: the shard to lock, in [0, ShardedHashTable_NumShards).
+//
+// Returns:
+// - the shard's table.
+HashTable* ShardedHashTable_AcquireShard(ShardedHashTable *table, int shard);
+
+// Unlocks a shard locked by ShardedHashTable_AcquireShard.  The shard's
+// table must not be used after this.
+void ShardedHashTable_ReleaseShard(ShardedHashTable *table, int shard);
+
+// Manufacture an iterator over every shard of the table, which the caller
+// uses and frees with the HTIterator functions (see HashTable.h).
+//
+// Iterating is NOT thread-safe: while the iterator is in use, no other
+// thread may modify the table.
+//
+// Arguments:
+// - table: the table to iterate over.
+//
+// Returns:
+// - the newly-allocated iterator, which may be invalid or "past the end"
+//   if the table is empty.
+HTIterator* ShardedHashTable_IteratorAllocate(ShardedHashTable *table);
+
+#endif  // HW1_SHARDEDHASHTABLE_H_
@@ -0,0 +1,54 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_SHARDEDHASHTABLE_PRIV_H_
+#define HW1_SHARDEDHASHTABLE_PRIV_H_
+
+#include <pthread.h>   // for pthread_mutex_t
+#include <stdalign.h>  // for alignas
+#include <stdbool.h>   // for bool type (true, false)
+
+#include "./HashTable.h"
+#include "./ShardedHashTable.h"
+
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+// Internal structures for our ShardedHashTable implementation, broken
+// out into a "private .h" so that our unittests can peek inside.
+//
+// Customers should not include this file or assume anything based on
+// its contents.
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+// Shard headers are padded out to a cache line, so that a thread locking
+// its own shard never invalidates a line another core is using.  (The
+// shards' HashTable records are padded the same way; see HT_CACHE_LINE.)
+#define SHT_CACHE_LINE 64
+
+// The most shards a table may have.
+#define SHT_MAX_SHARDS 1024
+
+// One shard: an ordinary (non-thread-safe) HashTable and the mutex that
+// guards it.
+typedef struct sht_shard {
+  alignas(SHT_CACHE_LINE) pthread_mutex_t lock;
+  HashTable *table;
+} SHTShard;
+
+// The table is the shard array, plus what it takes to route a key to a
+// shard: num_shards is 1 << shard_bits, and a key's shard is the top
+// shard_bits bits of its mixed hash.
+typedef struct sht {
+  int       num_shards;
+  int       shard_bits;
+  SHTShard *shards;      // num_shards shards
+} ShardedHashTable;
+
+#endif  // HW1_SHARDEDHASHTABLE_PRIV_H_
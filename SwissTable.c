@@ -0,0 +1,356 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include "SwissTable_priv.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "CSE333.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+//
+// Each Match* helper examines one aligned group of SWISS_GROUP_WIDTH control
+// bytes and returns a bitmask with bit i set iff control byte i matches.
+
+#define SWISS_TAG_MASK 0x7F
+
+#ifdef __SSE2__
+
+static inline uint32_t MatchTag(const int8_t *group, int8_t tag) {
+  __m128i ctrl = _mm_load_si128((const __m128i *)group);
+  return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), ctrl));
+}
+
+static inline uint32_t MatchEmpty(const int8_t *group) {
+  return MatchTag(group, SWISS_CTRL_EMPTY);
+}
+
+static inline uint32_t MatchEmptyOrDeleted(const int8_t *group) {
+  // Both special values have their high bit set; full slots do not.
+  __m128i ctrl = _mm_load_si128((const __m128i *)group);
+  return (uint32_t)_mm_movemask_epi8(ctrl);
+}
+
+#else  // portable fallback, one control byte at a time
+
+static inline uint32_t MatchTag(const int8_t *group, int8_t tag) {
+  uint32_t mask = 0;
+  for (int i = 0; i < SWISS_GROUP_WIDTH; i++) {
+    mask |= (uint32_t)(group[i] == tag) << i;
+  }
+  return mask;
+}
+
+static inline uint32_t MatchEmpty(const int8_t *group) {
+  return MatchTag(group, SWISS_CTRL_EMPTY);
+}
+
+static inline uint32_t MatchEmptyOrDeleted(const int8_t *group) {
+  uint32_t mask = 0;
+  for (int i = 0; i < SWISS_GROUP_WIDTH; i++) {
+    mask |= (uint32_t)(group[i] < 0) << i;
+  }
+  return mask;
+}
+
+#endif  // __SSE2__
+
+static inline uint32_t MatchFull(const int8_t *group) {
+  return ~MatchEmptyOrDeleted(group) & ((1U << SWISS_GROUP_WIDTH) - 1);
+}
+
+// The largest number of elements a table of this capacity may hold; we keep
+// at least 1/8 of the slots EMPTY so that every probe sequence terminates.
+static inline int MaxLoad(int capacity) {
+  return capacity - capacity / 8;
+}
+
+// Returns the slot index holding "key", or -1 if it isn't in the table.
+// If num_groups isn't NULL, the number of groups probed is returned
+// through it.
+static int FindIndex(SwissTable *table, HTKey_t key, uint64_t hash,
+                     int *num_groups) {
+  int8_t tag = (int8_t)(hash & SWISS_TAG_MASK);
+  size_t group_mask = (size_t)table->capacity / SWISS_GROUP_WIDTH - 1;
+  size_t group = (hash >> 7) & group_mask;
+  size_t step;
+
+  // Triangular probing over groups visits every group exactly once when the
+  // number of groups is a power of two.
+  for (step = 1; ; step++) {
+    const int8_t *ctrl = table->ctrl + group * SWISS_GROUP_WIDTH;
+    uint32_t match = MatchTag(ctrl, tag);
+
+    while (match != 0) {
+      size_t idx = group * SWISS_GROUP_WIDTH + __builtin_ctz(match);
+      if (table->slots[idx].key == key) {
+        if (num_groups != NULL) {
+          *num_groups = (int)step;
+        }
+        return (int)idx;
+      }
+      match &= match - 1;
+    }
+    if (MatchEmpty(ctrl) != 0) {
+      // The key would have been placed in this group had it been inserted.
+      if (num_groups != NULL) {
+        *num_groups = (int)step;
+      }
+      return -1;
+    }
+    group = (group + step) & group_mask;
+  }
+}
+
+// Returns the first EMPTY or DELETED slot along "hash"'s probe sequence.
+static int FindInsertSlot(SwissTable *table, uint64_t hash) {
+  size_t group_mask = (size_t)table->capacity / SWISS_GROUP_WIDTH - 1;
+  size_t group = (hash >> 7) & group_mask;
+  size_t step;
+
+  for (step = 1; ; step++) {
+    uint32_t match =
+        MatchEmptyOrDeleted(table->ctrl + group * SWISS_GROUP_WIDTH);
+    if (match != 0) {
+      return (int)(group * SWISS_GROUP_WIDTH + __builtin_ctz(match));
+    }
+    group = (group + step) & group_mask;
+  }
+}
+
+// Allocates fresh (all-EMPTY) control and slot arrays of the given capacity.
+static void InitArrays(SwissTable *table, int capacity) {
+  table->capacity = capacity;
+  table->num_elements = 0;
+  table->num_deleted = 0;
+  table->growth_left = MaxLoad(capacity);
+
+  // Groups are loaded with aligned vector loads.
+  table->ctrl = (int8_t *)aligned_alloc(SWISS_GROUP_WIDTH, capacity);
+  Verify333(table->ctrl != NULL);
+  memset(table->ctrl, SWISS_CTRL_EMPTY, capacity);
+
+  table->slots = (HTKeyValue_t *)malloc(capacity * sizeof(HTKeyValue_t));
+  Verify333(table->slots != NULL);
+}
+
+// Rebuilds the table with new_capacity slots, dropping every tombstone.
+static void RehashTo(SwissTable *table, int new_capacity) {
+  int old_capacity = table->capacity;
+  int8_t *old_ctrl = table->ctrl;
+  HTKeyValue_t *old_slots = table->slots;
+  int num_elements = table->num_elements;
+  int i;
+
+  InitArrays(table, new_capacity);
+
+  // Reinsert every full slot.  Keys are unique, so we skip the lookup.
+  for (i = 0; i < old_capacity; i++) {
+    if (old_ctrl[i] >= 0) {
+      uint64_t hash = SwissHash(old_slots[i].key);
+      int idx = FindInsertSlot(table, hash);
+      table->ctrl[idx] = (int8_t)(hash & SWISS_TAG_MASK);
+      table->slots[idx] = old_slots[i];
+    }
+  }
+  table->num_elements = num_elements;
+  table->growth_left -= num_elements;
+
+  free(old_ctrl);
+  free(old_slots);
+}
+
+// Rebuilds a full table.  If most of the used slots are tombstones we
+// rehash in place at the same capacity; otherwise we double the capacity.
+static void Rehash(SwissTable *table) {
+  if (table->num_elements * 2 > MaxLoad(table->capacity)) {
+    RehashTo(table, table->capacity * 2);
+  } else {
+    RehashTo(table, table->capacity);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SwissTable implementation.
+
+uint64_t SwissHash(HTKey_t key) {
+  // The murmur3 64-bit finalizer; every input bit affects every output bit.
+  uint64_t h = key;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+SwissTable *SwissTable_Allocate(int min_capacity) {
+  SwissTable *table;
+  int capacity = SWISS_GROUP_WIDTH;
+
+  Verify333(min_capacity > 0);
+  while (capacity < min_capacity) {
+    capacity *= 2;
+  }
+
+  table = (SwissTable *)malloc(sizeof(SwissTable));
+  Verify333(table != NULL);
+  InitArrays(table, capacity);
+  return table;
+}
+
+void SwissTable_Reserve(SwissTable *table, int num_elements) {
+  int capacity = table->capacity;
+
+  Verify333(num_elements >= 0);
+  while (MaxLoad(capacity) < num_elements) {
+    capacity *= 2;
+  }
+  if (capacity > table->capacity) {
+    RehashTo(table, capacity);
+  }
+}
+
+bool SwissTable_Compact(SwissTable *table) {
+  int capacity = SWISS_GROUP_WIDTH;
+
+  while (capacity < table->capacity &&
+         MaxLoad(capacity) < 2 * table->num_elements) {
+    capacity *= 2;
+  }
+  if (capacity == table->capacity && table->num_deleted == 0) {
+    return false;
+  }
+  RehashTo(table, capacity);
+  return true;
+}
+
+void SwissTable_Free(SwissTable *table, ValueFreeFnPtr value_free_function) {
+  int i;
+
+  Verify333(table != NULL);
+  for (i = 0; i < table->capacity && value_free_function != NULL; i++) {
+    if (table->ctrl[i] >= 0) {
+      value_free_function(table->slots[i].value);
+    }
+  }
+  free(table->ctrl);
+  free(table->slots);
+  free(table);
+}
+
+bool SwissTable_Insert(SwissTable *table, HTKeyValue_t newkeyvalue,
+                       HTKeyValue_t *oldkeyvalue) {
+  uint64_t hash = SwissHash(newkeyvalue.key);
+  int idx = FindIndex(table, newkeyvalue.key, hash, NULL);
+
+  if (idx >= 0) {
+    // Replace in place; the control byte is unchanged.
+    *oldkeyvalue = table->slots[idx];
+    table->slots[idx] = newkeyvalue;
+    return true;
+  }
+
+  idx = FindInsertSlot(table, hash);
+  if (table->ctrl[idx] == SWISS_CTRL_EMPTY && table->growth_left == 0) {
+    Rehash(table);
+    idx = FindInsertSlot(table, hash);
+  }
+
+  if (table->ctrl[idx] == SWISS_CTRL_DELETED) {
+    table->num_deleted--;
+  } else {
+    table->growth_left--;
+  }
+  table->ctrl[idx] = (int8_t)(hash & SWISS_TAG_MASK);
+  table->slots[idx] = newkeyvalue;
+  table->num_elements++;
+  return false;
+}
+
+bool SwissTable_Find(SwissTable *table, HTKey_t key, HTKeyValue_t *keyvalue,
+                     int *num_groups) {
+  int idx = FindIndex(table, key, SwissHash(key), num_groups);
+
+  if (idx < 0) {
+    return false;
+  }
+  *keyvalue = table->slots[idx];
+  return true;
+}
+
+bool SwissTable_Remove(SwissTable *table, HTKey_t key,
+                       HTKeyValue_t *keyvalue) {
+  int idx = FindIndex(table, key, SwissHash(key), NULL);
+  const int8_t *group;
+
+  if (idx < 0) {
+    return false;
+  }
+  *keyvalue = table->slots[idx];
+
+  // If this slot's group still has an EMPTY slot, no probe sequence has ever
+  // had to walk past the group, so the slot can go straight back to EMPTY.
+  // Otherwise we must leave a tombstone so later probes keep going.
+  group = table->ctrl + (idx / SWISS_GROUP_WIDTH) * SWISS_GROUP_WIDTH;
+  if (MatchEmpty(group) != 0) {
+    table->ctrl[idx] = SWISS_CTRL_EMPTY;
+    table->growth_left++;
+  } else {
+    table->ctrl[idx] = SWISS_CTRL_DELETED;
+    table->num_deleted++;
+  }
+  table->num_elements--;
+  return true;
+}
+
+void SwissTable_Prefetch(SwissTable *table, HTKey_t key) {
+  size_t group_mask = (size_t)table->capacity / SWISS_GROUP_WIDTH - 1;
+  size_t group = (SwissHash(key) >> 7) & group_mask;
+
+  __builtin_prefetch(table->ctrl + group * SWISS_GROUP_WIDTH);
+  __builtin_prefetch(table->slots + group * SWISS_GROUP_WIDTH);
+}
+
+int SwissTable_ProbeLength(SwissTable *table, HTKey_t key) {
+  int num_groups;
+
+  FindIndex(table, key, SwissHash(key), &num_groups);
+  return num_groups;
+}
+
+int SwissTable_NextFull(SwissTable *table, int start) {
+  int group;
+
+  if (start < 0) {
+    start = 0;
+  }
+  for (group = start - start % SWISS_GROUP_WIDTH; group < table->capacity;
+       group += SWISS_GROUP_WIDTH) {
+    uint32_t match = MatchFull(table->ctrl + group);
+
+    // Ignore slots before "start" in the first group we look at.
+    if (group < start) {
+      match &= ~0U << (start - group);
+    }
+    if (match != 0) {
+      return group + __builtin_ctz(match);
+    }
+  }
+  return -1;
+}
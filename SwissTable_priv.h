@@ -0,0 +1,99 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_SWISSTABLE_PRIV_H_
+#define HW1_SWISSTABLE_PRIV_H_
+
+#include <stdbool.h>  // for bool type (true, false)
+#include <stdint.h>   // for int8_t, etc.
+
+#include "./HashTable.h"  // for HTKey_t, HTKeyValue_t, ValueFreeFnPtr
+
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+// Internal structures and helper functions for the open-addressing
+// ("Swiss table") engine behind HT_ENGINE_SWISS.
+//
+// Customers never see a SwissTable directly; HashTable.c dispatches to these
+// functions when a table was allocated with the swiss engine.  The
+// declarations live in a "private .h" so that our unittests can peek inside.
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+// Number of control bytes (and slots) probed together.  A group of 16
+// control bytes fits in a single SSE2 register.
+#define SWISS_GROUP_WIDTH 16
+
+// Control byte values.  A full slot stores the low 7 bits of its key's hash
+// (so its control byte is in [0, 127]); the two special values both have
+// the high bit set, which lets us find "empty or deleted" slots with a
+// single movemask.
+#define SWISS_CTRL_EMPTY   ((int8_t)-128)  // 0x80: never used, stops probing
+#define SWISS_CTRL_DELETED ((int8_t)-2)    // 0xFE: tombstone, keeps probing
+
+// The open-addressing table.
+//
+// Slots are grouped into aligned groups of SWISS_GROUP_WIDTH.  Lookups hash
+// the key once, use the high bits to choose a starting group and the low
+// 7 bits as a tag; each probed group is filtered with one vector compare,
+// so only slots whose tag matches have their key compared.  The (key,value)
+// pairs live inline in the slot array, so a successful Find usually touches
+// one control-byte line and one slot line.
+typedef struct swiss {
+  int           capacity;      // # of slots; power of two, >= group width
+  int           num_elements;  // # of full slots
+  int           num_deleted;   // # of tombstones
+  int           growth_left;   // # of EMPTY slots we may still fill
+  int8_t       *ctrl;          // capacity control bytes
+  HTKeyValue_t *slots;         // capacity (key,value) slots
+} SwissTable;
+
+// Allocate a table able to hold at least min_capacity slots.
+SwissTable* SwissTable_Allocate(int min_capacity);
+
+// Grows the table, if necessary, so that it can hold num_elements elements
+// without rehashing.
+void SwissTable_Reserve(SwissTable *table, int num_elements);
+
+// Rebuilds the table at the smallest capacity (no larger than its current
+// one) that is at most half full, dropping every tombstone.  Returns false,
+// having done nothing, if that capacity is the current one and there are
+// no tombstones.
+bool SwissTable_Compact(SwissTable *table);
+
+// Free the table, invoking value_free_function on every stored value.
+void SwissTable_Free(SwissTable *table, ValueFreeFnPtr value_free_function);
+
+// Insert/Find/Remove; same contracts as their HashTable_* counterparts,
+// except that if Find's num_groups isn't NULL, the number of groups it
+// probed (see SwissTable_ProbeLength) is returned through it.
+bool SwissTable_Insert(SwissTable *table,
+                       HTKeyValue_t newkeyvalue,
+                       HTKeyValue_t *oldkeyvalue);
+bool SwissTable_Find(SwissTable *table, HTKey_t key, HTKeyValue_t *keyvalue,
+                     int *num_groups);
+bool SwissTable_Remove(SwissTable *table, HTKey_t key, HTKeyValue_t *keyvalue);
+
+// Prefetches the first group (control bytes and slots) that a lookup of
+// "key" will probe.
+void SwissTable_Prefetch(SwissTable *table, HTKey_t key);
+
+// Returns the number of groups that a lookup of "key" probes before it
+// either finds the key or concludes that it's missing.
+int SwissTable_ProbeLength(SwissTable *table, HTKey_t key);
+
+// Returns the index of the first full slot at or after "start", or -1 if
+// there are no more full slots.  Used to drive HTIterator.
+int SwissTable_NextFull(SwissTable *table, int start);
+
+// Mixes a (caller-hashed) key so that both the group index and the 7-bit
+// tag are well distributed, even for sequential keys.
+uint64_t SwissHash(HTKey_t key);
+
+#endif  // HW1_SWISSTABLE_PRIV_H_
@@ -0,0 +1,234 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "CSE333.h"
+#include "LinkedList.h"
+#include "LinkedList_priv.h"
+#include "UnrolledList_priv.h"
+
+_Static_assert(sizeof(LLChunk) == LL_CHUNK_BYTES,
+               "LL_CHUNK_PAYLOADS doesn't fill an LL_CHUNK_BYTES chunk");
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal helper functions.
+
+// Returns an empty, unlinked chunk whose run starts at "start": the list's
+// spare, if it has one, or a new one.
+static LLChunk *NewChunk(LinkedList *list, int start) {
+  LLChunk *chunk = list->spare_chunk;
+  if (chunk != NULL) {
+    list->spare_chunk = NULL;
+  } else {
+    chunk = (LLChunk *)aligned_alloc(LL_CHUNK_BYTES, sizeof(LLChunk));
+    Verify333(chunk != NULL);
+  }
+  chunk->next = chunk->prev = NULL;
+  chunk->start = start;
+  chunk->count = 0;
+  return chunk;
+}
+
+// Links a chunk in at the head or tail of the list.
+static void LinkHead(LinkedList *list, LLChunk *chunk) {
+  chunk->prev = NULL;
+  chunk->next = list->head_chunk;
+  if (list->head_chunk == NULL) {
+    list->tail_chunk = chunk;
+  } else {
+    list->head_chunk->prev = chunk;
+  }
+  list->head_chunk = chunk;
+}
+
+static void LinkTail(LinkedList *list, LLChunk *chunk) {
+  chunk->next = NULL;
+  chunk->prev = list->tail_chunk;
+  if (list->tail_chunk == NULL) {
+    list->head_chunk = chunk;
+  } else {
+    list->tail_chunk->next = chunk;
+  }
+  list->tail_chunk = chunk;
+}
+
+// Unlinks a chunk from the list and frees it, or keeps it as the list's
+// spare.  Keeping one spare means a Push/Pop (or Append/LLSlice) sequence
+// that keeps crossing a chunk boundary doesn't allocate and free a chunk
+// each time.
+static void UnlinkChunk(LinkedList *list, LLChunk *chunk) {
+  if (chunk->prev == NULL) {
+    list->head_chunk = chunk->next;
+  } else {
+    chunk->prev->next = chunk->next;
+  }
+  if (chunk->next == NULL) {
+    list->tail_chunk = chunk->prev;
+  } else {
+    chunk->next->prev = chunk->prev;
+  }
+  if (list->spare_chunk == NULL) {
+    list->spare_chunk = chunk;
+  } else {
+    free(chunk);
+  }
+}
+
+// Slides a chunk's run so that it starts at "start".
+static void MoveRun(LLChunk *chunk, int start) {
+  memmove(&chunk->payloads[start], &chunk->payloads[chunk->start],
+          chunk->count * sizeof(LLPayload_t));
+  chunk->start = start;
+}
+
+// Appends b's run to a's, and then unlinks b, which must be a's
+// successor.  The runs must fit in one chunk.
+static void MergeChunks(LinkedList *list, LLChunk *a, LLChunk *b) {
+  Verify333(a->count + b->count <= LL_CHUNK_PAYLOADS);
+  if (a->start + a->count + b->count > LL_CHUNK_PAYLOADS) {
+    MoveRun(a, 0);
+  }
+  memcpy(&a->payloads[a->start + a->count], &b->payloads[b->start],
+         b->count * sizeof(LLPayload_t));
+  a->count += b->count;
+  UnlinkChunk(list, b);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Unrolled LinkedList implementation.
+
+void UnrolledList_FreeChunks(LinkedList *list,
+                             LLPayloadFreeFnPtr payload_free_function) {
+  LLChunk *chunk, *next;
+  int i;
+
+  for (chunk = list->head_chunk; chunk != NULL; chunk = next) {
+    next = chunk->next;
+    if (payload_free_function != NULL) {
+      for (i = chunk->start; i < chunk->start + chunk->count; i++) {
+        payload_free_function(chunk->payloads[i]);
+      }
+    }
+    free(chunk);
+  }
+  free(list->spare_chunk);
+  list->head_chunk = list->tail_chunk = list->spare_chunk = NULL;
+  list->num_elements = 0;
+}
+
+void UnrolledList_Push(LinkedList *list, LLPayload_t payload) {
+  LLChunk *chunk = list->head_chunk;
+
+  if (chunk == NULL || chunk->count == LL_CHUNK_PAYLOADS) {
+    // Start a new head chunk, filling it from the back so that later
+    // pushes have room.
+    chunk = NewChunk(list, LL_CHUNK_PAYLOADS);
+    LinkHead(list, chunk);
+  } else if (chunk->start == 0) {
+    // There's room, but at the back; slide the run over to it.
+    MoveRun(chunk, LL_CHUNK_PAYLOADS - chunk->count);
+  }
+  chunk->payloads[--chunk->start] = payload;
+  chunk->count++;
+  list->num_elements++;
+}
+
+bool UnrolledList_Pop(LinkedList *list, LLPayload_t *payload_ptr) {
+  LLChunk *chunk = list->head_chunk;
+
+  if (chunk == NULL) {
+    return false;
+  }
+  *payload_ptr = chunk->payloads[chunk->start++];
+  if (--chunk->count == 0) {
+    UnlinkChunk(list, chunk);
+  }
+  list->num_elements--;
+  return true;
+}
+
+void UnrolledList_Append(LinkedList *list, LLPayload_t payload) {
+  LLChunk *chunk = list->tail_chunk;
+
+  if (chunk == NULL || chunk->count == LL_CHUNK_PAYLOADS) {
+    chunk = NewChunk(list, 0);
+    LinkTail(list, chunk);
+  } else if (chunk->start + chunk->count == LL_CHUNK_PAYLOADS) {
+    // There's room, but at the front; slide the run over to it.
+    MoveRun(chunk, 0);
+  }
+  chunk->payloads[chunk->start + chunk->count++] = payload;
+  list->num_elements++;
+}
+
+bool UnrolledList_Slice(LinkedList *list, LLPayload_t *payload_ptr) {
+  LLChunk *chunk = list->tail_chunk;
+
+  if (chunk == NULL) {
+    return false;
+  }
+  *payload_ptr = chunk->payloads[chunk->start + --chunk->count];
+  if (chunk->count == 0) {
+    UnlinkChunk(list, chunk);
+  }
+  list->num_elements--;
+  return true;
+}
+
+bool UnrolledList_IteratorRemove(LLIterator *iter,
+                                 LLPayloadFreeFnPtr payload_free_function) {
+  LinkedList *list = iter->list;
+  LLChunk *chunk = iter->chunk;
+  int offset = iter->slot - chunk->start;
+
+  payload_free_function(chunk->payloads[iter->slot]);
+
+  // Close the gap.  The removed payload's successor, if it's in this
+  // chunk, is now at the same offset in the run.
+  memmove(&chunk->payloads[iter->slot], &chunk->payloads[iter->slot + 1],
+          (chunk->count - offset - 1) * sizeof(LLPayload_t));
+  chunk->count--;
+  list->num_elements--;
+
+  if (list->num_elements == 0) {
+    UnlinkChunk(list, chunk);
+    iter->chunk = NULL;
+    return false;
+  }
+
+  // Merge with a neighbour whenever the two fit in one chunk, so that
+  // removals can't leave the list full of nearly empty chunks.  (This also
+  // unlinks the chunk if it is now empty.)
+  if (chunk->prev != NULL &&
+      chunk->prev->count + chunk->count <= LL_CHUNK_PAYLOADS) {
+    offset += chunk->prev->count;
+    chunk = chunk->prev;
+    MergeChunks(list, chunk, chunk->next);
+  } else if (chunk->next != NULL &&
+             chunk->count + chunk->next->count <= LL_CHUNK_PAYLOADS) {
+    MergeChunks(list, chunk, chunk->next);
+  }
+
+  // Point at the successor, or at the predecessor if we removed the tail.
+  if (offset < chunk->count) {
+    iter->chunk = chunk;
+    iter->slot = chunk->start + offset;
+  } else if (chunk->next != NULL) {
+    iter->chunk = chunk->next;
+    iter->slot = chunk->next->start;
+  } else {
+    iter->chunk = chunk;
+    iter->slot = chunk->start + chunk->count - 1;
+  }
+  return true;
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_UNROLLEDLIST_PRIV_H_
+#define HW1_UNROLLEDLIST_PRIV_H_
+
+#include <stdbool.h>  // for bool type (true, false)
+#include <stdint.h>   // for int32_t
+
+#include "./LinkedList.h"       // for LLPayload_t, LLPayloadFreeFnPtr
+#include "./LinkedList_priv.h"  // for LinkedList, LLIterator
+
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+// The unrolled LinkedList engine (see LinkedList_AllocateUnrolled), broken
+// out into a "private .h" so that LinkedList.c can dispatch to it and our
+// unittests can peek inside.
+//
+// Customers should not include this file or assume anything based on
+// its contents.
+// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+// An unrolled list is a doubly-linked list of chunks.  Each chunk holds a
+// run of consecutive payloads in payloads[start, start + count); letting
+// the run float within the chunk means Push and Pop work at the front of
+// the head chunk, and Append and LLSlice at the back of the tail chunk,
+// without shifting anything.
+//
+// A chunk is LL_CHUNK_BYTES long and aligned to LL_CHUNK_BYTES, so it
+// occupies exactly four cache lines.  Full, that is under 9 bytes per
+// payload, against 24 for a LinkedListNode plus malloc's per-block
+// overhead; and a scan touches a new cache line only every 8 payloads,
+// which the hardware prefetcher sees coming.
+#define LL_CHUNK_BYTES    256
+#define LL_CHUNK_PAYLOADS 29
+
+typedef struct ll_chunk {
+  struct ll_chunk *next;   // next chunk in list, or NULL
+  struct ll_chunk *prev;   // prev chunk in list, or NULL
+  int32_t          start;  // index of the first payload
+  int32_t          count;  // # of payloads; never 0 while in a list
+  LLPayload_t      payloads[LL_CHUNK_PAYLOADS];
+} LLChunk;
+
+// Unrolled versions of the LinkedList functions of (nearly) the same
+// names; LinkedList.c dispatches to these when list->unrolled is set.
+// UnrolledList_FreeChunks frees the chunks and their payloads, but not the
+// list itself.
+void UnrolledList_FreeChunks(LinkedList *list,
+                             LLPayloadFreeFnPtr payload_free_function);
+void UnrolledList_Push(LinkedList *list, LLPayload_t payload);
+bool UnrolledList_Pop(LinkedList *list, LLPayload_t *payload_ptr);
+void UnrolledList_Append(LinkedList *list, LLPayload_t payload);
+bool UnrolledList_Slice(LinkedList *list, LLPayload_t *payload_ptr);
+bool UnrolledList_IteratorRemove(LLIterator *iter,
+                                 LLPayloadFreeFnPtr payload_free_function);
+
+// The iterator's hot paths, inline so that a scan costs an increment and
+// a compare per payload.
+static inline void UnrolledList_IteratorInit(LLIterator *iter) {
+  iter->node = NULL;
+  iter->chunk = iter->list->head_chunk;
+  iter->slot = (iter->chunk != NULL) ? iter->chunk->start : 0;
+}
+
+static inline bool UnrolledList_IteratorNext(LLIterator *iter) {
+  LLChunk *chunk = iter->chunk;
+  if (++iter->slot < chunk->start + chunk->count) {
+    return true;
+  }
+  iter->chunk = chunk->next;
+  if (iter->chunk == NULL) {
+    return false;
+  }
+  iter->slot = iter->chunk->start;
+  return true;
+}
+
+#endif  // HW1_UNROLLEDLIST_PRIV_H_
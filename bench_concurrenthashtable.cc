@@ -0,0 +1,267 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C" {
+  #include "./ConcurrentHashTable.h"
+  #include "./HashTable.h"
+  #include "./LockFreeHashTable.h"
+  #include "./ShardedHashTable.h"
+}
+
+#include "benchmark/benchmark.h"
+#include "./bench_suite.h"
+
+namespace hw1 {
+
+// Scaling benchmarks: every thread runs the same mix of Finds and
+// Insert/Remove pairs over a shared table, comparing one HashTable behind
+// a single global mutex with a ConcurrentHashTable and a
+// LockFreeHashTable.  Throughput is in items_per_second, summed over
+// threads.
+static const int kNumKeys = 1 << 16;
+static const int kMaxThreads =
+    std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+// Keys are scattered rather than sequential: a single big table gives
+// sequential keys one bucket each, in order, which would flatter it.
+static inline HTKey_t BenchKey(uint64_t i) {
+  return static_cast<HTKey_t>(i * 0x9e3779b97f4a7c15ULL);
+}
+
+static HashTable *global_table;
+static std::mutex global_lock;
+static ConcurrentHashTable *striped_table;
+static LockFreeHashTable *lockfree_table;
+
+static void SetupTables(const benchmark::State &state) {
+  HTKeyValue_t kv, old;
+  global_table = HashTable_Allocate(kNumKeys / 3);
+  striped_table = ConcurrentHashTable_Allocate(kNumKeys / 3);
+  lockfree_table = LockFreeHashTable_Allocate(kNumKeys / 3);
+  for (int i = 0; i < kNumKeys; i++) {
+    kv.key = BenchKey(i);
+    kv.value = NULL;
+    HashTable_Insert(global_table, kv, &old);
+    ConcurrentHashTable_Insert(striped_table, kv, &old);
+    LockFreeHashTable_Insert(lockfree_table, kv, &old);
+  }
+}
+
+static void TeardownTables(const benchmark::State &state) {
+  HashTable_Free(global_table, NULL);
+  ConcurrentHashTable_Free(striped_table, NULL);
+  LockFreeHashTable_Free(lockfree_table, NULL);
+}
+
+// A per-thread xorshift generator, so threads don't share RNG state.
+static inline uint64_t NextRandom(uint64_t *x) {
+  *x ^= *x << 13;
+  *x ^= *x >> 7;
+  *x ^= *x << 17;
+  return *x;
+}
+
+// One operation: a Find, or with probability write_pct% a Remove followed
+// by re-inserting the same key (so the table's size stays put).
+template <typename Find, typename Write>
+static void RunMix(benchmark::State &state, Find find, Write write) {
+  int write_pct = static_cast<int>(state.range(0));
+  uint64_t x = 0x9e3779b97f4a7c15ULL * (state.thread_index() + 1);
+
+  for (auto _ : state) {
+    uint64_t r = NextRandom(&x);
+    HTKey_t key = BenchKey(r % kNumKeys);
+    if (static_cast<int>((r >> 32) % 100) < write_pct) {
+      write(key);
+    } else {
+      find(key);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_Concurrent_GlobalMutex(benchmark::State &state) {
+  RunMix(state,
+         [](HTKey_t key) {
+           HTKeyValue_t kv;
+           std::lock_guard<std::mutex> guard(global_lock);
+           benchmark::DoNotOptimize(HashTable_Find(global_table, key, &kv));
+         },
+         [](HTKey_t key) {
+           HTKeyValue_t kv;
+           std::lock_guard<std::mutex> guard(global_lock);
+           if (HashTable_Remove(global_table, key, &kv)) {
+             HashTable_Insert(global_table, kv, &kv);
+           }
+         });
+}
+BENCHMARK(BM_Concurrent_GlobalMutex)
+    ->ArgName("write_pct")->Arg(0)->Arg(10)
+    ->Setup(SetupTables)->Teardown(TeardownTables)
+    ->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+static void BM_Concurrent_Striped(benchmark::State &state) {
+  RunMix(state,
+         [](HTKey_t key) {
+           HTKeyValue_t kv;
+           benchmark::DoNotOptimize(
+               ConcurrentHashTable_Find(striped_table, key, &kv));
+         },
+         [](HTKey_t key) {
+           // The Remove and Insert are separately atomic; another thread
+           // may see the key missing in between, which is fine here.
+           HTKeyValue_t kv;
+           if (ConcurrentHashTable_Remove(striped_table, key, &kv)) {
+             ConcurrentHashTable_Insert(striped_table, kv, &kv);
+           }
+         });
+}
+BENCHMARK(BM_Concurrent_Striped)
+    ->ArgName("write_pct")->Arg(0)->Arg(10)
+    ->Setup(SetupTables)->Teardown(TeardownTables)
+    ->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+static void BM_Concurrent_LockFree(benchmark::State &state) {
+  RunMix(state,
+         [](HTKey_t key) {
+           HTKeyValue_t kv;
+           benchmark::DoNotOptimize(
+               LockFreeHashTable_Find(lockfree_table, key, &kv));
+         },
+         [](HTKey_t key) {
+           HTKeyValue_t kv;
+           if (LockFreeHashTable_Remove(lockfree_table, key, &kv)) {
+             LockFreeHashTable_Insert(lockfree_table, kv, &kv);
+           }
+         });
+}
+BENCHMARK(BM_Concurrent_LockFree)
+    ->ArgName("write_pct")->Arg(0)->Arg(10)
+    ->Setup(SetupTables)->Teardown(TeardownTables)
+    ->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+// Counter benchmarks: each thread bumps counters for a set of keys that
+// only it uses, all of them in "its" shard of a ShardedHashTable (one per
+// thread).  An iteration is a batch of kCounterBatch increments, each a
+// Find followed by an Insert of the incremented count.
+static const int kCounterBatch = 64;
+static ShardedHashTable *sharded_table;
+static std::vector<std::vector<HTKey_t>> owned_keys;
+
+static void SetupCounters(const benchmark::State &state) {
+  HTKeyValue_t kv, old;
+  SetupTables(state);
+  sharded_table = ShardedHashTable_Allocate(kMaxThreads, kNumKeys / 3);
+  owned_keys.assign(ShardedHashTable_NumShards(sharded_table), {});
+  for (int i = 0; i < kNumKeys; i++) {
+    kv.key = BenchKey(i);
+    kv.value = NULL;
+    ShardedHashTable_Insert(sharded_table, kv, &old);
+    owned_keys[ShardedHashTable_ShardOf(sharded_table, kv.key)].push_back(
+        kv.key);
+  }
+}
+
+static void TeardownCounters(const benchmark::State &state) {
+  TeardownTables(state);
+  ShardedHashTable_Free(sharded_table, NULL);
+}
+
+static inline HTValue_t Increment(HTValue_t count) {
+  return reinterpret_cast<HTValue_t>(reinterpret_cast<uintptr_t>(count) + 1);
+}
+
+// Runs batches of increments over the thread's keys; "batch" is called
+// with the keys of one batch.
+template <typename Batch>
+static void RunCounters(benchmark::State &state, Batch batch) {
+  const std::vector<HTKey_t> &keys = owned_keys[state.thread_index()];
+  size_t next = 0;
+
+  for (auto _ : state) {
+    if (next + kCounterBatch > keys.size()) {
+      next = 0;
+    }
+    batch(&keys[next]);
+    next += kCounterBatch;
+  }
+  state.SetItemsProcessed(state.iterations() * kCounterBatch);
+}
+
+static void BM_Counters_GlobalMutex(benchmark::State &state) {
+  RunCounters(state, [](const HTKey_t *keys) {
+    for (int i = 0; i < kCounterBatch; i++) {
+      HTKeyValue_t kv;
+      std::lock_guard<std::mutex> guard(global_lock);
+      HashTable_Find(global_table, keys[i], &kv);
+      kv.value = Increment(kv.value);
+      HashTable_Insert(global_table, kv, &kv);
+    }
+  });
+}
+BENCHMARK(BM_Counters_GlobalMutex)
+    ->Setup(SetupCounters)->Teardown(TeardownCounters)
+    ->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+static void BM_Counters_Striped(benchmark::State &state) {
+  RunCounters(state, [](const HTKey_t *keys) {
+    for (int i = 0; i < kCounterBatch; i++) {
+      HTKeyValue_t kv;
+      ConcurrentHashTable_Find(striped_table, keys[i], &kv);
+      kv.value = Increment(kv.value);
+      ConcurrentHashTable_Insert(striped_table, kv, &kv);
+    }
+  });
+}
+BENCHMARK(BM_Counters_Striped)
+    ->Setup(SetupCounters)->Teardown(TeardownCounters)
+    ->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+static void BM_Counters_Sharded(benchmark::State &state) {
+  RunCounters(state, [](const HTKey_t *keys) {
+    for (int i = 0; i < kCounterBatch; i++) {
+      HTKeyValue_t kv;
+      ShardedHashTable_Find(sharded_table, keys[i], &kv);
+      kv.value = Increment(kv.value);
+      ShardedHashTable_Insert(sharded_table, kv, &kv);
+    }
+  });
+}
+BENCHMARK(BM_Counters_Sharded)
+    ->Setup(SetupCounters)->Teardown(TeardownCounters)
+    ->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+// The thread-affine fast path: one lock round trip per batch.
+static void BM_Counters_ShardedAffine(benchmark::State &state) {
+  int shard = state.thread_index();
+  RunCounters(state, [shard](const HTKey_t *keys) {
+    HashTable *table = ShardedHashTable_AcquireShard(sharded_table, shard);
+    for (int i = 0; i < kCounterBatch; i++) {
+      HTKeyValue_t kv;
+      HashTable_Find(table, keys[i], &kv);
+      kv.value = Increment(kv.value);
+      HashTable_Insert(table, kv, &kv);
+    }
+    ShardedHashTable_ReleaseShard(sharded_table, shard);
+  });
+}
+BENCHMARK(BM_Counters_ShardedAffine)
+    ->Setup(SetupCounters)->Teardown(TeardownCounters)
+    ->ThreadRange(1, kMaxThreads)->UseRealTime();
+
+}  // namespace hw1
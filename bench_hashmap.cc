@@ -0,0 +1,181 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+
+extern "C" {
+  #include "./HashTable.h"
+}
+
+#include "benchmark/benchmark.h"
+
+#include "./HashMap.h"
+#include "./bench_suite.h"
+
+namespace hw1 {
+
+// The same workloads on a HashMap, a HashTable, and a std::unordered_map.
+// "impl" is kHashMap, kCTable or kStdMap.
+enum { kHashMap = 0, kCTable, kStdMap };
+
+// Keys are scrambled (a multiply by 2^64 / phi) so that they look like
+// hashes or random ids.  With small-stride keys, the modulo-hashed HashTable
+// and std::unordered_map put consecutive keys in neighboring buckets, and
+// these benchmarks would mostly measure that locality, which HashMap's
+// mixer deliberately gives up.
+static uint64_t KeyOf(int i) {
+  return static_cast<uint64_t>(i) * 0x9e3779b97f4a7c15ULL;
+}
+
+// Builds num_keys (uint64_t, uint64_t) elements, starting from one bucket.
+static void BM_HashMap_InsertInts(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+
+  for (auto _ : state) {
+    switch (state.range(1)) {
+      case kHashMap: {
+        HashMap<uint64_t, uint64_t> map;
+        for (int i = 0; i < num_keys; i++) {
+          map.Insert(KeyOf(i), static_cast<uint64_t>(i));
+        }
+        benchmark::DoNotOptimize(map.size());
+        state.PauseTiming();
+        break;
+      }
+      case kCTable: {
+        HashTable *table = HashTable_Allocate(1);
+        HTKeyValue_t kv, old;
+        for (int i = 0; i < num_keys; i++) {
+          kv.key = KeyOf(i);
+          kv.value = reinterpret_cast<HTValue_t>(static_cast<intptr_t>(i));
+          HashTable_Insert(table, kv, &old);
+        }
+        benchmark::DoNotOptimize(table);
+        state.PauseTiming();
+        HashTable_Free(table, NULL);
+        break;
+      }
+      default: {
+        std::unordered_map<uint64_t, uint64_t> map;
+        for (int i = 0; i < num_keys; i++) {
+          map.insert_or_assign(KeyOf(i), static_cast<uint64_t>(i));
+        }
+        benchmark::DoNotOptimize(map.size());
+        state.PauseTiming();
+        break;
+      }
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+}
+BENCHMARK(BM_HashMap_InsertInts)
+    ->ArgNames({"keys", "impl"})
+    ->ArgsProduct({{1 << 10, 1 << 20}, {kHashMap, kCTable, kStdMap}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Successful lookups of (uint64_t, uint64_t) elements.
+static void BM_HashMap_FindInts(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HashMap<uint64_t, uint64_t> map;
+  HashTable *table = HashTable_Allocate(1);
+  std::unordered_map<uint64_t, uint64_t> std_map;
+  HTKeyValue_t kv, old;
+  int i = 0;
+
+  for (int j = 0; j < num_keys; j++) {
+    map.Insert(KeyOf(j), static_cast<uint64_t>(j));
+    kv.key = KeyOf(j);
+    kv.value = reinterpret_cast<HTValue_t>(static_cast<intptr_t>(j));
+    HashTable_Insert(table, kv, &old);
+    std_map.emplace(KeyOf(j), static_cast<uint64_t>(j));
+  }
+
+  for (auto _ : state) {
+    uint64_t key = KeyOf(i);
+    switch (state.range(1)) {
+      case kHashMap:
+        benchmark::DoNotOptimize(*map.Find(key));
+        break;
+      case kCTable:
+        HashTable_Find(table, key, &kv);
+        benchmark::DoNotOptimize(kv.value);
+        break;
+      default:
+        benchmark::DoNotOptimize(std_map.find(key)->second);
+        break;
+    }
+    i = (i + 104729) & (num_keys - 1);
+  }
+  HashTable_Free(table, NULL);
+}
+BENCHMARK(BM_HashMap_FindInts)
+    ->ArgNames({"keys", "impl"})
+    ->ArgsProduct({{1 << 10, 1 << 20}, {kHashMap, kCTable, kStdMap}});
+
+// Building a map of std::string values.  The C table can only hold a
+// pointer, so each of its values is a separately allocated copy, freed
+// through a ValueFreeFnPtr; HashMap and std::unordered_map move the
+// string into the node.
+static void FreeString(HTValue_t value) {
+  delete static_cast<std::string *>(value);
+}
+
+static void BM_HashMap_InsertStrings(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+
+  for (auto _ : state) {
+    switch (state.range(1)) {
+      case kHashMap: {
+        HashMap<uint64_t, std::string> map;
+        for (int i = 0; i < num_keys; i++) {
+          map.Insert(KeyOf(i), std::string(32, 'a' + i % 26));
+        }
+        benchmark::DoNotOptimize(map.size());
+        state.PauseTiming();
+        break;
+      }
+      case kCTable: {
+        HashTable *table = HashTable_Allocate(1);
+        HTKeyValue_t kv, old;
+        for (int i = 0; i < num_keys; i++) {
+          kv.key = KeyOf(i);
+          kv.value = new std::string(32, 'a' + i % 26);
+          HashTable_Insert(table, kv, &old);
+        }
+        benchmark::DoNotOptimize(table);
+        state.PauseTiming();
+        HashTable_Free(table, &FreeString);
+        break;
+      }
+      default: {
+        std::unordered_map<uint64_t, std::string> map;
+        for (int i = 0; i < num_keys; i++) {
+          map.insert_or_assign(KeyOf(i), std::string(32, 'a' + i % 26));
+        }
+        benchmark::DoNotOptimize(map.size());
+        state.PauseTiming();
+        break;
+      }
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+}
+BENCHMARK(BM_HashMap_InsertStrings)
+    ->ArgNames({"keys", "impl"})
+    ->ArgsProduct({{1 << 10, 1 << 20}, {kHashMap, kCTable, kStdMap}})
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace hw1
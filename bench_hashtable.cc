@@ -0,0 +1,782 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+extern "C" {
+  #include "./HashTable.h"
+  #include "./HashTable_priv.h"
+  #include "./HashTableLoader.h"
+  #include "./HashTableSnapshot.h"
+  #include "./LinkedList.h"
+}
+
+#include "benchmark/benchmark.h"
+
+#include "./HashTableLookup.h"
+#include "./bench_suite.h"
+
+namespace hw1 {
+
+// Builds a table holding keys [0, num_keys), with values equal to keys.
+static HashTable *MakeTable(int num_keys, const HTOptions *options) {
+  HashTable *table = HashTable_AllocateWithOptions(num_keys / 3 + 1, options);
+  HTKeyValue_t kv, old;
+  for (int i = 0; i < num_keys; i++) {
+    kv.key = static_cast<HTKey_t>(i);
+    kv.value = reinterpret_cast<HTValue_t>(static_cast<intptr_t>(i));
+    HashTable_Insert(table, kv, &old);
+  }
+  return table;
+}
+
+// Successful lookups.  These should make no allocations at all.
+static void BM_HashTable_FindHit(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HashTable *table = MakeTable(num_keys, NULL);
+  HTKeyValue_t kv;
+  HTKey_t key = 0;
+
+  uint64_t start = BenchAllocCount();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(HashTable_Find(table, key, &kv));
+    key = (key + 7919) % num_keys;
+  }
+  BenchReportAllocs(state, start);
+  HashTable_Free(table, NULL);
+}
+BENCHMARK(BM_HashTable_FindHit)->Arg(1 << 10)->Arg(1 << 20);
+
+// Unsuccessful lookups walk a whole chain; again, no allocations.
+static void BM_HashTable_FindMiss(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HashTable *table = MakeTable(num_keys, NULL);
+  HTKeyValue_t kv;
+  HTKey_t key = 0;
+
+  uint64_t start = BenchAllocCount();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(HashTable_Find(table, num_keys + key, &kv));
+    key = (key + 7919) % num_keys;
+  }
+  BenchReportAllocs(state, start);
+  HashTable_Free(table, NULL);
+}
+BENCHMARK(BM_HashTable_FindMiss)->Arg(1 << 10)->Arg(1 << 20);
+
+// A Remove followed by re-inserting the same key.  The only allocation is
+// the new chain node made by the Insert (none at all with use_pool, once
+// the pool has a free node to recycle).
+static void BM_HashTable_RemoveInsert(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HTOptions options = { HT_ENGINE_CHAINED };
+  options.use_pool = (state.range(1) != 0);
+  HashTable *table = MakeTable(num_keys, &options);
+  HTKeyValue_t kv;
+  HTKey_t key = 0;
+
+  uint64_t start = BenchAllocCount();
+  for (auto _ : state) {
+    HashTable_Remove(table, key, &kv);
+    HashTable_Insert(table, kv, &kv);
+    key = (key + 7919) % num_keys;
+  }
+  BenchReportAllocs(state, start);
+  HashTable_Free(table, NULL);
+}
+BENCHMARK(BM_HashTable_RemoveInsert)
+    ->ArgNames({"keys", "pool"})
+    ->Args({1 << 10, 0})->Args({1 << 10, 1})
+    ->Args({1 << 20, 0})->Args({1 << 20, 1});
+
+// Allocating and freeing an empty table with "buckets" buckets.
+static void BM_HashTable_AllocateFree(benchmark::State &state) {
+  int num_buckets = static_cast<int>(state.range(0));
+
+  uint64_t start = BenchAllocCount();
+  for (auto _ : state) {
+    HashTable *table = HashTable_Allocate(num_buckets);
+    benchmark::DoNotOptimize(table);
+    HashTable_Free(table, NULL);
+  }
+  BenchReportAllocs(state, start);
+}
+BENCHMARK(BM_HashTable_AllocateFree)
+    ->ArgName("buckets")->Arg(1 << 10)->Arg(1 << 20)->Arg(10000000)
+    ->Unit(benchmark::kMicrosecond);
+
+// The core operations swept over table size and load factor, each next to
+// the same workload on a std::unordered_map.  "load_pct" is the number of
+// elements per bucket, in percent; the tables are presized for it (a
+// chained table only resizes at 300%), so nothing resizes while we
+// measure.  Keys are visited in a scattered order so that the large
+// tables miss cache.
+static const std::vector<int64_t> kSweepKeys = {1 << 10, 1 << 16, 1 << 20};
+static const std::vector<int64_t> kSweepLoadPcts = {50, 100, 250};
+
+// A default table holding keys [0, num_keys) at the given load factor.
+static HashTable *MakeLoadedTable(int num_keys, int load_pct) {
+  HashTable *table = HashTable_Allocate(
+      std::max(1, static_cast<int>(int64_t{num_keys} * 100 / load_pct)));
+  HTKeyValue_t kv, old;
+  for (int i = 0; i < num_keys; i++) {
+    kv.key = static_cast<HTKey_t>(i);
+    kv.value = reinterpret_cast<HTValue_t>(static_cast<intptr_t>(i));
+    HashTable_Insert(table, kv, &old);
+  }
+  return table;
+}
+
+typedef std::unordered_map<HTKey_t, HTValue_t> StdMap;
+
+// The std::unordered_map equivalent of MakeLoadedTable.
+static StdMap *MakeLoadedMap(int num_keys, int load_pct) {
+  StdMap *map = new StdMap();
+  map->max_load_factor(load_pct / 100.0f);
+  map->reserve(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    (*map)[static_cast<HTKey_t>(i)] =
+        reinterpret_cast<HTValue_t>(static_cast<intptr_t>(i));
+  }
+  return map;
+}
+
+// Lookups that hit (hit = 1) or miss (hit = 0).
+static void BM_HashTable_Find(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HTKey_t miss_offset = (state.range(2) != 0) ? 0 : num_keys;
+  HashTable *table = MakeLoadedTable(num_keys, state.range(1));
+  HTKeyValue_t kv;
+  HTKey_t key = 0;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(HashTable_Find(table, key + miss_offset, &kv));
+    key = (key + 7919) % num_keys;
+  }
+  HashTable_Free(table, NULL);
+}
+BENCHMARK(BM_HashTable_Find)
+    ->ArgNames({"keys", "load_pct", "hit"})
+    ->ArgsProduct({kSweepKeys, kSweepLoadPcts, {0, 1}});
+
+static void BM_StdUnorderedMap_Find(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HTKey_t miss_offset = (state.range(2) != 0) ? 0 : num_keys;
+  StdMap *map = MakeLoadedMap(num_keys, state.range(1));
+  HTKey_t key = 0;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map->find(key + miss_offset));
+    key = (key + 7919) % num_keys;
+  }
+  delete map;
+}
+BENCHMARK(BM_StdUnorderedMap_Find)
+    ->ArgNames({"keys", "load_pct", "hit"})
+    ->ArgsProduct({kSweepKeys, kSweepLoadPcts, {0, 1}});
+
+// Filling a presized table with num_keys fresh keys; one iteration is
+// the whole fill.
+static void BM_HashTable_Insert(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  int num_buckets = static_cast<int>(num_keys * 100 / state.range(1));
+  HTKeyValue_t kv, old;
+
+  for (auto _ : state) {
+    HashTable *table = HashTable_Allocate(std::max(1, num_buckets));
+    for (int i = 0; i < num_keys; i++) {
+      kv.key = static_cast<HTKey_t>(i) * 7919 % num_keys;
+      kv.value = NULL;
+      HashTable_Insert(table, kv, &old);
+    }
+    state.PauseTiming();
+    HashTable_Free(table, NULL);
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+}
+BENCHMARK(BM_HashTable_Insert)
+    ->ArgNames({"keys", "load_pct"})
+    ->ArgsProduct({kSweepKeys, kSweepLoadPcts});
+
+static void BM_StdUnorderedMap_Insert(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+
+  for (auto _ : state) {
+    StdMap *map = new StdMap();
+    map->max_load_factor(state.range(1) / 100.0f);
+    map->reserve(num_keys);
+    for (int i = 0; i < num_keys; i++) {
+      map->emplace(static_cast<HTKey_t>(i) * 7919 % num_keys, nullptr);
+    }
+    state.PauseTiming();
+    delete map;
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+}
+BENCHMARK(BM_StdUnorderedMap_Insert)
+    ->ArgNames({"keys", "load_pct"})
+    ->ArgsProduct({kSweepKeys, kSweepLoadPcts});
+
+// Removing every key of a full table (hit = 1), or looking for keys to
+// remove that aren't there (hit = 0).  One iteration is num_keys removes.
+static void BM_HashTable_Remove(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HTKey_t miss_offset = (state.range(2) != 0) ? 0 : num_keys;
+  HTKeyValue_t kv;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    HashTable *table = MakeLoadedTable(num_keys, state.range(1));
+    state.ResumeTiming();
+    for (int i = 0; i < num_keys; i++) {
+      HTKey_t key = static_cast<HTKey_t>(i) * 7919 % num_keys;
+      benchmark::DoNotOptimize(
+          HashTable_Remove(table, key + miss_offset, &kv));
+    }
+    state.PauseTiming();
+    HashTable_Free(table, NULL);
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+}
+BENCHMARK(BM_HashTable_Remove)
+    ->ArgNames({"keys", "load_pct", "hit"})
+    ->ArgsProduct({kSweepKeys, kSweepLoadPcts, {0, 1}});
+
+static void BM_StdUnorderedMap_Remove(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HTKey_t miss_offset = (state.range(2) != 0) ? 0 : num_keys;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    StdMap *map = MakeLoadedMap(num_keys, state.range(1));
+    state.ResumeTiming();
+    for (int i = 0; i < num_keys; i++) {
+      HTKey_t key = static_cast<HTKey_t>(i) * 7919 % num_keys;
+      benchmark::DoNotOptimize(map->erase(key + miss_offset));
+    }
+    state.PauseTiming();
+    delete map;
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+}
+BENCHMARK(BM_StdUnorderedMap_Remove)
+    ->ArgNames({"keys", "load_pct", "hit"})
+    ->ArgsProduct({kSweepKeys, kSweepLoadPcts, {0, 1}});
+
+// A full HTIterator scan.  Lower load factors mean more empty buckets to
+// skip, so this also sweeps down to a sparse 10%.
+static void BM_HashTable_Iterate(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HashTable *table = MakeLoadedTable(num_keys, state.range(1));
+  HTKeyValue_t kv;
+
+  for (auto _ : state) {
+    HTIterator *it = HTIterator_Allocate(table);
+    while (HTIterator_IsValid(it)) {
+      HTIterator_Get(it, &kv);
+      benchmark::DoNotOptimize(kv);
+      HTIterator_Next(it);
+    }
+    HTIterator_Free(it);
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+  HashTable_Free(table, NULL);
+}
+BENCHMARK(BM_HashTable_Iterate)
+    ->ArgNames({"keys", "load_pct"})
+    ->ArgsProduct({kSweepKeys, {10, 50, 100, 250}});
+
+static void BM_StdUnorderedMap_Iterate(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  StdMap *map = MakeLoadedMap(num_keys, state.range(1));
+
+  for (auto _ : state) {
+    for (const auto &kv : *map) {
+      benchmark::DoNotOptimize(kv);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+  delete map;
+}
+BENCHMARK(BM_StdUnorderedMap_Iterate)
+    ->ArgNames({"keys", "load_pct"})
+    ->ArgsProduct({kSweepKeys, {10, 50, 100, 250}});
+
+// The cost of a single resize: the one Insert that pushes a table holding
+// "keys" elements over its load limit, rehashing all of them.
+static void BM_HashTable_Resize(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HTKeyValue_t kv, old;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    HashTable *table = MakeLoadedTable(num_keys, 300);
+    int num_buckets = table->num_buckets;
+    kv.key = static_cast<HTKey_t>(num_keys);
+    kv.value = NULL;
+    state.ResumeTiming();
+    HashTable_Insert(table, kv, &old);
+    state.PauseTiming();
+    if (table->num_buckets == num_buckets) {
+      state.SkipWithError("the insert didn't resize the table");
+    }
+    HashTable_Free(table, NULL);
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+}
+BENCHMARK(BM_HashTable_Resize)
+    ->ArgName("keys")->Arg(3 << 10)->Arg(3 << 16)->Arg(3 << 20)
+    ->Unit(benchmark::kMicrosecond);
+
+static void BM_StdUnorderedMap_Rehash(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    StdMap *map = MakeLoadedMap(num_keys, 100);
+    state.ResumeTiming();
+    map->rehash(map->bucket_count() * 2);
+    state.PauseTiming();
+    delete map;
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+}
+BENCHMARK(BM_StdUnorderedMap_Rehash)
+    ->ArgName("keys")->Arg(3 << 10)->Arg(3 << 16)->Arg(3 << 20)
+    ->Unit(benchmark::kMicrosecond);
+
+// A bulk load of "keys" elements into a one-bucket table, either growing
+// under the default policy (reserve = 0), or presized with
+// HashTable_Reserve (reserve = 1), or growing 2x at a load factor of 1
+// (reserve = 2).  The "bucket_bytes" counter is the size of the final
+// bucket array.
+static void BM_HashTable_BulkLoad(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HTOptions options = { HT_ENGINE_CHAINED };
+  HTKeyValue_t kv, old;
+  int num_buckets = 0;
+
+  if (state.range(1) == 2) {
+    options.max_load_factor = 1.0;
+    options.growth_factor = 2;
+  }
+  for (auto _ : state) {
+    HashTable *table = HashTable_AllocateWithOptions(1, &options);
+    if (state.range(1) == 1) {
+      HashTable_Reserve(table, num_keys);
+    }
+    for (int i = 0; i < num_keys; i++) {
+      kv.key = static_cast<HTKey_t>(i) * 7919;
+      kv.value = NULL;
+      HashTable_Insert(table, kv, &old);
+    }
+    num_buckets = table->num_buckets;
+    state.PauseTiming();
+    HashTable_Free(table, NULL);
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+  state.counters["bucket_bytes"] =
+      static_cast<double>(num_buckets) * sizeof(LinkedList *);
+}
+BENCHMARK(BM_HashTable_BulkLoad)
+    ->ArgNames({"keys", "reserve"})
+    ->ArgsProduct({{1 << 16, 1 << 20}, {0, 1, 2}})
+    ->Unit(benchmark::kMillisecond);
+
+// Time from a cold start to the first lookup: rebuilding the table by
+// inserting every key ("mapped" = 0), versus mapping a snapshot of it
+// ("mapped" = 1).  Mapping doesn't depend on the table's size.
+static void BM_HashTable_SnapshotLoad(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  const char *path = "/tmp/bench_hashtable.snapshot";
+  HTKeyValue_t kv, old;
+
+  if (state.range(1) == 1) {
+    HashTable *table = MakeTable(num_keys, NULL);
+    HashTable_Save(table, path, NULL);
+    HashTable_Free(table, NULL);
+  }
+  for (auto _ : state) {
+    if (state.range(1) == 1) {
+      HTSnapshot *snapshot = HashTable_MapFile(path);
+      benchmark::DoNotOptimize(HTSnapshot_Find(snapshot, 1, &kv, NULL));
+      HTSnapshot_Unmap(snapshot);
+    } else {
+      HashTable *table = HashTable_Allocate(num_keys / 3 + 1);
+      for (int i = 0; i < num_keys; i++) {
+        kv.key = static_cast<HTKey_t>(i);
+        kv.value = reinterpret_cast<HTValue_t>(static_cast<intptr_t>(i));
+        HashTable_Insert(table, kv, &old);
+      }
+      benchmark::DoNotOptimize(HashTable_Find(table, 1, &kv));
+      state.PauseTiming();
+      HashTable_Free(table, NULL);
+      state.ResumeTiming();
+    }
+  }
+  if (state.range(1) == 1) {
+    unlink(path);
+  }
+}
+BENCHMARK(BM_HashTable_SnapshotLoad)
+    ->ArgNames({"keys", "mapped"})
+    ->ArgsProduct({{1 << 16, 1 << 20}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Loading "<key> <value>" lines from a file: a record at a time with
+// fgets and HashTable_Insert into a default-sized table ("loader" = 0),
+// versus HashTable_LoadFile with ("loader" = 2) and without ("loader" =
+// 1) a size hint.
+static bool ParseIntRecord(const char *record, size_t len, void *arg,
+                           HTKeyValue_t *keyvalue) {
+  char *end;
+  keyvalue->key = strtoull(record, &end, 10);
+  keyvalue->value = reinterpret_cast<HTValue_t>(strtoull(end, NULL, 10));
+  return end != record;
+}
+
+static void BM_HashTable_LoadFile(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  const char *path = "/tmp/bench_hashtable.records";
+  HTKeyValue_t kv, old;
+  char line[64];
+
+  FILE *f = fopen(path, "w");
+  for (int i = 0; i < num_keys; i++) {
+    fprintf(f, "%" PRIu64 " %d\n", static_cast<uint64_t>(i) * 7919, i);
+  }
+  fclose(f);
+
+  for (auto _ : state) {
+    HashTable *table = HashTable_Allocate(2);
+    if (state.range(1) == 0) {
+      f = fopen(path, "r");
+      while (fgets(line, sizeof(line), f) != NULL) {
+        if (ParseIntRecord(line, strlen(line), NULL, &kv)) {
+          HashTable_Insert(table, kv, &old);
+        }
+      }
+      fclose(f);
+    } else {
+      HashTable_LoadFile(table, path, &ParseIntRecord, NULL,
+                         state.range(1) == 2 ? num_keys : 0, NULL);
+    }
+    state.PauseTiming();
+    HashTable_Free(table, NULL);
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * num_keys);
+  unlink(path);
+}
+BENCHMARK(BM_HashTable_LoadFile)
+    ->ArgNames({"keys", "loader"})
+    ->ArgsProduct({{1 << 16, 1 << 20}, {0, 1, 2}})
+    ->Unit(benchmark::kMillisecond);
+
+// A full iteration over a table that grew to "keys" elements and then
+// lost 90% of them, left as is (compact = 0) or after HashTable_Compact
+// (compact = 1).
+static void BM_HashTable_IterateAfterRemoval(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HashTable *table = MakeTable(num_keys, NULL);
+  HTKeyValue_t kv;
+
+  for (int i = 0; i < num_keys; i++) {
+    if (i % 10 != 0) {
+      HashTable_Remove(table, static_cast<HTKey_t>(i), &kv);
+    }
+  }
+  if (state.range(1) != 0) {
+    HashTable_Compact(table);
+  }
+  for (auto _ : state) {
+    HTIterator *it = HTIterator_Allocate(table);
+    while (HTIterator_IsValid(it)) {
+      HTIterator_Get(it, &kv);
+      benchmark::DoNotOptimize(kv);
+      HTIterator_Next(it);
+    }
+    HTIterator_Free(it);
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          HashTable_NumElements(table));
+  HashTable_Free(table, NULL);
+}
+BENCHMARK(BM_HashTable_IterateAfterRemoval)
+    ->ArgNames({"keys", "compact"})
+    ->ArgsProduct({{1 << 16, 1 << 20}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+
+// Key patterns for BM_HashTable_BucketScheme.
+enum KeyPattern { kSequential = 0, kStride64 = 1, kStride4096 = 2 };
+
+static HTKey_t PatternKey(int pattern, int i) {
+  switch (pattern) {
+    case kStride64:
+      return static_cast<HTKey_t>(i) * 64;
+    case kStride4096:
+      return static_cast<HTKey_t>(i) * 4096;
+    default:
+      return static_cast<HTKey_t>(i);
+  }
+}
+
+// Compares the default "key % num_buckets" scheme against power-of-two
+// buckets with a mixed key, for several key patterns.  Besides ns per
+// successful Find, reports how evenly the keys spread over the buckets.
+static void BM_HashTable_BucketScheme(benchmark::State &state) {
+  const int kNumKeys = 1 << 18;
+  int pattern = static_cast<int>(state.range(0));
+  HTOptions options = { HT_ENGINE_CHAINED };
+  options.pow2_buckets = (state.range(1) != 0);
+  HashTable *table = HashTable_AllocateWithOptions(kNumKeys / 2, &options);
+  HTKeyValue_t kv, old;
+
+  for (int i = 0; i < kNumKeys; i++) {
+    kv.key = PatternKey(pattern, i);
+    kv.value = NULL;
+    HashTable_Insert(table, kv, &old);
+  }
+
+  int i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        HashTable_Find(table, PatternKey(pattern, i), &kv));
+    i = (i + 7919) & (kNumKeys - 1);
+  }
+
+  // Chain-length distribution.
+  int max_chain = 0, empty = 0;
+  double sum_squares = 0;
+  for (int b = 0; b < table->num_buckets; b++) {
+    int len = LinkedList_NumElements(table->buckets[b]);
+    max_chain = std::max(max_chain, len);
+    empty += (len == 0);
+    sum_squares += static_cast<double>(len) * len;
+  }
+  state.counters["buckets"] = table->num_buckets;
+  state.counters["max_chain"] = max_chain;
+  state.counters["empty_pct"] = 100.0 * empty / table->num_buckets;
+  // The expected chain length seen by a successful lookup of a random key.
+  state.counters["avg_probe_len"] = sum_squares / kNumKeys;
+  HashTable_Free(table, NULL);
+}
+BENCHMARK(BM_HashTable_BucketScheme)
+    ->ArgNames({"pattern", "pow2"})
+    ->ArgsProduct({{kSequential, kStride64, kStride4096}, {0, 1}});
+
+// Batched versus one-at-a-time operations, on a table that fits in cache
+// and on one far larger than the LLC.  Each iteration resolves kBatch
+// operations on keys in random order; keys are scattered so that
+// neighbouring keys don't share buckets.
+static const int kBatch = 1024;
+
+static inline HTKey_t ScatteredKey(uint64_t i) {
+  return static_cast<HTKey_t>(i * 0x9e3779b97f4a7c15ULL);
+}
+
+// Returns a table holding ScatteredKey(0 .. num_keys-1), built once per
+// size and shared by the benchmarks below.
+static HashTable *ScatteredTable(int num_keys) {
+  static std::vector<std::pair<int, HashTable *>> tables;
+  for (auto &entry : tables) {
+    if (entry.first == num_keys) {
+      return entry.second;
+    }
+  }
+  HashTable *table = HashTable_Allocate(num_keys / 3 + 1);
+  HTKeyValue_t kv, old;
+  for (int i = 0; i < num_keys; i++) {
+    kv.key = ScatteredKey(i);
+    kv.value = NULL;
+    HashTable_Insert(table, kv, &old);
+  }
+  tables.emplace_back(num_keys, table);
+  return table;
+}
+
+// kBatch * 64 lookup keys, in random order.
+static std::vector<HTKey_t> RandomKeys(int num_keys) {
+  std::vector<HTKey_t> keys(kBatch * 64);
+  uint64_t x = 0x2545f4914f6cdd1dULL;
+  for (HTKey_t &key : keys) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    key = ScatteredKey(x % num_keys);
+  }
+  return keys;
+}
+
+static void BM_HashTable_FindLoop(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HashTable *table = ScatteredTable(num_keys);
+  std::vector<HTKey_t> keys = RandomKeys(num_keys);
+  HTKeyValue_t kv;
+  size_t next = 0;
+
+  for (auto _ : state) {
+    for (int i = 0; i < kBatch; i++) {
+      benchmark::DoNotOptimize(HashTable_Find(table, keys[next + i], &kv));
+    }
+    next = (next + kBatch) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatch);
+}
+BENCHMARK(BM_HashTable_FindLoop)->Arg(1 << 14)->Arg(1 << 22);
+
+static void BM_HashTable_FindBatch(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HashTable *table = ScatteredTable(num_keys);
+  std::vector<HTKey_t> keys = RandomKeys(num_keys);
+  std::vector<HTKeyValue_t> kvs(kBatch);
+  bool found[kBatch];
+  size_t next = 0;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(HashTable_FindBatch(
+        table, &keys[next], kBatch, kvs.data(), found));
+    next = (next + kBatch) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatch);
+}
+BENCHMARK(BM_HashTable_FindBatch)->Arg(1 << 14)->Arg(1 << 22);
+
+// The same lookups through hw1::InterleavedFind; the second argument is
+// the number of lookups kept in flight.
+static void BM_HashTable_FindInterleaved(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  int width = static_cast<int>(state.range(1));
+  HashTable *table = ScatteredTable(num_keys);
+  std::vector<HTKey_t> keys = RandomKeys(num_keys);
+  std::vector<HTKeyValue_t> kvs(kBatch);
+  bool found[kBatch];
+  size_t next = 0;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hw1::InterleavedFind(
+        table, &keys[next], kBatch, kvs.data(), found, width));
+    next = (next + kBatch) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatch);
+}
+BENCHMARK(BM_HashTable_FindInterleaved)
+    ->ArgsProduct({{1 << 14, 1 << 22}, {4, 16, 64}});
+
+// Replacing existing keys' values: the insert path's lookup, without
+// allocation or resizes muddying the comparison.
+static void BM_HashTable_InsertLoop(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HashTable *table = ScatteredTable(num_keys);
+  std::vector<HTKey_t> keys = RandomKeys(num_keys);
+  HTKeyValue_t kv, old;
+  size_t next = 0;
+
+  for (auto _ : state) {
+    for (int i = 0; i < kBatch; i++) {
+      kv.key = keys[next + i];
+      kv.value = NULL;
+      benchmark::DoNotOptimize(HashTable_Insert(table, kv, &old));
+    }
+    next = (next + kBatch) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatch);
+}
+BENCHMARK(BM_HashTable_InsertLoop)->Arg(1 << 14)->Arg(1 << 22);
+
+static void BM_HashTable_InsertBatch(benchmark::State &state) {
+  int num_keys = static_cast<int>(state.range(0));
+  HashTable *table = ScatteredTable(num_keys);
+  std::vector<HTKey_t> keys = RandomKeys(num_keys);
+  std::vector<HTKeyValue_t> kvs(keys.size()), olds(kBatch);
+  bool replaced[kBatch];
+  size_t next = 0;
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    kvs[i].key = keys[i];
+    kvs[i].value = NULL;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(HashTable_InsertBatch(
+        table, &kvs[next], kBatch, olds.data(), replaced));
+    next = (next + kBatch) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations() * kBatch);
+}
+BENCHMARK(BM_HashTable_InsertBatch)->Arg(1 << 14)->Arg(1 << 22);
+
+// Hash throughput.  Each iteration hashes kHashBuffers buffers of
+// state.range(0) bytes, one at a time with FNVHash64, all at once with
+// FNVHash64_Batch, or one at a time with WideHash64.
+static const int kHashBuffers = 64;
+
+enum HashKind { kFNV = 0, kFNVBatch = 1, kWide = 2 };
+
+static void BM_Hash(benchmark::State &state) {
+  int len = static_cast<int>(state.range(0));
+  int kind = static_cast<int>(state.range(1));
+  std::vector<unsigned char> data(static_cast<size_t>(len) * kHashBuffers);
+  unsigned char *buffers[kHashBuffers];
+  int lens[kHashBuffers];
+  HTKey_t hashes[kHashBuffers];
+
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<unsigned char>(i * 131 + 7);
+  }
+  for (int i = 0; i < kHashBuffers; i++) {
+    buffers[i] = data.data() + static_cast<size_t>(i) * len;
+    lens[i] = len;
+  }
+
+  for (auto _ : state) {
+    switch (kind) {
+      case kFNVBatch:
+        FNVHash64_Batch(buffers, lens, kHashBuffers, hashes);
+        break;
+      case kWide:
+        for (int i = 0; i < kHashBuffers; i++) {
+          hashes[i] = WideHash64(buffers[i], lens[i]);
+        }
+        break;
+      default:
+        for (int i = 0; i < kHashBuffers; i++) {
+          hashes[i] = FNVHash64(buffers[i], lens[i]);
+        }
+        break;
+    }
+    benchmark::DoNotOptimize(hashes);
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(state.iterations() * len * kHashBuffers);
+  state.SetItemsProcessed(state.iterations() * kHashBuffers);
+}
+BENCHMARK(BM_Hash)
+    ->ArgNames({"len", "kind"})
+    ->ArgsProduct({{8, 16, 64, 256, 4096}, {kFNV, kFNVBatch, kWide}});
+
+}  // namespace hw1
@@ -0,0 +1,345 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <malloc.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <chrono>
+#include <list>
+#include <random>
+#include <thread>
+#include <vector>
+
+extern "C" {
+  #include "./LinkedList.h"
+  #include "./LinkedList_priv.h"
+  #include "./UnrolledList_priv.h"
+}
+
+#include "benchmark/benchmark.h"
+#include "./bench_suite.h"
+
+namespace hw1 {
+
+static int CompareInts(LLPayload_t p1, LLPayload_t p2) {
+  intptr_t a = reinterpret_cast<intptr_t>(p1);
+  intptr_t b = reinterpret_cast<intptr_t>(p2);
+  return (a > b) - (a < b);
+}
+
+// The original LinkedList_Sort, kept here as a baseline: a bubble sort
+// that swaps payloads until nothing moves.
+static void BubbleSort(LinkedList *list, bool ascending,
+                       LLPayloadComparatorFnPtr comparator_function) {
+  if (list->num_elements < 2) {
+    return;
+  }
+  int swapped;
+  do {
+    swapped = 0;
+    for (LinkedListNode *curnode = list->head; curnode->next != NULL;
+         curnode = curnode->next) {
+      int compare_result =
+          comparator_function(curnode->payload, curnode->next->payload);
+      if (ascending) {
+        compare_result *= -1;
+      }
+      if (compare_result < 0) {
+        LLPayload_t tmp = curnode->payload;
+        curnode->payload = curnode->next->payload;
+        curnode->next->payload = tmp;
+        swapped = 1;
+      }
+    }
+  } while (swapped);
+}
+
+// Refills the list's payloads, in list order, with the same pseudo-random
+// sequence, so every iteration sorts identical input.
+static void Scramble(LinkedList *list) {
+  uint64_t x = 0x9e3779b97f4a7c15ULL;
+  for (LinkedListNode *node = list->head; node != NULL; node = node->next) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    node->payload = reinterpret_cast<LLPayload_t>(
+        static_cast<intptr_t>(x >> 40));
+  }
+}
+
+// The basic list operations on a list already holding "length" elements,
+// each next to the same workload on a std::list.  A Push/Pop or
+// Append/Slice pair leaves the list as it was.  The LinkedList benchmarks
+// take a second argument, "unrolled", choosing LinkedList_AllocateUnrolled
+// over LinkedList_Allocate.
+static LinkedList *MakeList(int length, bool unrolled = false) {
+  LinkedList *list =
+      unrolled ? LinkedList_AllocateUnrolled() : LinkedList_Allocate();
+  for (int i = 0; i < length; i++) {
+    LinkedList_Append(list, reinterpret_cast<LLPayload_t>(
+        static_cast<intptr_t>(i)));
+  }
+  return list;
+}
+
+// The heap memory a list takes per payload: the chunks of an unrolled
+// list, or each node's malloc block plus its size header.
+static double BytesPerPayload(LinkedList *list) {
+  size_t bytes = 0;
+  if (list->unrolled) {
+    for (LLChunk *chunk = list->head_chunk; chunk != NULL;
+         chunk = chunk->next) {
+      bytes += LL_CHUNK_BYTES;
+    }
+  } else {
+    for (LinkedListNode *node = list->head; node != NULL; node = node->next) {
+      bytes += malloc_usable_size(node) + sizeof(size_t);
+    }
+  }
+  return static_cast<double>(bytes) / list->num_elements;
+}
+
+static void BM_LinkedList_PushPop(benchmark::State &state) {
+  LinkedList *list = MakeList(static_cast<int>(state.range(0)),
+                              state.range(1) != 0);
+  LLPayload_t payload = NULL;
+
+  for (auto _ : state) {
+    LinkedList_Push(list, payload);
+    LinkedList_Pop(list, &payload);
+  }
+  LinkedList_Free(list, NULL);
+}
+BENCHMARK(BM_LinkedList_PushPop)
+    ->ArgNames({"length", "unrolled"})
+    ->ArgsProduct({{1, 1 << 20}, {0, 1}});
+
+static void BM_StdList_PushPop(benchmark::State &state) {
+  std::list<LLPayload_t> list(state.range(0));
+  LLPayload_t payload = NULL;
+
+  for (auto _ : state) {
+    list.push_front(payload);
+    payload = list.front();
+    list.pop_front();
+  }
+}
+BENCHMARK(BM_StdList_PushPop)->ArgName("length")->Arg(1)->Arg(1 << 20);
+
+static void BM_LinkedList_AppendSlice(benchmark::State &state) {
+  LinkedList *list = MakeList(static_cast<int>(state.range(0)),
+                              state.range(1) != 0);
+  LLPayload_t payload = NULL;
+
+  for (auto _ : state) {
+    LinkedList_Append(list, payload);
+    LLSlice(list, &payload);
+  }
+  LinkedList_Free(list, NULL);
+}
+BENCHMARK(BM_LinkedList_AppendSlice)
+    ->ArgNames({"length", "unrolled"})
+    ->ArgsProduct({{1, 1 << 20}, {0, 1}});
+
+static void BM_StdList_AppendSlice(benchmark::State &state) {
+  std::list<LLPayload_t> list(state.range(0));
+  LLPayload_t payload = NULL;
+
+  for (auto _ : state) {
+    list.push_back(payload);
+    payload = list.back();
+    list.pop_back();
+  }
+}
+BENCHMARK(BM_StdList_AppendSlice)->ArgName("length")->Arg(1)->Arg(1 << 20);
+
+// Relinks a node list's nodes in a random order, as if they had been
+// allocated at different times; MakeList allocates them back to back, in
+// list order, which is the best case for a scan.
+static void ScatterNodes(LinkedList *list) {
+  std::vector<LinkedListNode *> nodes;
+  for (LinkedListNode *node = list->head; node != NULL; node = node->next) {
+    nodes.push_back(node);
+  }
+  std::shuffle(nodes.begin(), nodes.end(), std::mt19937(333));
+  list->head = list->tail = NULL;
+  for (LinkedListNode *node : nodes) {
+    node->prev = list->tail;
+    node->next = NULL;
+    if (list->tail == NULL) {
+      list->head = node;
+    } else {
+      list->tail->next = node;
+    }
+    list->tail = node;
+  }
+}
+
+// A full LLIterator scan, also reporting the list's memory footprint.
+// "layout" is kNodes, kScatteredNodes (see ScatterNodes) or kUnrolled.
+enum { kNodes = 0, kScatteredNodes, kUnrolled };
+
+static void BM_LinkedList_Iterate(benchmark::State &state) {
+  int length = static_cast<int>(state.range(0));
+  LinkedList *list = MakeList(length, state.range(1) == kUnrolled);
+  if (state.range(1) == kScatteredNodes) {
+    ScatterNodes(list);
+  }
+  LLPayload_t payload;
+
+  for (auto _ : state) {
+    LLIterator *it = LLIterator_Allocate(list);
+    while (LLIterator_IsValid(it)) {
+      LLIterator_Get(it, &payload);
+      benchmark::DoNotOptimize(payload);
+      LLIterator_Next(it);
+    }
+    LLIterator_Free(it);
+  }
+  state.SetItemsProcessed(state.iterations() * length);
+  state.counters["bytes/payload"] = BytesPerPayload(list);
+  LinkedList_Free(list, NULL);
+}
+BENCHMARK(BM_LinkedList_Iterate)
+    ->ArgNames({"length", "layout"})
+    ->ArgsProduct({{1 << 10, 1 << 20}, {kNodes, kScatteredNodes, kUnrolled}});
+
+static void BM_StdList_Iterate(benchmark::State &state) {
+  int length = static_cast<int>(state.range(0));
+  std::list<LLPayload_t> list(length);
+
+  for (auto _ : state) {
+    for (LLPayload_t payload : list) {
+      benchmark::DoNotOptimize(payload);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_StdList_Iterate)->ArgName("length")->Arg(1 << 10)->Arg(1 << 20);
+
+template <void (*Sort)(LinkedList *, bool, LLPayloadComparatorFnPtr)>
+static void SortBenchmark(benchmark::State &state) {
+  int num_elements = static_cast<int>(state.range(0));
+  LinkedList *list = LinkedList_Allocate();
+  for (int i = 0; i < num_elements; i++) {
+    LinkedList_Append(list, NULL);
+  }
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    Scramble(list);
+    state.ResumeTiming();
+    Sort(list, true, &CompareInts);
+  }
+  state.SetItemsProcessed(state.iterations() * num_elements);
+  state.SetComplexityN(num_elements);
+  LinkedList_Free(list, NULL);
+}
+
+static void BM_LinkedList_Sort(benchmark::State &state) {
+  SortBenchmark<LinkedList_Sort>(state);
+}
+BENCHMARK(BM_LinkedList_Sort)
+    ->RangeMultiplier(10)->Range(1000, 10000000)
+    ->Unit(benchmark::kMillisecond)->Complexity(benchmark::oNLogN);
+
+// std::list::sort, a merge sort, as a baseline.
+static void BM_StdList_Sort(benchmark::State &state) {
+  int num_elements = static_cast<int>(state.range(0));
+  std::list<intptr_t> list(num_elements);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    uint64_t x = 0x9e3779b97f4a7c15ULL;
+    for (intptr_t &value : list) {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      value = static_cast<intptr_t>(x >> 40);
+    }
+    state.ResumeTiming();
+    list.sort();
+  }
+  state.SetItemsProcessed(state.iterations() * num_elements);
+  state.SetComplexityN(num_elements);
+}
+BENCHMARK(BM_StdList_Sort)
+    ->RangeMultiplier(10)->Range(1000, 10000000)
+    ->Unit(benchmark::kMillisecond)->Complexity(benchmark::oNLogN);
+
+// Radix sorting by key: one key extraction per element, no comparisons.
+static uint64_t PayloadKey(LLPayload_t payload) {
+  return static_cast<uint64_t>(reinterpret_cast<intptr_t>(payload));
+}
+
+static void SortByKey(LinkedList *list, bool ascending,
+                      LLPayloadComparatorFnPtr comparator_function) {
+  LinkedList_SortByKey(list, ascending, &PayloadKey);
+}
+
+static void BM_LinkedList_SortByKey(benchmark::State &state) {
+  SortBenchmark<SortByKey>(state);
+}
+BENCHMARK(BM_LinkedList_SortByKey)
+    ->RangeMultiplier(10)->Range(1000, 10000000)
+    ->Unit(benchmark::kMillisecond)->Complexity(benchmark::oN);
+
+// Bubble sort is quadratic; beyond 1e4 elements a single sort takes
+// minutes, so we stop there.
+static void BM_LinkedList_BubbleSort(benchmark::State &state) {
+  SortBenchmark<BubbleSort>(state);
+}
+BENCHMARK(BM_LinkedList_BubbleSort)
+    ->RangeMultiplier(10)->Range(1000, 10000)
+    ->Unit(benchmark::kMillisecond)->Complexity(benchmark::oNSquared);
+
+// LinkedList_SortParallel on a 1e6-element list with 1, 2, 4, ... threads.
+// "speedup" is relative to this benchmark's single-thread run, which runs
+// first.
+static double parallel_sort_baseline_ns;
+
+static void BM_LinkedList_SortParallel(benchmark::State &state) {
+  const int kNumElements = 1000000;
+  int num_threads = static_cast<int>(state.range(0));
+  LinkedList *list = LinkedList_Allocate();
+  for (int i = 0; i < kNumElements; i++) {
+    LinkedList_Append(list, NULL);
+  }
+
+  double sort_ns = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    Scramble(list);
+    state.ResumeTiming();
+    auto start = std::chrono::steady_clock::now();
+    LinkedList_SortParallel(list, true, &CompareInts, num_threads);
+    sort_ns += std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+  sort_ns /= state.iterations();
+  if (num_threads == 1) {
+    parallel_sort_baseline_ns = sort_ns;
+  }
+  if (parallel_sort_baseline_ns > 0) {
+    state.counters["speedup"] = parallel_sort_baseline_ns / sort_ns;
+  }
+  state.SetItemsProcessed(state.iterations() * kNumElements);
+  LinkedList_Free(list, NULL);
+}
+BENCHMARK(BM_LinkedList_SortParallel)
+    ->ArgName("threads")
+    ->RangeMultiplier(2)
+    ->Range(1, std::max(2, static_cast<int>(
+        std::thread::hardware_concurrency())))
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}  // namespace hw1
@@ -0,0 +1,65 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "benchmark/benchmark.h"
+#include "./bench_suite.h"
+
+// The real allocator entry points, and our counting wrappers.  The linker
+// redirects every malloc() call in our objects to __wrap_malloc(), and
+// __real_malloc() to the libc malloc(); see the bench_suite rule in the
+// Makefile.
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void *__real_aligned_alloc(size_t alignment, size_t size);
+
+// Atomic, since the multi-threaded benchmarks allocate from many threads
+// at once.
+static std::atomic<uint64_t> num_allocs(0);
+
+void *__wrap_malloc(size_t size) {
+  num_allocs.fetch_add(1, std::memory_order_relaxed);
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size) {
+  num_allocs.fetch_add(1, std::memory_order_relaxed);
+  return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  num_allocs.fetch_add(1, std::memory_order_relaxed);
+  return __real_realloc(ptr, size);
+}
+
+void *__wrap_aligned_alloc(size_t alignment, size_t size) {
+  num_allocs.fetch_add(1, std::memory_order_relaxed);
+  return __real_aligned_alloc(alignment, size);
+}
+}  // extern "C"
+
+uint64_t BenchAllocCount() {
+  return num_allocs.load();
+}
+
+void BenchReportAllocs(benchmark::State &state, uint64_t start) {
+  state.counters["allocs/op"] = benchmark::Counter(
+      static_cast<double>(num_allocs.load() - start),
+      benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,30 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#ifndef HW1_BENCH_SUITE_H_
+#define HW1_BENCH_SUITE_H_
+
+#include <stdint.h>
+
+#include "benchmark/benchmark.h"
+
+// The number of heap allocations (malloc, calloc, realloc and
+// aligned_alloc calls) made so far by the library and the benchmarks.  The
+// bench_suite binary is linked with --wrap for those functions so that we
+// can count them; allocations made inside libbenchmark and libstdc++ are
+// not counted.
+uint64_t BenchAllocCount();
+
+// Reports the heap allocations made since "start" as an "allocs/op"
+// counter on "state".
+void BenchReportAllocs(benchmark::State &state, uint64_t start);
+
+#endif  // HW1_BENCH_SUITE_H_
@@ -0,0 +1,130 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+extern "C" {
+  #include "./ConcurrentHashTable.h"
+  #include "./ConcurrentHashTable_priv.h"
+  #include "./HashTable_priv.h"
+}
+
+#include "gtest/gtest.h"
+
+#include "./test_suite.h"
+
+namespace hw1 {
+
+static HTValue_t KeyValue(HTKey_t key) {
+  return reinterpret_cast<HTValue_t>(static_cast<uintptr_t>(key * 2 + 1));
+}
+
+TEST(Test_ConcurrentHashTable, InsertFindRemove) {
+  ConcurrentHashTable *table = ConcurrentHashTable_Allocate(100);
+  HTKeyValue_t newkv, oldkv;
+
+  // Segments are padded out to whole cache lines.
+  ASSERT_EQ(0U, sizeof(CHTSegment) % CHT_CACHE_LINE);
+  ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(table->segments) %
+                CHT_CACHE_LINE);
+  ASSERT_EQ(0, ConcurrentHashTable_NumElements(table));
+
+  // Enough keys to resize every segment a few times.
+  for (int i = 0; i < 20000; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = KeyValue(newkv.key);
+    ASSERT_FALSE(ConcurrentHashTable_Insert(table, newkv, &oldkv));
+    ASSERT_TRUE(ConcurrentHashTable_Insert(table, newkv, &oldkv));
+    ASSERT_EQ(newkv.key, oldkv.key);
+  }
+  ASSERT_EQ(20000, ConcurrentHashTable_NumElements(table));
+
+  // Keys are spread over every segment, and each lives where it should.
+  for (int s = 0; s < CHT_NUM_SEGMENTS; s++) {
+    HashTable *segment_table = table->segments[s].table;
+    ASSERT_LT(0, HashTable_NumElements(segment_table));
+    HTIterator *it = HTIterator_Allocate(segment_table);
+    while (HTIterator_IsValid(it)) {
+      ASSERT_TRUE(HTIterator_Get(it, &oldkv));
+      ASSERT_EQ(s, CHTSegmentForKey(oldkv.key));
+      HTIterator_Next(it);
+    }
+    HTIterator_Free(it);
+  }
+
+  for (int i = 0; i < 20000; i++) {
+    HTKey_t key = static_cast<HTKey_t>(i);
+    ASSERT_TRUE(ConcurrentHashTable_Find(table, key, &oldkv));
+    ASSERT_EQ(KeyValue(key), oldkv.value);
+    if (i % 2 == 0) {
+      ASSERT_TRUE(ConcurrentHashTable_Remove(table, key, &oldkv));
+      ASSERT_FALSE(ConcurrentHashTable_Remove(table, key, &oldkv));
+      ASSERT_FALSE(ConcurrentHashTable_Find(table, key, &oldkv));
+    }
+  }
+  ASSERT_EQ(10000, ConcurrentHashTable_NumElements(table));
+  ConcurrentHashTable_Free(table, NULL);
+}
+
+TEST(Test_ConcurrentHashTable, MultiThreaded) {
+  const int kThreads = 4;
+  const int kKeysPerThread = 20000;
+  ConcurrentHashTable *table = ConcurrentHashTable_Allocate(16);
+  std::atomic<int> bad_finds(0);
+  std::vector<std::thread> threads;
+
+  // Each writer owns a disjoint range of keys: it inserts all of them,
+  // then removes the odd ones.  Meanwhile readers look up keys in every
+  // range; any key they do find must carry its own value.
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([table, t]() {
+      HTKeyValue_t newkv, oldkv;
+      for (int i = 0; i < kKeysPerThread; i++) {
+        newkv.key = static_cast<HTKey_t>(t * kKeysPerThread + i);
+        newkv.value = KeyValue(newkv.key);
+        ConcurrentHashTable_Insert(table, newkv, &oldkv);
+      }
+      for (int i = 1; i < kKeysPerThread; i += 2) {
+        HTKey_t key = static_cast<HTKey_t>(t * kKeysPerThread + i);
+        ConcurrentHashTable_Remove(table, key, &oldkv);
+      }
+    });
+    threads.emplace_back([table, &bad_finds]() {
+      HTKeyValue_t kv;
+      for (int i = 0; i < kThreads * kKeysPerThread; i++) {
+        HTKey_t key = static_cast<HTKey_t>(i);
+        if (ConcurrentHashTable_Find(table, key, &kv) &&
+            (kv.key != key || kv.value != KeyValue(key))) {
+          bad_finds++;
+        }
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(0, bad_finds.load());
+  ASSERT_EQ(kThreads * kKeysPerThread / 2,
+            ConcurrentHashTable_NumElements(table));
+  for (int i = 0; i < kThreads * kKeysPerThread; i++) {
+    HTKeyValue_t kv;
+    ASSERT_EQ(i % 2 == 0, ConcurrentHashTable_Find(
+                              table, static_cast<HTKey_t>(i), &kv));
+  }
+  ConcurrentHashTable_Free(table, NULL);
+}
+
+}  // namespace hw1
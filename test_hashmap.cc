@@ -0,0 +1,166 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <ctype.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+#include "./HashMap.h"
+#include "./test_suite.h"
+
+namespace hw1 {
+
+TEST(Test_HashMap, InsertFindRemove) {
+  HashMap<uint64_t, std::string> map;
+  std::string removed;
+
+  ASSERT_EQ(0U, map.size());
+  ASSERT_TRUE(map.empty());
+  ASSERT_EQ(nullptr, map.Find(0));
+  ASSERT_FALSE(map.Remove(0));
+
+  // Insert and replace enough keys to resize several times.
+  for (uint64_t i = 0; i < 10000; i++) {
+    ASSERT_FALSE(map.Insert(i * 4096, std::to_string(i)));
+    ASSERT_TRUE(map.Insert(i * 4096, "v" + std::to_string(i)));
+  }
+  ASSERT_EQ(10000U, map.size());
+  ASSERT_LE((10000U / HashMap<uint64_t, std::string>::kMaxLoadFactor),
+            map.bucket_count());
+
+  for (uint64_t i = 0; i < 10000; i++) {
+    const std::string *value = map.Find(i * 4096);
+    ASSERT_NE(nullptr, value);
+    ASSERT_EQ("v" + std::to_string(i), *value);
+    ASSERT_EQ(nullptr, map.Find(i * 4096 + 1));
+  }
+
+  for (uint64_t i = 0; i < 10000; i += 2) {
+    ASSERT_TRUE(map.Remove(i * 4096, &removed));
+    ASSERT_EQ("v" + std::to_string(i), removed);
+    ASSERT_FALSE(map.Remove(i * 4096));
+  }
+  ASSERT_EQ(5000U, map.size());
+  ASSERT_EQ(nullptr, map.Find(0));
+  ASSERT_NE(nullptr, map.Find(4096));
+
+  map.Clear();
+  ASSERT_TRUE(map.empty());
+  ASSERT_EQ(nullptr, map.Find(4096));
+}
+
+TEST(Test_HashMap, MovesInsteadOfCopying) {
+  HashMap<std::string, std::unique_ptr<int>> map;
+  std::unique_ptr<int> removed;
+
+  // Move-only values are moved in, and out again by Remove.
+  ASSERT_FALSE(map.Insert("one", std::make_unique<int>(1)));
+  ASSERT_TRUE(map.Insert(std::string("one"), std::make_unique<int>(11)));
+  ASSERT_EQ(11, **map.Find("one"));
+
+  // TryEmplace constructs in place, and only if the key is absent.
+  auto [value, inserted] = map.TryEmplace("two", new int(2));
+  ASSERT_TRUE(inserted);
+  ASSERT_EQ(2, **value);
+  std::unique_ptr<int> three = std::make_unique<int>(3);
+  ASSERT_FALSE(map.TryEmplace("two", std::move(three)).second);
+  ASSERT_NE(nullptr, three);  // untouched
+
+  // operator[] value-initializes a missing value.
+  ASSERT_EQ(nullptr, map["zero"]);
+  map["zero"] = std::make_unique<int>(0);
+  ASSERT_EQ(3U, map.size());
+
+  // Pointers from Find survive resizes.
+  int *one = map.Find("one")->get();
+  std::unique_ptr<int> *two = map.Find("two");
+  for (int i = 0; i < 1000; i++) {
+    map.Insert(std::to_string(i), std::make_unique<int>(i));
+  }
+  ASSERT_EQ(two, map.Find("two"));
+  ASSERT_EQ(one, map.Find("one")->get());
+
+  ASSERT_TRUE(map.Remove("one", &removed));
+  ASSERT_EQ(one, removed.get());
+
+  // Moving a map moves its elements, and leaves the source empty but
+  // usable.
+  HashMap<std::string, std::unique_ptr<int>> moved(std::move(map));
+  ASSERT_EQ(1002U, moved.size());
+  ASSERT_EQ(2, **moved.Find("two"));
+  ASSERT_TRUE(map.empty());  // NOLINT(bugprone-use-after-move)
+  ASSERT_EQ(nullptr, map.Find("two"));
+  ASSERT_FALSE(map.Insert("two", nullptr));
+  ASSERT_EQ(1U, map.size());
+  map = std::move(moved);
+  ASSERT_EQ(1002U, map.size());
+}
+
+// Hashes and compares strings case-insensitively.
+struct CaseInsensitiveHash {
+  size_t operator()(const std::string &s) const {
+    size_t h = 0;
+    for (char c : s) {
+      h = h * 31 + static_cast<size_t>(tolower(c));
+    }
+    return h;
+  }
+};
+struct CaseInsensitiveEqual {
+  bool operator()(const std::string &a, const std::string &b) const {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+             return tolower(x) == tolower(y);
+           });
+  }
+};
+
+TEST(Test_HashMap, CustomHashAndIteration) {
+  HashMap<std::string, int, CaseInsensitiveHash, CaseInsensitiveEqual> map(4);
+
+  ASSERT_EQ(4U, map.bucket_count());
+  ASSERT_FALSE(map.Insert("Hello", 1));
+  ASSERT_TRUE(map.Insert("HELLO", 2));
+  ASSERT_EQ(2, *map.Find("hello"));
+  ASSERT_EQ(1U, map.size());
+  ASSERT_EQ("Hello", map.begin()->first);  // the first spelling is kept
+  ASSERT_EQ(map.end(), ++map.begin());
+
+  // Every element is visited exactly once, and can be modified through
+  // an iterator.
+  map.Reserve(1000);
+  size_t num_buckets = map.bucket_count();
+  for (int i = 0; i < 1000; i++) {
+    map.Insert("key" + std::to_string(i), i);
+  }
+  ASSERT_EQ(num_buckets, map.bucket_count());
+  std::set<std::string> seen;
+  for (auto &kv : map) {
+    ASSERT_TRUE(seen.insert(kv.first).second);
+    kv.second *= 2;
+  }
+  ASSERT_EQ(1001U, seen.size());
+  const auto &cmap = map;
+  int sum = 0;
+  for (auto it = cmap.begin(); it != cmap.end(); it++) {
+    sum += it->second;
+  }
+  ASSERT_EQ(2 * (999 * 1000 / 2) + 4, sum);
+}
+
+}  // namespace hw1
@@ -9,13 +9,21 @@
  * author.
  */
 
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
 extern "C" {
   #include "./HashTable.h"
   #include "./HashTable_priv.h"
   #include "./LinkedList.h"
   #include "./LinkedList_priv.h"
+  #include "./MemPool_priv.h"
 }
 
+#include "./HashTableLookup.h"
+
 #include "gtest/gtest.h"
 
 #include "./test_suite.h"
@@ -58,6 +66,12 @@ class Test_HashTable : public ::testing::Test {
 int Test_HashTable::freeInvocations_;
 const int Test_HashTable::kMagicNum;
 
+// Returns the length of table's chain in "bucket", which is NULL if the
+// bucket has never held an entry.
+static int ChainLength(HashTable *table, int bucket) {
+  LinkedList *chain = table->buckets[bucket];
+  return (chain != NULL) ? LinkedList_NumElements(chain) : 0;
+}
 
 TEST_F(Test_HashTable, AllocFree) {
   HashTable *ht = HashTable_Allocate(3);
@@ -65,9 +79,9 @@ TEST_F(Test_HashTable, AllocFree) {
   ASSERT_EQ(3, ht->num_buckets);
 
   ASSERT_TRUE(ht->buckets != NULL);
-  ASSERT_EQ(0, LinkedList_NumElements(ht->buckets[0]));
-  ASSERT_EQ(0, LinkedList_NumElements(ht->buckets[1]));
-  ASSERT_EQ(0, LinkedList_NumElements(ht->buckets[2]));
+  ASSERT_EQ(0, ChainLength(ht, 0));
+  ASSERT_EQ(0, ChainLength(ht, 1));
+  ASSERT_EQ(0, ChainLength(ht, 2));
   HashTable_Free(ht, &Test_HashTable::VerifiedFree);
 }
 
@@ -393,4 +407,1020 @@ TEST_F(Test_HashTable, Resize) {
   HW1Environment::AddPoints(10);
 }
 
+TEST_F(Test_HashTable, IncrementalResize) {
+  HTOptions options = { HT_ENGINE_CHAINED, true };
+  HashTable *table = HashTable_AllocateWithOptions(10, &options);
+  HTKeyValue_t newkv, oldkv;
+  int i;
+
+  // Fill the table right up to the resize threshold.
+  for (i = 0; i < 30; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = reinterpret_cast<HTValue_t>(static_cast<int64_t>(i));
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_EQ(10, table->num_buckets);
+  ASSERT_TRUE(table->old_buckets == NULL);
+
+  // The next insert starts the resize but only migrates a few buckets.
+  newkv.key = 30;
+  newkv.value = reinterpret_cast<HTValue_t>(static_cast<int64_t>(30));
+  ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  ASSERT_EQ(90, table->num_buckets);
+  ASSERT_TRUE(table->old_buckets != NULL);
+  ASSERT_EQ(10, table->old_num_buckets);
+  ASSERT_EQ(0, table->migrate_idx);
+
+  // Every key is still findable, whichever array it currently lives in.
+  ASSERT_TRUE(HashTable_Find(table, 9, &oldkv));
+  ASSERT_EQ(static_cast<HTKey_t>(9), oldkv.key);
+  ASSERT_TRUE(table->old_buckets != NULL);
+  ASSERT_EQ(HT_MIGRATE_BUCKETS_PER_OP, table->migrate_idx);
+
+  // Replace and remove keys on both sides of the migration frontier.
+  newkv.key = 0;
+  newkv.value = NULL;
+  ASSERT_TRUE(HashTable_Insert(table, newkv, &oldkv));
+  ASSERT_EQ(static_cast<HTKey_t>(0), oldkv.key);
+  ASSERT_TRUE(HashTable_Remove(table, 29, &oldkv));
+  ASSERT_EQ(static_cast<HTKey_t>(29), oldkv.key);
+  ASSERT_FALSE(HashTable_Find(table, 29, &oldkv));
+  ASSERT_EQ(30, HashTable_NumElements(table));
+
+  // Keep looking things up until the migration completes.
+  for (i = 0; table->old_buckets != NULL; i++) {
+    ASSERT_TRUE(HashTable_Find(table, static_cast<HTKey_t>(i % 29), &oldkv));
+  }
+  ASSERT_EQ(0, table->old_num_buckets);
+  for (i = 0; i <= 30; i++) {
+    ASSERT_EQ(i != 29, HashTable_Find(table, static_cast<HTKey_t>(i), &oldkv));
+  }
+
+  // Trigger a second resize, then iterate and free mid-migration.
+  for (i = 31; table->num_buckets == 90; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = NULL;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_EQ(810, table->num_buckets);
+  ASSERT_TRUE(table->old_buckets != NULL);
+  int num_elements = HashTable_NumElements(table);
+
+  HTIterator *it = HTIterator_Allocate(table);
+  ASSERT_TRUE(table->old_buckets == NULL);
+  for (i = 0; HTIterator_IsValid(it); i++) {
+    HTIterator_Next(it);
+  }
+  ASSERT_EQ(num_elements, i);
+  HTIterator_Free(it);
+
+  HashTable_Free(table, NoOpFree);
+
+  // Freeing a table mid-migration frees the entries in both arrays.
+  table = HashTable_AllocateWithOptions(10, &options);
+  for (i = 0; i < 31; i++) {
+    Payload *np = static_cast<Payload *>(malloc(sizeof(Payload)));
+    ASSERT_TRUE(np != NULL);
+    np->magic_num = kMagicNum;
+    np->payload_num = i;
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = np;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_TRUE(table->old_buckets != NULL);
+  HashTable_Free(table, &Test_HashTable::InstrumentedFree);
+  ASSERT_EQ(31, freeInvocations_);
+}
+
+TEST_F(Test_HashTable, GrowthPolicy) {
+  HTOptions options = { HT_ENGINE_CHAINED };
+  HTKeyValue_t newkv, oldkv;
+  HTStats stats;
+
+  // Grow at one element per bucket, doubling each time.
+  options.max_load_factor = 1.0;
+  options.growth_factor = 2;
+  HashTable *table = HashTable_AllocateWithOptions(4, &options);
+  for (int i = 0; i < 4; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = NULL;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_EQ(4, table->num_buckets);
+  newkv.key = 4;
+  ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  ASSERT_EQ(8, table->num_buckets);
+  for (int i = 5; i < 100; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_EQ(128, table->num_buckets);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(HashTable_Find(table, static_cast<HTKey_t>(i), &oldkv));
+  }
+
+  // Reserving room for what's already there is a no-op; reserving more
+  // grows the table once, to exactly what it needs.
+  HashTable_Reserve(table, 100);
+  ASSERT_EQ(128, table->num_buckets);
+  HashTable_Reserve(table, 1000);
+  ASSERT_EQ(1000, table->num_buckets);
+  HashTable_GetStats(table, &stats);
+  ASSERT_EQ(6, stats.num_resizes);
+  for (int i = 100; i < 1000; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_EQ(1000, table->num_buckets);
+  HashTable_GetStats(table, &stats);
+  ASSERT_EQ(6, stats.num_resizes);
+  HashTable_Free(table, NoOpFree);
+
+  // A default table presized for a bulk load never resizes during it.
+  table = HashTable_Allocate(1);
+  HashTable_Reserve(table, 3000);
+  ASSERT_EQ(1000, table->num_buckets);
+  for (int i = 0; i < 3000; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_EQ(1000, table->num_buckets);
+  HashTable_Free(table, NoOpFree);
+
+  // Power-of-two and incremental tables round and migrate as usual.
+  options.pow2_buckets = true;
+  options.incremental_resize = true;
+  options.growth_factor = 3;
+  table = HashTable_AllocateWithOptions(4, &options);
+  ASSERT_EQ(4, table->growth_factor);
+  HashTable_Reserve(table, 100);
+  ASSERT_EQ(128, table->num_buckets);
+  for (int i = 0; i < 1000; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+    ASSERT_TRUE(HashTable_Find(table, static_cast<HTKey_t>(i / 2), &oldkv));
+  }
+  ASSERT_EQ(0, table->num_buckets & (table->num_buckets - 1));
+  ASSERT_EQ(1000, HashTable_NumElements(table));
+  HashTable_Free(table, NoOpFree);
+
+  // Swiss tables can be presized too.
+  options = { HT_ENGINE_SWISS };
+  table = HashTable_AllocateWithOptions(1, &options);
+  HashTable_Reserve(table, 1000);
+  int capacity = table->num_buckets;
+  ASSERT_LE(1000, capacity);
+  for (int i = 0; i < 1000; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_EQ(capacity, table->num_buckets);
+  HashTable_Free(table, NoOpFree);
+}
+
+// Asserts that each of table's chains is well linked and laid out
+// contiguously, node after node, as HashTable_Compact leaves them.
+static void VerifyChainsContiguous(HashTable *table) {
+  for (int i = 0; i < table->num_buckets; i++) {
+    if (table->buckets[i] == NULL) {
+      continue;
+    }
+    LinkedListNode *ln = table->buckets[i]->head;
+    for (; ln != NULL && ln->next != NULL; ln = ln->next) {
+      ASSERT_EQ(ln->next->prev, ln);
+      ASSERT_EQ(reinterpret_cast<char *>(ln) + sizeof(HTChainNode),
+                reinterpret_cast<char *>(ln->next));
+    }
+    ASSERT_EQ(ln, table->buckets[i]->tail);
+  }
+}
+
+TEST_F(Test_HashTable, ShrinkAndCompact) {
+  HTOptions options = { HT_ENGINE_CHAINED };
+  HTKeyValue_t newkv, oldkv;
+
+  // Grow from 10 to 810 buckets, then remove over 90% of the entries.
+  options.min_load_factor = 0.1;
+  HashTable *table = HashTable_AllocateWithOptions(10, &options);
+  for (int i = 0; i < 1000; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = NULL;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_EQ(810, table->num_buckets);
+  for (int i = 0; i < 925; i++) {
+    ASSERT_TRUE(HashTable_Remove(table, static_cast<HTKey_t>(i), &oldkv));
+    ASSERT_EQ(static_cast<HTKey_t>(i), oldkv.key);
+  }
+
+  // The table shrank once, when it dropped below 81 elements, to a load
+  // factor of 1/3; then it stayed put.
+  ASSERT_EQ(240, table->num_buckets);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(i >= 925, HashTable_Find(table, static_cast<HTKey_t>(i),
+                                       &oldkv));
+  }
+
+  // Removing through an iterator never shrinks the table.
+  HTIterator *it = HTIterator_Allocate(table);
+  int removed = 0;
+  while (HTIterator_IsValid(it)) {
+    ASSERT_TRUE(HTIterator_Remove(it, &oldkv));
+    removed++;
+  }
+  HTIterator_Free(it);
+  ASSERT_EQ(75, removed);
+  ASSERT_EQ(0, HashTable_NumElements(table));
+  ASSERT_EQ(240, table->num_buckets);
+
+  // The next Remove brings it down to its original size, and no further.
+  newkv.key = 1;
+  ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  ASSERT_TRUE(HashTable_Remove(table, 1, &oldkv));
+  ASSERT_EQ(10, table->num_buckets);
+  HashTable_Free(table, NoOpFree);
+
+  // Compacting a malloc'd table shrinks it and moves every node into a
+  // pool, chain by chain.
+  table = HashTable_Allocate(1);
+  for (int i = 0; i < 3000; i++) {
+    Payload *np = static_cast<Payload *>(malloc(sizeof(Payload)));
+    ASSERT_TRUE(np != NULL);
+    np->magic_num = kMagicNum;
+    np->payload_num = i;
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = np;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  for (int i = 0; i < 2900; i++) {
+    ASSERT_TRUE(HashTable_Remove(table, static_cast<HTKey_t>(i), &oldkv));
+    VerifiedFree(oldkv.value);
+  }
+  ASSERT_EQ(6561, table->num_buckets);
+  HashTable_Compact(table);
+  ASSERT_EQ(300, table->num_buckets);
+  ASSERT_TRUE(table->node_pool != NULL);
+  ASSERT_EQ(100, table->node_pool->num_live);
+  VerifyChainsContiguous(table);
+  for (int i = 2900; i < 3000; i++) {
+    ASSERT_TRUE(HashTable_Find(table, static_cast<HTKey_t>(i), &oldkv));
+    ASSERT_EQ(i, static_cast<Payload *>(oldkv.value)->payload_num);
+  }
+
+  // The compacted table carries on as a pooled one.
+  ASSERT_TRUE(HashTable_Remove(table, 2999, &oldkv));
+  VerifiedFree(oldkv.value);
+  for (int i = 0; i < 500; i++) {
+    Payload *np = static_cast<Payload *>(malloc(sizeof(Payload)));
+    ASSERT_TRUE(np != NULL);
+    np->magic_num = kMagicNum;
+    np->payload_num = i;
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = np;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_EQ(599, table->node_pool->num_live);
+  HashTable_Compact(table);
+  HashTable_Free(table, &Test_HashTable::InstrumentedFree);
+  ASSERT_EQ(599, freeInvocations_);
+
+  // A table that removals have just shrunk already fits; compacting it
+  // then leaves the bucket array alone, but still repacks the nodes.
+  options = { HT_ENGINE_CHAINED };
+  options.min_load_factor = 0.1;
+  table = HashTable_AllocateWithOptions(10, &options);
+  for (int i = 0; i < 3000; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = NULL;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  int peak_buckets = table->num_buckets, num_removed = 0;
+  while (table->num_buckets == peak_buckets) {
+    ASSERT_TRUE(HashTable_Remove(table, static_cast<HTKey_t>(num_removed++),
+                                 &oldkv));
+  }
+  HTStats stats;
+  HashTable_GetStats(table, &stats);
+  int num_buckets = table->num_buckets, num_resizes = stats.num_resizes;
+  ASSERT_TRUE(table->node_pool == NULL);
+  HashTable_Compact(table);
+  HashTable_GetStats(table, &stats);
+  ASSERT_EQ(num_resizes, stats.num_resizes);
+  ASSERT_EQ(num_buckets, table->num_buckets);
+  ASSERT_TRUE(table->node_pool != NULL);
+  ASSERT_EQ(3000 - num_removed, table->node_pool->num_live);
+  VerifyChainsContiguous(table);
+  for (int i = num_removed; i < 3000; i++) {
+    ASSERT_TRUE(HashTable_Find(table, static_cast<HTKey_t>(i), &oldkv));
+  }
+  HashTable_Free(table, NoOpFree);
+}
+
+// Asserts that table's occupancy bitmap marks exactly its non-empty
+// buckets.
+static void VerifyOccupied(HashTable *table) {
+  for (int i = 0; i < table->num_buckets; i++) {
+    bool occupied = (table->occupied[i / 64] >> (i % 64)) & 1;
+    ASSERT_EQ(ChainLength(table, i) > 0, occupied)
+        << "bucket " << i;
+  }
+}
+
+TEST_F(Test_HashTable, OccupancyBitmap) {
+  HTOptions configs[3] = { { HT_ENGINE_CHAINED },
+                           { HT_ENGINE_CHAINED, true },
+                           { HT_ENGINE_CHAINED, false, true, true } };
+  HTKeyValue_t newkv, oldkv;
+
+  for (const HTOptions &options : configs) {
+    // A sparse table: 50 keys spread over 10000 buckets.
+    HashTable *table = HashTable_AllocateWithOptions(10000, &options);
+    for (int i = 0; i < 50; i++) {
+      newkv.key = static_cast<HTKey_t>(i) * 199;
+      newkv.value = NULL;
+      ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+    }
+    VerifyOccupied(table);
+    for (int i = 0; i < 50; i += 2) {
+      ASSERT_TRUE(HashTable_Remove(table, static_cast<HTKey_t>(i) * 199,
+                                   &oldkv));
+    }
+    VerifyOccupied(table);
+
+    HTIterator *it = HTIterator_Allocate(table);
+    int count = 0;
+    for (; HTIterator_IsValid(it); HTIterator_Next(it)) {
+      ASSERT_TRUE(HTIterator_Get(it, &oldkv));
+      ASSERT_EQ(1U, (oldkv.key / 199) % 2);
+      count++;
+    }
+    ASSERT_EQ(25, count);
+    ASSERT_FALSE(HTIterator_Next(it));
+    HTIterator_Free(it);
+
+    // Emptying the table through an iterator clears every bit.
+    it = HTIterator_Allocate(table);
+    while (HTIterator_Remove(it, &oldkv)) {
+    }
+    HTIterator_Free(it);
+    ASSERT_EQ(0, HashTable_NumElements(table));
+    VerifyOccupied(table);
+
+    // The bitmap follows the chains through (incremental) resizes.
+    for (int i = 0; i < 40000; i++) {
+      newkv.key = static_cast<HTKey_t>(i);
+      ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+    }
+    it = HTIterator_Allocate(table);
+    VerifyOccupied(table);
+    for (count = 0; HTIterator_IsValid(it); HTIterator_Next(it)) {
+      count++;
+    }
+    ASSERT_EQ(40000, count);
+    HTIterator_Free(it);
+
+    // ...and through a compaction.
+    for (int i = 0; i < 40000; i++) {
+      if (i % 100 != 0) {
+        ASSERT_TRUE(HashTable_Remove(table, static_cast<HTKey_t>(i), &oldkv));
+      }
+    }
+    HashTable_Compact(table);
+    VerifyOccupied(table);
+    HashTable_Free(table, NoOpFree);
+  }
+}
+
+TEST_F(Test_HashTable, LazyBuckets) {
+  HTOptions configs[2] = { { HT_ENGINE_CHAINED },
+                           { HT_ENGINE_CHAINED, true, true } };
+  HTKeyValue_t newkv, oldkv;
+
+  for (const HTOptions &options : configs) {
+    // Until they're used, none of the buckets has a chain.
+    HashTable *table = HashTable_AllocateWithOptions(1000, &options);
+    for (int i = 0; i < table->num_buckets; i++) {
+      ASSERT_TRUE(table->buckets[i] == NULL);
+    }
+    ASSERT_FALSE(HashTable_Find(table, 5, &oldkv));
+    ASSERT_FALSE(HashTable_Remove(table, 5, &oldkv));
+
+    // An insert gives just its own bucket a chain.
+    newkv.key = 5;
+    newkv.value = NULL;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+    int bucket = HashKeyToBucketNum(table, 5);
+    ASSERT_EQ(1, ChainLength(table, bucket));
+    int chainless = 0;
+    for (int i = 0; i < table->num_buckets; i++) {
+      chainless += (table->buckets[i] == NULL);
+    }
+    ASSERT_EQ(table->num_buckets - 1, chainless);
+
+    // Resizing (and migrating) only materializes the buckets it fills.
+    for (int i = 0; i < 3001; i++) {
+      newkv.key = static_cast<HTKey_t>(i) * 10;
+      HashTable_Insert(table, newkv, &oldkv);
+    }
+    HTIterator *it = HTIterator_Allocate(table);
+    HTIterator_Free(it);
+    ASSERT_LT(1000, table->num_buckets);
+    for (int i = 0; i < table->num_buckets; i++) {
+      ASSERT_EQ(ChainLength(table, i) == 0, table->buckets[i] == NULL);
+    }
+    for (int i = 0; i < 3001; i++) {
+      ASSERT_TRUE(HashTable_Find(table, static_cast<HTKey_t>(i) * 10,
+                                 &oldkv));
+    }
+    ASSERT_TRUE(HashTable_Find(table, 5, &oldkv));
+    HashTable_Compact(table);
+    ASSERT_TRUE(HashTable_Find(table, 5, &oldkv));
+    HashTable_Free(table, NoOpFree);
+  }
+}
+
+TEST_F(Test_HashTable, IntrusiveChainNodes) {
+  HashTable *table = HashTable_Allocate(10);
+  HTKeyValue_t newkv, oldkv;
+
+  newkv.key = 13;
+  newkv.value = reinterpret_cast<HTValue_t>(static_cast<int64_t>(42));
+  ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+
+  // The pair is embedded in the chain node, right after its linkage.
+  LinkedList *chain = table->buckets[HashKeyToBucketNum(table, 13)];
+  ASSERT_EQ(1, LinkedList_NumElements(chain));
+  HTChainNode *node = reinterpret_cast<HTChainNode *>(chain->head);
+  ASSERT_EQ(static_cast<LLPayload_t>(&node->kv), node->link.payload);
+  ASSERT_EQ(static_cast<HTKey_t>(13), node->kv.key);
+  ASSERT_EQ(newkv.value, node->kv.value);
+
+  // Replacing a value updates the node in place.
+  newkv.value = NULL;
+  ASSERT_TRUE(HashTable_Insert(table, newkv, &oldkv));
+  ASSERT_EQ(node, reinterpret_cast<HTChainNode *>(chain->head));
+  ASSERT_EQ(NULL, node->kv.value);
+
+  ASSERT_TRUE(HashTable_Remove(table, 13, &oldkv));
+  ASSERT_EQ(static_cast<HTKey_t>(13), oldkv.key);
+  ASSERT_EQ(0, LinkedList_NumElements(chain));
+  HashTable_Free(table, NoOpFree);
+}
+
+TEST_F(Test_HashTable, Pooled) {
+  HTOptions options = { HT_ENGINE_CHAINED, false, true };
+  HashTable *table = HashTable_AllocateWithOptions(2, &options);
+  HTKeyValue_t newkv, oldkv;
+  ASSERT_TRUE(table->node_pool != NULL);
+
+  for (int i = 0; i < 100; i++) {
+    Payload *np = static_cast<Payload *>(malloc(sizeof(Payload)));
+    ASSERT_TRUE(np != NULL);
+    np->magic_num = kMagicNum;
+    np->payload_num = i;
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = np;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+
+  // Every chain node comes from the pool, including those that were
+  // relinked into the new bucket arrays during resizes.
+  ASSERT_LT(2, table->num_buckets);
+  ASSERT_EQ(100, table->node_pool->num_live);
+
+  for (int i = 0; i < 50; i++) {
+    ASSERT_TRUE(HashTable_Remove(table, static_cast<HTKey_t>(i), &oldkv));
+    ASSERT_EQ(static_cast<HTKey_t>(i), oldkv.key);
+    VerifiedFree(oldkv.value);
+  }
+  ASSERT_EQ(50, table->node_pool->num_live);
+  for (int i = 50; i < 100; i++) {
+    ASSERT_TRUE(HashTable_Find(table, static_cast<HTKey_t>(i), &oldkv));
+  }
+
+  HashTable_Free(table, &Test_HashTable::InstrumentedFree);
+  ASSERT_EQ(50, freeInvocations_);
+
+  // A NULL value_free_function skips the entries entirely.
+  table = HashTable_AllocateWithOptions(2, &options);
+  for (int i = 0; i < 100; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = NULL;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  HashTable_Free(table, NULL);
+}
+
+TEST_F(Test_HashTable, Pow2Buckets) {
+  HTOptions options = { HT_ENGINE_CHAINED };
+  options.pow2_buckets = true;
+  HashTable *table = HashTable_AllocateWithOptions(10, &options);
+  HTKeyValue_t newkv, oldkv;
+  ASSERT_EQ(16, table->num_buckets);
+
+  // Keys that are all multiples of 4096 would land in a single bucket if we
+  // masked them directly; the mixer must spread them out.
+  for (int i = 0; i < 48; i++) {
+    newkv.key = static_cast<HTKey_t>(i) << 12;
+    newkv.value = NULL;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_EQ(16, table->num_buckets);
+  int max_chain = 0;
+  for (int i = 0; i < table->num_buckets; i++) {
+    max_chain = std::max(max_chain, ChainLength(table, i));
+  }
+  ASSERT_GE(12, max_chain);
+
+  // Growing keeps the count a power of two, and every key stays findable.
+  newkv.key = static_cast<HTKey_t>(48) << 12;
+  ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  ASSERT_EQ(128, table->num_buckets);
+  for (int i = 0; i <= 48; i++) {
+    HTKey_t key = static_cast<HTKey_t>(i) << 12;
+    ASSERT_EQ(static_cast<int>(HTMixKey(key) & 127),
+              HashKeyToBucketNum(table, key));
+    ASSERT_TRUE(HashTable_Find(table, key, &oldkv));
+  }
+  for (int i = 0; i <= 48; i++) {
+    ASSERT_TRUE(HashTable_Remove(table, static_cast<HTKey_t>(i) << 12,
+                                 &oldkv));
+  }
+  ASSERT_EQ(0, HashTable_NumElements(table));
+  HashTable_Free(table, NoOpFree);
+
+  // Power-of-two tables can also migrate incrementally.
+  options.incremental_resize = true;
+  table = HashTable_AllocateWithOptions(4, &options);
+  for (int i = 0; i < 1000; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+    ASSERT_TRUE(HashTable_Find(table, static_cast<HTKey_t>(i / 2), &oldkv));
+  }
+  ASSERT_EQ(0, table->num_buckets & (table->num_buckets - 1));
+  HashTable_Free(table, NoOpFree);
+}
+
+TEST_F(Test_HashTable, SwissInsertFindRemove) {
+  HTOptions options = { HT_ENGINE_SWISS };
+  HashTable *table = HashTable_AllocateWithOptions(2, &options);
+  ASSERT_EQ(HT_ENGINE_SWISS, table->engine);
+  ASSERT_TRUE(table->swiss != NULL);
+  ASSERT_TRUE(table->buckets == NULL);
+  ASSERT_EQ(SWISS_GROUP_WIDTH, table->num_buckets);
+
+  HTKeyValue_t newkv, oldkv;
+
+  // Insert enough keys to force several doublings, replacing each once.
+  for (int i = 0; i < 1000; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = reinterpret_cast<HTValue_t>(static_cast<int64_t>(i));
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+    newkv.value = reinterpret_cast<HTValue_t>(static_cast<int64_t>(i + 1));
+    ASSERT_TRUE(HashTable_Insert(table, newkv, &oldkv));
+    ASSERT_EQ(newkv.key, oldkv.key);
+    ASSERT_EQ(reinterpret_cast<HTValue_t>(static_cast<int64_t>(i)),
+              oldkv.value);
+    ASSERT_EQ(i + 1, HashTable_NumElements(table));
+  }
+  ASSERT_LT(1000, table->num_buckets);
+  ASSERT_EQ(table->swiss->capacity, table->num_buckets);
+
+  for (int i = 0; i < 1000; i++) {
+    HTKey_t key = static_cast<HTKey_t>(i);
+    ASSERT_TRUE(HashTable_Find(table, key, &oldkv));
+    ASSERT_EQ(key, oldkv.key);
+    ASSERT_EQ(reinterpret_cast<HTValue_t>(static_cast<int64_t>(i + 1)),
+              oldkv.value);
+  }
+  ASSERT_FALSE(HashTable_Find(table, 1000, &oldkv));
+
+  // Remove the even keys; the odd ones must remain findable.
+  for (int i = 0; i < 1000; i += 2) {
+    HTKey_t key = static_cast<HTKey_t>(i);
+    ASSERT_TRUE(HashTable_Remove(table, key, &oldkv));
+    ASSERT_EQ(key, oldkv.key);
+    ASSERT_FALSE(HashTable_Remove(table, key, &oldkv));
+    ASSERT_FALSE(HashTable_Find(table, key, &oldkv));
+  }
+  ASSERT_EQ(500, HashTable_NumElements(table));
+  for (int i = 1; i < 1000; i += 2) {
+    ASSERT_TRUE(HashTable_Find(table, static_cast<HTKey_t>(i), &oldkv));
+  }
+
+  HashTable_Free(table, NoOpFree);
+}
+
+TEST_F(Test_HashTable, SwissTombstoneChurn) {
+  HTOptions options = { HT_ENGINE_SWISS };
+  HashTable *table = HashTable_AllocateWithOptions(64, &options);
+  HTKeyValue_t newkv, oldkv;
+
+  // Repeatedly insert and remove fresh keys with a bounded live set.  The
+  // tombstones this leaves behind must be reclaimed by same-size rehashes
+  // rather than by growing the table without bound.
+  for (int i = 0; i < 100000; i++) {
+    newkv.key = static_cast<HTKey_t>(i) * 0x10001ULL;
+    newkv.value = NULL;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+    if (i >= 32) {
+      HTKey_t victim = static_cast<HTKey_t>(i - 32) * 0x10001ULL;
+      ASSERT_TRUE(HashTable_Remove(table, victim, &oldkv));
+    }
+  }
+  ASSERT_EQ(32, HashTable_NumElements(table));
+  ASSERT_GE(128, table->num_buckets);
+  for (int i = 100000 - 32; i < 100000; i++) {
+    ASSERT_TRUE(HashTable_Find(table, static_cast<HTKey_t>(i) * 0x10001ULL,
+                               &oldkv));
+  }
+
+  HashTable_Free(table, NoOpFree);
+}
+
+TEST_F(Test_HashTable, SwissIterator) {
+  HTOptions options = { HT_ENGINE_SWISS };
+  HashTable *table = HashTable_AllocateWithOptions(8, &options);
+  HTKeyValue_t newkv, oldkv;
+
+  HTIterator *it = HTIterator_Allocate(table);
+  ASSERT_FALSE(HTIterator_IsValid(it));
+  ASSERT_FALSE(HTIterator_Get(it, &oldkv));
+  HTIterator_Free(it);
+
+  for (int i = 0; i < 100; i++) {
+    Payload *np = static_cast<Payload *>(malloc(sizeof(Payload)));
+    ASSERT_TRUE(np != NULL);
+    np->magic_num = kMagicNum;
+    np->payload_num = i;
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = np;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+
+  // Visit every element exactly once, removing every third one.
+  int num_times_seen[100] = { 0 };
+  it = HTIterator_Allocate(table);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(HTIterator_IsValid(it));
+    ASSERT_TRUE(HTIterator_Get(it, &oldkv));
+    int htkey = static_cast<int>(oldkv.key);
+    ASSERT_EQ(0, num_times_seen[htkey]);
+    num_times_seen[htkey]++;
+    ASSERT_EQ(htkey, static_cast<Payload *>(oldkv.value)->payload_num);
+
+    if (htkey % 3 == 0) {
+      ASSERT_TRUE(HTIterator_Remove(it, &oldkv));
+      free(oldkv.value);
+    } else {
+      ASSERT_EQ(i != 99, HTIterator_Next(it));
+    }
+  }
+  ASSERT_FALSE(HTIterator_IsValid(it));
+  ASSERT_FALSE(HTIterator_Next(it));
+  HTIterator_Free(it);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(1, num_times_seen[i]);
+  }
+
+  ASSERT_EQ(66, HashTable_NumElements(table));
+  HashTable_Free(table, &Test_HashTable::InstrumentedFree);
+  ASSERT_EQ(66, freeInvocations_);
+}
+
+TEST_F(Test_HashTable, Batch) {
+  const int kCount = 3000;
+  HTOptions configs[3] = { { HT_ENGINE_CHAINED },
+                           { HT_ENGINE_CHAINED, true, true },
+                           { HT_ENGINE_SWISS } };
+  std::vector<HTKeyValue_t> kvs(kCount), olds(kCount);
+  std::vector<HTKey_t> keys(kCount);
+  bool flags[kCount];
+
+  // Every key appears twice, the second time (later in the batch) with a
+  // new value, so a batch both adds and replaces, and grows the table as
+  // it goes.
+  for (int i = 0; i < kCount; i++) {
+    kvs[i].key = static_cast<HTKey_t>((i % (kCount / 2)) * 7919);
+    kvs[i].value = reinterpret_cast<HTValue_t>(static_cast<intptr_t>(i));
+  }
+
+  for (const HTOptions &options : configs) {
+    HashTable *table = HashTable_AllocateWithOptions(2, &options);
+    ASSERT_EQ(kCount / 2, HashTable_InsertBatch(table, kvs.data(), kCount,
+                                                olds.data(), flags));
+    ASSERT_EQ(kCount / 2, HashTable_NumElements(table));
+    for (int i = 0; i < kCount; i++) {
+      ASSERT_EQ(i >= kCount / 2, flags[i]);
+      if (flags[i]) {
+        ASSERT_EQ(kvs[i - kCount / 2].key, olds[i].key);
+        ASSERT_EQ(kvs[i - kCount / 2].value, olds[i].value);
+      }
+    }
+
+    // Look up every other inserted key, interleaved with absent keys.
+    for (int i = 0; i < kCount; i++) {
+      keys[i] = (i % 2 == 0) ? kvs[i].key : kvs[i].key + 1;
+    }
+    ASSERT_EQ(kCount / 2, HashTable_FindBatch(table, keys.data(), kCount,
+                                              olds.data(), flags));
+    for (int i = 0; i < kCount; i++) {
+      ASSERT_EQ(i % 2 == 0, flags[i]);
+      if (flags[i]) {
+        HTKeyValue_t expected;
+        ASSERT_TRUE(HashTable_Find(table, keys[i], &expected));
+        ASSERT_EQ(expected.key, olds[i].key);
+        ASSERT_EQ(expected.value, olds[i].value);
+      }
+    }
+
+    // Empty batches are fine.
+    ASSERT_EQ(0, HashTable_FindBatch(table, keys.data(), 0, olds.data(),
+                                     flags));
+    HashTable_Free(table, NULL);
+
+    // Within a single group, a key's later inserts see its earlier ones,
+    // even when the first of them gave its bucket a chain.
+    table = HashTable_AllocateWithOptions(64, &options);
+    HTKeyValue_t repeats[8], repeat_olds[8];
+    for (int i = 0; i < 8; i++) {
+      repeats[i].key = static_cast<HTKey_t>(i % 2);
+      repeats[i].value = reinterpret_cast<HTValue_t>(static_cast<intptr_t>(i));
+    }
+    ASSERT_EQ(6, HashTable_InsertBatch(table, repeats, 8, repeat_olds, flags));
+    ASSERT_EQ(2, HashTable_NumElements(table));
+    for (int i = 2; i < 8; i++) {
+      ASSERT_TRUE(flags[i]);
+      ASSERT_EQ(repeats[i - 2].value, repeat_olds[i].value);
+    }
+    HashTable_Free(table, NULL);
+  }
+}
+
+TEST_F(Test_HashTable, InterleavedFind) {
+  const int kCount = 3000;
+  HTOptions configs[3] = { { HT_ENGINE_CHAINED, true },
+                           { HT_ENGINE_CHAINED, false, true, true },
+                           { HT_ENGINE_SWISS } };
+  std::vector<HTKey_t> keys(kCount);
+  std::vector<HTKeyValue_t> kvs(kCount);
+  bool found[kCount];
+
+  for (const HTOptions &options : configs) {
+    HashTable *table = HashTable_AllocateWithOptions(2, &options);
+    HTKeyValue_t kv, oldkv;
+
+    // Fill the table; the incrementally-resizing one is left part way
+    // through a resize, so some keys are still in its old buckets.
+    int num_inserted = 0;
+    while (num_inserted < kCount / 2 ||
+           (options.incremental_resize && table->old_buckets == NULL)) {
+      kv.key = static_cast<HTKey_t>(num_inserted) * 7919;
+      kv.value = reinterpret_cast<HTValue_t>(
+          static_cast<intptr_t>(num_inserted));
+      ASSERT_FALSE(HashTable_Insert(table, kv, &oldkv));
+      num_inserted++;
+    }
+
+    // Present and absent keys alternate.
+    for (int i = 0; i < kCount; i++) {
+      keys[i] = static_cast<HTKey_t>(i / 2) * 7919 + i % 2;
+    }
+    for (int width : {1, 3, hw1::kDefaultLookupWidth, 2 * kCount}) {
+      ASSERT_EQ(kCount / 2, hw1::InterleavedFind(table, keys.data(), kCount,
+                                                  kvs.data(), found, width));
+      for (int i = 0; i < kCount; i++) {
+        ASSERT_EQ(i % 2 == 0, found[i]);
+        if (found[i]) {
+          ASSERT_EQ(keys[i], kvs[i].key);
+          ASSERT_EQ(i / 2, reinterpret_cast<intptr_t>(kvs[i].value));
+        }
+      }
+    }
+
+    // Stepped lookups don't advance the resize.
+    if (options.incremental_resize) {
+      ASSERT_NE(nullptr, table->old_buckets);
+    }
+    ASSERT_EQ(0, hw1::InterleavedFind(table, keys.data(), 0, kvs.data(),
+                                      found));
+    HashTable_Free(table, NULL);
+  }
+}
+
+TEST_F(Test_HashTable, Stats) {
+  HTOptions options = { HT_ENGINE_CHAINED };
+  HTKeyValue_t newkv, oldkv;
+  HTStats stats;
+
+  // Keys 0..9 in a 10-bucket table land one per bucket; then pile 20 more
+  // keys into bucket 0.
+  HashTable *table = HashTable_Allocate(10);
+  for (int i = 0; i < 30; i++) {
+    newkv.key = static_cast<HTKey_t>(i < 10 ? i : (i - 9) * 10);
+    newkv.value = NULL;
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  HashTable_GetStats(table, &stats);
+  ASSERT_EQ(30, stats.num_elements);
+  ASSERT_EQ(10, stats.num_buckets);
+  ASSERT_DOUBLE_EQ(3.0, stats.load_factor);
+  ASSERT_EQ(0, stats.empty_buckets);
+  ASSERT_EQ(21, stats.max_chain_length);
+  ASSERT_EQ(9, stats.chain_length_histogram[1]);
+  ASSERT_EQ(1, stats.chain_length_histogram[HT_STATS_HISTOGRAM_BINS - 1]);
+  ASSERT_EQ(0, stats.num_resizes);
+
+  // Finds aren't counted unless we ask for them.
+  ASSERT_TRUE(HashTable_Find(table, 5, &oldkv));
+  HashTable_GetStats(table, &stats);
+  ASSERT_EQ(0U, stats.num_finds);
+  ASSERT_EQ(0.0, stats.avg_probes_per_find);
+
+  // The next insert resizes to 90 buckets.
+  newkv.key = 1000;
+  ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  HashTable_GetStats(table, &stats);
+  ASSERT_EQ(1, stats.num_resizes);
+  ASSERT_LE(0.0, stats.resize_seconds);
+  ASSERT_EQ(90, stats.num_buckets);
+  int total = 0, entries = 0;
+  for (int i = 0; i < HT_STATS_HISTOGRAM_BINS; i++) {
+    total += stats.chain_length_histogram[i];
+    entries += i * stats.chain_length_histogram[i];
+  }
+  ASSERT_EQ(90, total);
+  ASSERT_EQ(31, entries);
+  ASSERT_EQ(stats.chain_length_histogram[0], stats.empty_buckets);
+  HashTable_Free(table, NoOpFree);
+
+  // With collect_stats, every Find counts its key comparisons.
+  options.collect_stats = true;
+  table = HashTable_AllocateWithOptions(1, &options);
+  for (int i = 0; i < 3; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+  }
+  ASSERT_TRUE(HashTable_Find(table, 0, &oldkv));   // 1 probe
+  ASSERT_TRUE(HashTable_Find(table, 2, &oldkv));   // 3 probes
+  ASSERT_FALSE(HashTable_Find(table, 7, &oldkv));  // 3 probes
+  HTKey_t keys[2] = { 1, 9 };                      // 2 + 3 probes
+  HTKeyValue_t kvs[2];
+  bool found[2];
+  ASSERT_EQ(1, HashTable_FindBatch(table, keys, 2, kvs, found));
+  HashTable_GetStats(table, &stats);
+  ASSERT_EQ(5U, stats.num_finds);
+  ASSERT_DOUBLE_EQ(12.0 / 5, stats.avg_probes_per_find);
+
+  // So do stepped lookups, one at a time or interleaved.
+  HTLookup lookup;
+  HashTable_LookupStart(table, 2, &lookup);        // 3 probes
+  while (HashTable_LookupStep(&lookup, &oldkv) == HT_LOOKUP_PENDING) {
+  }
+  keys[0] = 0;                                     // 1 probe
+  keys[1] = 8;                                     // 3 probes
+  ASSERT_EQ(1, hw1::InterleavedFind(table, keys, 2, kvs, found));
+  HashTable_GetStats(table, &stats);
+  ASSERT_EQ(8U, stats.num_finds);
+  ASSERT_DOUBLE_EQ(19.0 / 8, stats.avg_probes_per_find);
+  HashTable_Free(table, NoOpFree);
+
+  // A swiss table reports probe sequences measured in groups.
+  options.engine = HT_ENGINE_SWISS;
+  table = HashTable_AllocateWithOptions(16, &options);
+  for (int i = 0; i < 100; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    ASSERT_FALSE(HashTable_Insert(table, newkv, &oldkv));
+    ASSERT_TRUE(HashTable_Find(table, newkv.key, &oldkv));
+  }
+  HashTable_GetStats(table, &stats);
+  ASSERT_EQ(100, stats.num_elements);
+  ASSERT_EQ(table->swiss->capacity, stats.num_buckets);
+  ASSERT_EQ(stats.num_buckets - 100, stats.empty_buckets);
+  ASSERT_LT(0, stats.num_resizes);
+  ASSERT_EQ(0, stats.chain_length_histogram[0]);
+  ASSERT_LE(1, stats.max_chain_length);
+  total = 0;
+  for (int i = 0; i < HT_STATS_HISTOGRAM_BINS; i++) {
+    total += stats.chain_length_histogram[i];
+  }
+  ASSERT_EQ(100, total);
+  ASSERT_EQ(100U, stats.num_finds);
+  ASSERT_LE(1.0, stats.avg_probes_per_find);
+
+  // Batched and interleaved swiss lookups probe at least a group apiece.
+  HTKey_t swiss_keys[4] = { 1, 2, 3, 1000 };
+  HTKeyValue_t swiss_kvs[4];
+  bool swiss_found[4];
+  ASSERT_EQ(3, HashTable_FindBatch(table, swiss_keys, 4, swiss_kvs,
+                                   swiss_found));
+  ASSERT_EQ(3, hw1::InterleavedFind(table, swiss_keys, 4, swiss_kvs,
+                                    swiss_found));
+  HashTable_GetStats(table, &stats);
+  ASSERT_EQ(108U, stats.num_finds);
+  ASSERT_LE(1.0, stats.avg_probes_per_find);
+  HashTable_Free(table, NoOpFree);
+}
+
+TEST_F(Test_HashTable, FNVBatch) {
+  // Buffers of assorted lengths (including empty ones), and a count that
+  // doesn't divide evenly into batches.
+  const int kNumBuffers = 23;
+  unsigned char data[kNumBuffers][40];
+  unsigned char *buffers[kNumBuffers];
+  int lens[kNumBuffers];
+  HTKey_t hashes[kNumBuffers];
+
+  for (int i = 0; i < kNumBuffers; i++) {
+    for (int j = 0; j < 40; j++) {
+      data[i][j] = static_cast<unsigned char>(i * 31 + j * 7);
+    }
+    buffers[i] = data[i];
+    lens[i] = (i * 13) % 41;
+  }
+  FNVHash64_Batch(buffers, lens, kNumBuffers, hashes);
+  for (int i = 0; i < kNumBuffers; i++) {
+    ASSERT_EQ(FNVHash64(buffers[i], lens[i]), hashes[i]);
+  }
+
+  // Every prefix of the batch must agree too.
+  for (int count = 0; count < kNumBuffers; count++) {
+    HTKey_t prefix[kNumBuffers];
+    FNVHash64_Batch(buffers, lens, count, prefix);
+    for (int i = 0; i < count; i++) {
+      ASSERT_EQ(hashes[i], prefix[i]);
+    }
+  }
+}
+
+TEST_F(Test_HashTable, HashQuality) {
+  const int kNumKeys = 1 << 16;
+  const int kNumBuckets = 1 << 10;
+  std::vector<HTKey_t> fnv(kNumKeys), wide(kNumKeys);
+  char buf[32];
+
+  for (int i = 0; i < kNumKeys; i++) {
+    int len = snprintf(buf, sizeof(buf), "key%d", i);
+    unsigned char *bytes = reinterpret_cast<unsigned char *>(buf);
+    fnv[i] = FNVHash64(bytes, len);
+    wide[i] = WideHash64(bytes, len);
+  }
+
+  // Similar keys must spread evenly over buckets chosen by both the low
+  // and the high bits.  A chi-squared statistic with 1023 degrees of
+  // freedom has a standard deviation of about 45.
+  auto chi_squared = [&](const std::vector<HTKey_t> &hashes, int shift) {
+    std::vector<int> counts(kNumBuckets, 0);
+    for (HTKey_t h : hashes) {
+      counts[(h >> shift) & (kNumBuckets - 1)]++;
+    }
+    double expected = static_cast<double>(kNumKeys) / kNumBuckets;
+    double chi2 = 0;
+    for (int c : counts) {
+      chi2 += (c - expected) * (c - expected) / expected;
+    }
+    return chi2;
+  };
+  ASSERT_GT(1300, chi_squared(fnv, 0));
+  ASSERT_GT(1300, chi_squared(wide, 0));
+  ASSERT_GT(1300, chi_squared(wide, 54));
+
+  // No 64-bit collisions.
+  std::sort(wide.begin(), wide.end());
+  ASSERT_TRUE(std::adjacent_find(wide.begin(), wide.end()) == wide.end());
+  std::sort(fnv.begin(), fnv.end());
+  ASSERT_TRUE(std::adjacent_find(fnv.begin(), fnv.end()) == fnv.end());
+
+  // Avalanche: flipping any one input bit should flip each output bit of
+  // WideHash64 about half the time, for short, medium and long inputs.
+  const int kLens[] = { 3, 8, 24, 100 };
+  uint64_t state = 0x9e3779b97f4a7c15ULL;
+  for (int len : kLens) {
+    std::vector<unsigned char> input(len);
+    int flips[64] = { 0 };
+    int trials = 0;
+    for (int sample = 0; sample < 100; sample++) {
+      for (int j = 0; j < len; j++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        input[j] = static_cast<unsigned char>(state >> 56);
+      }
+      HTKey_t base = WideHash64(input.data(), len);
+      for (int bit = 0; bit < len * 8; bit++) {
+        input[bit / 8] ^= static_cast<unsigned char>(1 << (bit % 8));
+        HTKey_t diff = base ^ WideHash64(input.data(), len);
+        input[bit / 8] ^= static_cast<unsigned char>(1 << (bit % 8));
+        for (int out = 0; out < 64; out++) {
+          flips[out] += (diff >> out) & 1;
+        }
+        trials++;
+      }
+    }
+    for (int out = 0; out < 64; out++) {
+      double p = static_cast<double>(flips[out]) / trials;
+      ASSERT_LT(0.4, p) << "len " << len << " output bit " << out;
+      ASSERT_GT(0.6, p) << "len " << len << " output bit " << out;
+    }
+  }
+}
+
 }  // namespace hw1
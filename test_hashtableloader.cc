@@ -0,0 +1,159 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+
+extern "C" {
+  #include "./HashTable.h"
+  #include "./HashTableLoader.h"
+}
+
+#include "gtest/gtest.h"
+
+#include "./test_suite.h"
+
+namespace hw1 {
+
+// Records are "<key> <value>", with a decimal key; anything else is
+// skipped.  The value is a heap-allocated copy of the rest of the line, so
+// that replaced values must be freed.
+static bool ParseRecord(const char *record, size_t len, void *arg,
+                        HTKeyValue_t *keyvalue) {
+  char *end;
+  int *num_parsed = static_cast<int *>(arg);
+
+  EXPECT_EQ(strlen(record), len);
+  keyvalue->key = strtoull(record, &end, 10);
+  if (end == record || *end != ' ') {
+    return false;
+  }
+  keyvalue->value = strdup(end + 1);
+  (*num_parsed)++;
+  return true;
+}
+
+static int num_freed = 0;
+static void FreeValue(HTValue_t value) {
+  num_freed++;
+  free(value);
+}
+
+class Test_HashTableLoader : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char path[] = "/tmp/test_hashtableloader.XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_LE(0, fd);
+    close(fd);
+    path_ = path;
+    num_freed = 0;
+  }
+
+  void TearDown() override {
+    unlink(path_.c_str());
+  }
+
+  void WriteFile(const std::string &contents) {
+    FILE *f = fopen(path_.c_str(), "wb");
+    ASSERT_NE(nullptr, f);
+    ASSERT_EQ(contents.size(), fwrite(contents.data(), 1, contents.size(), f));
+    fclose(f);
+  }
+
+  std::string path_;
+};
+
+TEST_F(Test_HashTableLoader, LoadsEveryRecord) {
+  // Big enough to span several of the loader's chunks, with records of
+  // varying length so that they straddle chunk boundaries at many offsets.
+  const int kRecords = 300000;
+  std::string contents;
+  for (int i = 0; i < kRecords; i++) {
+    contents += std::to_string(i) + " " + std::string(i % 13, '7') + "\n";
+  }
+  ASSERT_LT(3 << 20, static_cast<int>(contents.size()));
+  WriteFile(contents);
+
+  for (int size_hint : {0, kRecords}) {
+    HTOptions options;
+    memset(&options, 0, sizeof(options));
+    options.collect_stats = true;
+    HashTable *table = HashTable_AllocateWithOptions(1, &options);
+    HTStats before, after;
+    HashTable_GetStats(table, &before);
+
+    int num_parsed = 0;
+    ASSERT_EQ(kRecords,
+              HashTable_LoadFile(table, path_.c_str(), &ParseRecord,
+                                 &num_parsed, size_hint, &FreeValue));
+    ASSERT_EQ(kRecords, num_parsed);
+    ASSERT_EQ(kRecords, HashTable_NumElements(table));
+
+    // The table was sized once, up front, and never resized mid-load.
+    HashTable_GetStats(table, &after);
+    ASSERT_EQ(before.num_resizes + 1, after.num_resizes);
+
+    for (int i = 0; i < kRecords; i += 997) {
+      HTKeyValue_t kv;
+      ASSERT_TRUE(HashTable_Find(table, static_cast<HTKey_t>(i), &kv));
+      ASSERT_EQ(std::string(i % 13, '7'), static_cast<char *>(kv.value));
+    }
+    HashTable_Free(table, &FreeValue);
+  }
+  ASSERT_EQ(2 * kRecords, num_freed);
+}
+
+TEST_F(Test_HashTableLoader, ReplacesAndSkips) {
+  HashTable *table = HashTable_Allocate(4);
+  HTKeyValue_t kv, oldkv;
+  int num_parsed = 0;
+
+  kv.key = 5;
+  kv.value = strdup("old");
+  ASSERT_FALSE(HashTable_Insert(table, kv, &oldkv));
+
+  // Blank and malformed lines are skipped, later records win, and the
+  // last line needn't end in a newline.
+  WriteFile("1 a\n\n# comment\n5 b\n1 c\n2 d");
+  ASSERT_EQ(4, HashTable_LoadFile(table, path_.c_str(), &ParseRecord,
+                                  &num_parsed, 0, &FreeValue));
+  ASSERT_EQ(4, num_parsed);
+  ASSERT_EQ(2, num_freed);  // "old" and "a"
+  ASSERT_EQ(3, HashTable_NumElements(table));
+  ASSERT_TRUE(HashTable_Find(table, 1, &kv));
+  ASSERT_STREQ("c", static_cast<char *>(kv.value));
+  ASSERT_TRUE(HashTable_Find(table, 2, &kv));
+  ASSERT_STREQ("d", static_cast<char *>(kv.value));
+  ASSERT_TRUE(HashTable_Find(table, 5, &kv));
+  ASSERT_STREQ("b", static_cast<char *>(kv.value));
+
+  // An empty file loads nothing.
+  WriteFile("");
+  ASSERT_EQ(0, HashTable_LoadFile(table, path_.c_str(), &ParseRecord,
+                                  &num_parsed, 0, &FreeValue));
+  ASSERT_EQ(3, HashTable_NumElements(table));
+
+  // A file that can't be opened is an error.
+  errno = 0;
+  ASSERT_EQ(-1, HashTable_LoadFile(table, "/nonexistent/records",
+                                   &ParseRecord, &num_parsed, 0, &FreeValue));
+  ASSERT_EQ(ENOENT, errno);
+  HashTable_Free(table, &FreeValue);
+}
+
+}  // namespace hw1
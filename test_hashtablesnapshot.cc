@@ -0,0 +1,238 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <glob.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+
+extern "C" {
+  #include "./HashTable.h"
+  #include "./HashTableSnapshot.h"
+  #include "./HashTableSnapshot_priv.h"
+}
+
+#include "gtest/gtest.h"
+
+#include "./test_suite.h"
+
+namespace hw1 {
+
+// Values in these tests are NUL-terminated strings.
+static void StringBytes(HTValue_t value, const void **bytes, size_t *len) {
+  *bytes = value;
+  *len = strlen(static_cast<char *>(value)) + 1;
+}
+
+static void FreeString(HTValue_t value) {
+  delete[] static_cast<char *>(value);
+}
+
+static char *MakeString(int i) {
+  std::string s = "value-" + std::string(i % 7, '*') + std::to_string(i);
+  char *value = new char[s.size() + 1];
+  memcpy(value, s.c_str(), s.size() + 1);
+  return value;
+}
+
+class Test_HashTableSnapshot : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char path[] = "/tmp/test_hashtablesnapshot.XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_LE(0, fd);
+    close(fd);
+    path_ = path;
+  }
+
+  void TearDown() override {
+    unlink(path_.c_str());
+  }
+
+  std::string path_;
+};
+
+TEST_F(Test_HashTableSnapshot, BlobValues) {
+  HashTable *table = HashTable_Allocate(10);
+  HTKeyValue_t kv, oldkv;
+  size_t len;
+
+  for (int i = 0; i < 5000; i++) {
+    kv.key = static_cast<HTKey_t>(i) * 7919;
+    kv.value = MakeString(i);
+    ASSERT_FALSE(HashTable_Insert(table, kv, &oldkv));
+  }
+  ASSERT_TRUE(HashTable_Save(table, path_.c_str(), &StringBytes));
+
+  HTSnapshot *snapshot = HashTable_MapFile(path_.c_str());
+  ASSERT_NE(nullptr, snapshot);
+  ASSERT_EQ(5000, HTSnapshot_NumElements(snapshot));
+  for (int i = 0; i < 5000; i++) {
+    HTKey_t key = static_cast<HTKey_t>(i) * 7919;
+    ASSERT_TRUE(HashTable_Find(table, key, &oldkv));
+    ASSERT_TRUE(HTSnapshot_Find(snapshot, key, &kv, &len));
+    ASSERT_EQ(key, kv.key);
+    ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(kv.value) % 8);
+    ASSERT_EQ(strlen(static_cast<char *>(oldkv.value)) + 1, len);
+    ASSERT_STREQ(static_cast<char *>(oldkv.value),
+                 static_cast<char *>(kv.value));
+
+    // Keys that were never inserted are missing.
+    ASSERT_FALSE(HTSnapshot_Find(snapshot, key + 1, &kv, &len));
+  }
+
+  // The snapshot doesn't depend on the table that it came from.
+  HashTable_Free(table, &FreeString);
+  ASSERT_TRUE(HTSnapshot_Find(snapshot, 7919, &kv, NULL));
+  ASSERT_STREQ("value-*1", static_cast<char *>(kv.value));
+  HTSnapshot_Unmap(snapshot);
+}
+
+TEST_F(Test_HashTableSnapshot, InlineValues) {
+  HTOptions options;
+  memset(&options, 0, sizeof(options));
+  options.incremental_resize = true;
+  HashTable *table = HashTable_AllocateWithOptions(2, &options);
+  HTKeyValue_t kv, oldkv;
+  size_t len;
+
+  // Save mid-resize; the snapshot must still have every key.
+  for (int i = 0; i < 1000; i++) {
+    kv.key = static_cast<HTKey_t>(i);
+    kv.value = reinterpret_cast<HTValue_t>(static_cast<uintptr_t>(i * 3));
+    HashTable_Insert(table, kv, &oldkv);
+  }
+  ASSERT_TRUE(HashTable_Save(table, path_.c_str(), NULL));
+
+  HTSnapshot *snapshot = HashTable_MapFile(path_.c_str());
+  ASSERT_NE(nullptr, snapshot);
+  ASSERT_EQ(1000, HTSnapshot_NumElements(snapshot));
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(HTSnapshot_Find(snapshot, static_cast<HTKey_t>(i), &kv,
+                                &len));
+    ASSERT_EQ(static_cast<uintptr_t>(i * 3),
+              reinterpret_cast<uintptr_t>(kv.value));
+    ASSERT_EQ(0U, len);
+  }
+  ASSERT_FALSE(HTSnapshot_Find(snapshot, 1000, &kv, &len));
+  HTSnapshot_Unmap(snapshot);
+  HashTable_Free(table, NULL);
+
+  // An empty table makes a valid, empty snapshot.
+  table = HashTable_Allocate(1);
+  ASSERT_TRUE(HashTable_Save(table, path_.c_str(), NULL));
+  snapshot = HashTable_MapFile(path_.c_str());
+  ASSERT_NE(nullptr, snapshot);
+  ASSERT_EQ(0, HTSnapshot_NumElements(snapshot));
+  ASSERT_FALSE(HTSnapshot_Find(snapshot, 0, &kv, &len));
+  HTSnapshot_Unmap(snapshot);
+  HashTable_Free(table, NULL);
+}
+
+TEST_F(Test_HashTableSnapshot, RejectsBadFiles) {
+  HashTable *table = HashTable_Allocate(10);
+  HTSnapshotHeader header;
+  HTKeyValue_t kv, oldkv;
+  FILE *f;
+
+  ASSERT_EQ(nullptr, HashTable_MapFile("/nonexistent/snapshot"));
+  ASSERT_FALSE(HashTable_Save(table, "/nonexistent/snapshot", NULL));
+
+  // Too short to hold a header.
+  f = fopen(path_.c_str(), "wb");
+  ASSERT_NE(nullptr, f);
+  fputs("HWHTSNAP", f);
+  fclose(f);
+  ASSERT_EQ(nullptr, HashTable_MapFile(path_.c_str()));
+
+  for (int i = 0; i < 100; i++) {
+    kv.key = static_cast<HTKey_t>(i);
+    kv.value = reinterpret_cast<HTValue_t>(static_cast<uintptr_t>(i));
+    HashTable_Insert(table, kv, &oldkv);
+  }
+  ASSERT_TRUE(HashTable_Save(table, path_.c_str(), NULL));
+  f = fopen(path_.c_str(), "r+b");
+  ASSERT_NE(nullptr, f);
+  ASSERT_EQ(1U, fread(&header, sizeof(header), 1, f));
+
+  // Each corruption in turn is rejected, and putting the header back
+  // makes the file good again.
+  HTSnapshotHeader bad[4] = { header, header, header, header };
+  bad[0].magic ^= 1;
+  bad[1].version++;
+  bad[2].num_buckets = 3;
+  bad[3].entries_offset += 1 << 20;
+  for (const HTSnapshotHeader &h : bad) {
+    rewind(f);
+    ASSERT_EQ(1U, fwrite(&h, sizeof(h), 1, f));
+    fflush(f);
+    ASSERT_EQ(nullptr, HashTable_MapFile(path_.c_str()));
+  }
+  rewind(f);
+  ASSERT_EQ(1U, fwrite(&header, sizeof(header), 1, f));
+  fclose(f);
+
+  HTSnapshot *snapshot = HashTable_MapFile(path_.c_str());
+  ASSERT_NE(nullptr, snapshot);
+  ASSERT_EQ(100, HTSnapshot_NumElements(snapshot));
+  HTSnapshot_Unmap(snapshot);
+  HashTable_Free(table, NULL);
+}
+
+TEST_F(Test_HashTableSnapshot, ConcurrentSaves) {
+  HashTable *small = HashTable_Allocate(10);
+  HashTable *large = HashTable_Allocate(10);
+  HTKeyValue_t kv, oldkv;
+
+  for (int i = 0; i < 200; i++) {
+    kv.key = static_cast<HTKey_t>(i);
+    kv.value = reinterpret_cast<HTValue_t>(static_cast<uintptr_t>(i));
+    if (i < 100) {
+      HashTable_Insert(small, kv, &oldkv);
+    }
+    HashTable_Insert(large, kv, &oldkv);
+  }
+
+  // Each save goes through its own temp file, so the one that renames
+  // last wins whole and the other never truncates it.
+  auto saver = [this](HashTable *table, bool *ok) {
+    for (int i = 0; i < 50; i++) {
+      *ok = HashTable_Save(table, path_.c_str(), NULL) && *ok;
+    }
+  };
+  bool small_ok = true, large_ok = true;
+  std::thread t1(saver, small, &small_ok);
+  std::thread t2(saver, large, &large_ok);
+  t1.join();
+  t2.join();
+  ASSERT_TRUE(small_ok);
+  ASSERT_TRUE(large_ok);
+
+  HTSnapshot *snapshot = HashTable_MapFile(path_.c_str());
+  ASSERT_NE(nullptr, snapshot);
+  int num_elements = HTSnapshot_NumElements(snapshot);
+  ASSERT_TRUE(num_elements == 100 || num_elements == 200);
+  HTSnapshot_Unmap(snapshot);
+
+  // No temp files are left behind.
+  glob_t leftovers;
+  std::string pattern = path_ + ".*";
+  ASSERT_EQ(GLOB_NOMATCH, glob(pattern.c_str(), 0, NULL, &leftovers));
+
+  HashTable_Free(small, NULL);
+  HashTable_Free(large, NULL);
+}
+
+}  // namespace hw1
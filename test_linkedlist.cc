@@ -11,13 +11,18 @@
 
 #include <unistd.h>
 #include <errno.h>
+#include <stdint.h>
 #include <sys/select.h>
 
+#include <deque>
+
 #include "gtest/gtest.h"
 
 extern "C" {
   #include "./LinkedList.h"
   #include "./LinkedList_priv.h"
+  #include "./MemPool_priv.h"
+  #include "./UnrolledList_priv.h"
 }
 
 #include "./test_suite.h"
@@ -265,6 +270,381 @@ TEST_F(Test_LinkedList, Sort) {
   llp = NULL;
 }
 
+// A payload for the stability tests: the sort key, plus the element's
+// original position.
+typedef struct {
+  int key;
+  int seq;
+} SortItem;
+
+static int SortItemComparator(LLPayload_t p1, LLPayload_t p2) {
+  int k1 = static_cast<SortItem *>(p1)->key;
+  int k2 = static_cast<SortItem *>(p2)->key;
+  return (k1 > k2) - (k1 < k2);
+}
+
+// Checks that llp is a well-formed list, sorted by key in the given
+// direction, with equal keys still in "seq" order.
+static void VerifySorted(LinkedList *llp, int num_elements, bool ascending) {
+  ASSERT_EQ(num_elements, LinkedList_NumElements(llp));
+  ASSERT_EQ(NULL, llp->head->prev);
+  ASSERT_EQ(NULL, llp->tail->next);
+  int count = 1;
+  for (LinkedListNode *node = llp->head; node->next != NULL;
+       node = node->next, count++) {
+    ASSERT_EQ(node, node->next->prev);
+    SortItem *a = static_cast<SortItem *>(node->payload);
+    SortItem *b = static_cast<SortItem *>(node->next->payload);
+    if (a->key == b->key) {
+      ASSERT_LT(a->seq, b->seq);
+    } else {
+      ASSERT_EQ(ascending, a->key < b->key);
+    }
+    if (node->next->next == NULL) {
+      ASSERT_EQ(node->next, llp->tail);
+    }
+  }
+  ASSERT_EQ(num_elements, count);
+}
+
+TEST_F(Test_LinkedList, SortStable) {
+  const int kNumItems = 10000;
+  SortItem *items = new SortItem[kNumItems];
+
+  // Keys with plenty of duplicates, and a mix of ascending, descending
+  // and random stretches, so that the natural runs vary.
+  unsigned int x = 12345;
+  for (int i = 0; i < kNumItems; i++) {
+    x = x * 1103515245 + 12345;
+    if (i < kNumItems / 4) {
+      items[i].key = i / 8;
+    } else if (i < kNumItems / 2) {
+      items[i].key = (kNumItems - i) / 8;
+    } else {
+      items[i].key = (x >> 16) % 100;
+    }
+    items[i].seq = i;
+  }
+
+  LinkedList *llp = LinkedList_Allocate();
+  for (int i = 0; i < kNumItems; i++) {
+    LinkedList_Append(llp, &items[i]);
+  }
+  LinkedList_Sort(llp, true, &SortItemComparator);
+  VerifySorted(llp, kNumItems, true);
+
+  // Sorting descending keeps equal keys in their current order.
+  LinkedList_Sort(llp, false, &SortItemComparator);
+  VerifySorted(llp, kNumItems, false);
+
+  // Already-sorted input is left alone.
+  LinkedList_Sort(llp, false, &SortItemComparator);
+  VerifySorted(llp, kNumItems, false);
+  LinkedList_Free(llp, NULL);
+
+  // Two elements, in each order.
+  llp = LinkedList_Allocate();
+  LinkedList_Append(llp, &items[kNumItems - 1]);
+  LinkedList_Append(llp, &items[0]);
+  items[0].key = 1;
+  items[kNumItems - 1].key = 0;
+  LinkedList_Sort(llp, false, &SortItemComparator);
+  VerifySorted(llp, 2, false);
+  LinkedList_Sort(llp, true, &SortItemComparator);
+  VerifySorted(llp, 2, true);
+  LinkedList_Free(llp, NULL);
+
+  delete[] items;
+}
+
+TEST_F(Test_LinkedList, SortParallel) {
+  const int kNumItems = 50000;
+  SortItem *items = new SortItem[kNumItems];
+
+  unsigned int x = 54321;
+  for (int i = 0; i < kNumItems; i++) {
+    x = x * 1103515245 + 12345;
+    items[i].key = (x >> 16) % 1000;
+    items[i].seq = i;
+  }
+
+  // Several thread counts, including ones that don't divide the list
+  // evenly and more threads than the list has chunks for.
+  const int kThreads[] = { 0, 1, 3, 4, 7, 64 };
+  for (int num_threads : kThreads) {
+    LinkedList *llp = LinkedList_Allocate();
+    for (int i = 0; i < kNumItems; i++) {
+      LinkedList_Append(llp, &items[i]);
+    }
+    LinkedList_SortParallel(llp, true, &SortItemComparator, num_threads);
+    VerifySorted(llp, kNumItems, true);
+    LinkedList_SortParallel(llp, false, &SortItemComparator, num_threads);
+    VerifySorted(llp, kNumItems, false);
+    LinkedList_Free(llp, NULL);
+  }
+
+  // Short lists are fine too.
+  LinkedList *llp = LinkedList_Allocate();
+  LinkedList_SortParallel(llp, true, &SortItemComparator, 4);
+  ASSERT_EQ(0, LinkedList_NumElements(llp));
+  LinkedList_Append(llp, &items[0]);
+  LinkedList_SortParallel(llp, true, &SortItemComparator, 4);
+  VerifySorted(llp, 1, true);
+  LinkedList_Free(llp, NULL);
+
+  delete[] items;
+}
+
+// Key extractors for SortByKey.  The wide one spreads the (small) key
+// over every byte of the result, preserving its order.
+static uint64_t SortItemKey(LLPayload_t payload) {
+  return static_cast<uint64_t>(static_cast<SortItem *>(payload)->key);
+}
+
+static uint64_t SortItemWideKey(LLPayload_t payload) {
+  return SortItemKey(payload) * 0x0101010101010101ULL;
+}
+
+TEST_F(Test_LinkedList, SortByKey) {
+  const int kNumItems = 10000;
+  SortItem *items = new SortItem[kNumItems];
+
+  unsigned int x = 999;
+  for (int i = 0; i < kNumItems; i++) {
+    x = x * 1103515245 + 12345;
+    items[i].key = (x >> 16) % 256;
+    items[i].seq = i;
+  }
+
+  const LLPayloadKeyFnPtr kKeyFunctions[] = { &SortItemKey,
+                                              &SortItemWideKey };
+  for (LLPayloadKeyFnPtr key_function : kKeyFunctions) {
+    LinkedList *llp = LinkedList_Allocate();
+    for (int i = 0; i < kNumItems; i++) {
+      LinkedList_Append(llp, &items[i]);
+    }
+    LinkedList_SortByKey(llp, true, key_function);
+    VerifySorted(llp, kNumItems, true);
+    LinkedList_SortByKey(llp, false, key_function);
+    VerifySorted(llp, kNumItems, false);
+
+    // Agrees with the comparison sort.
+    LinkedList_SortByKey(llp, true, key_function);
+    LinkedList *expected = LinkedList_Allocate();
+    for (int i = 0; i < kNumItems; i++) {
+      LinkedList_Append(expected, &items[i]);
+    }
+    LinkedList_Sort(expected, true, &SortItemComparator);
+    for (LinkedListNode *a = llp->head, *b = expected->head; a != NULL;
+         a = a->next, b = b->next) {
+      ASSERT_EQ(b->payload, a->payload);
+    }
+    LinkedList_Free(expected, NULL);
+    LinkedList_Free(llp, NULL);
+  }
+
+  // Lists whose keys are all equal are left alone.
+  LinkedList *llp = LinkedList_Allocate();
+  for (int i = 0; i < 10; i++) {
+    items[i].key = 7;
+    LinkedList_Append(llp, &items[i]);
+  }
+  LinkedList_SortByKey(llp, false, &SortItemKey);
+  VerifySorted(llp, 10, false);
+  LinkedList_Free(llp, NULL);
+
+  delete[] items;
+}
+
+// Checks that an unrolled list is well-formed and holds exactly "expected",
+// in order, both by walking its chunks and through an iterator.  Returns
+// the number of chunks.
+static int VerifyUnrolled(LinkedList *llp,
+                          const std::deque<intptr_t> &expected) {
+  int num_chunks = 0;
+  size_t i = 0;
+
+  EXPECT_EQ(static_cast<int>(expected.size()), LinkedList_NumElements(llp));
+  EXPECT_EQ(NULL, llp->head);
+  EXPECT_EQ(NULL, llp->tail);
+  for (LLChunk *chunk = llp->head_chunk; chunk != NULL;
+       chunk = chunk->next, num_chunks++) {
+    EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(chunk) % LL_CHUNK_BYTES);
+    EXPECT_EQ(chunk->prev == NULL, chunk == llp->head_chunk);
+    EXPECT_EQ(chunk->next == NULL, chunk == llp->tail_chunk);
+    if (chunk->next != NULL) {
+      EXPECT_EQ(chunk, chunk->next->prev);
+    }
+    EXPECT_LT(0, chunk->count);
+    EXPECT_LE(0, chunk->start);
+    EXPECT_LE(chunk->start + chunk->count, LL_CHUNK_PAYLOADS);
+    for (int j = chunk->start; j < chunk->start + chunk->count; j++, i++) {
+      EXPECT_EQ(expected[i], (intptr_t)chunk->payloads[j]);
+    }
+  }
+  EXPECT_EQ(expected.size(), i);
+
+  LLIterator *lli = LLIterator_Allocate(llp);
+  LLPayload_t payload;
+  for (i = 0; i < expected.size(); i++) {
+    EXPECT_TRUE(LLIterator_IsValid(lli));
+    LLIterator_Get(lli, &payload);
+    EXPECT_EQ(expected[i], (intptr_t)payload);
+    EXPECT_EQ(i + 1 < expected.size(), LLIterator_Next(lli));
+  }
+  EXPECT_FALSE(LLIterator_IsValid(lli));
+  LLIterator_Free(lli);
+  return num_chunks;
+}
+
+TEST_F(Test_LinkedList, Unrolled) {
+  LinkedList *llp = LinkedList_AllocateUnrolled();
+  std::deque<intptr_t> expected;
+  LLPayload_t payload;
+  ASSERT_EQ(0, VerifyUnrolled(llp, expected));
+  ASSERT_FALSE(LinkedList_Pop(llp, &payload));
+  ASSERT_FALSE(LLSlice(llp, &payload));
+
+  // Appended payloads are packed into full chunks.
+  for (intptr_t i = 1; i <= 1000; i++) {
+    LinkedList_Append(llp, (LLPayload_t)i);
+    expected.push_back(i);
+  }
+  ASSERT_EQ((1000 + LL_CHUNK_PAYLOADS - 1) / LL_CHUNK_PAYLOADS,
+            VerifyUnrolled(llp, expected));
+
+  // Push, Pop, Append and Slice agree with a deque across chunk boundaries.
+  unsigned int x = 333;
+  for (int i = 0; i < 20000; i++) {
+    x = x * 1103515245 + 12345;
+    intptr_t value = 1001 + i;
+    switch ((x >> 16) % 4) {
+      case 0:
+        LinkedList_Push(llp, (LLPayload_t)value);
+        expected.push_front(value);
+        break;
+      case 1:
+        LinkedList_Append(llp, (LLPayload_t)value);
+        expected.push_back(value);
+        break;
+      case 2:
+        ASSERT_EQ(!expected.empty(), LinkedList_Pop(llp, &payload));
+        if (!expected.empty()) {
+          ASSERT_EQ(expected.front(), (intptr_t)payload);
+          expected.pop_front();
+        }
+        break;
+      default:
+        ASSERT_EQ(!expected.empty(), LLSlice(llp, &payload));
+        if (!expected.empty()) {
+          ASSERT_EQ(expected.back(), (intptr_t)payload);
+          expected.pop_back();
+        }
+        break;
+    }
+    if (i % 1000 == 0) {
+      VerifyUnrolled(llp, expected);
+    }
+  }
+  VerifyUnrolled(llp, expected);
+  LinkedList_Free(llp, &Test_LinkedList::StubbedFree);
+  ASSERT_EQ(static_cast<int>(expected.size()), freeInvocations_);
+
+  // Removing through an iterator merges chunks that fit together, so
+  // the list never has more than about twice the chunks it needs.
+  llp = LinkedList_AllocateUnrolled();
+  expected.clear();
+  for (intptr_t i = 1; i <= 1000; i++) {
+    LinkedList_Append(llp, (LLPayload_t)i);
+    expected.push_back(i);
+  }
+  LLIterator *lli = LLIterator_Allocate(llp);
+  freeInvocations_ = 0;
+  for (size_t i = 0; LLIterator_IsValid(lli); i++) {
+    LLIterator_Get(lli, &payload);
+    if ((intptr_t)payload % 3 != 0) {
+      LLIterator_Next(lli);
+      continue;
+    }
+    ASSERT_TRUE(LLIterator_Remove(lli, &Test_LinkedList::StubbedFree));
+    // The iterator moved to the successor.
+    LLIterator_Get(lli, &payload);
+    ASSERT_EQ((intptr_t)payload % 3, 1);
+  }
+  LLIterator_Free(lli);
+  ASSERT_EQ(333, freeInvocations_);
+  std::deque<intptr_t> kept;
+  for (intptr_t i : expected) {
+    if (i % 3 != 0) {
+      kept.push_back(i);
+    }
+  }
+  int num_chunks = VerifyUnrolled(llp, kept);
+  ASSERT_LE(num_chunks, 2 * (667 / LL_CHUNK_PAYLOADS + 1));
+
+  // Removing the tail moves the iterator to the new tail; removing the
+  // last payload invalidates it and empties the list.
+  lli = LLIterator_Allocate(llp);
+  for (int i = 1; i < 667; i++) {
+    LLIterator_Next(lli);
+  }
+  ASSERT_TRUE(LLIterator_Remove(lli, &Test_LinkedList::StubbedFree));
+  LLIterator_Get(lli, &payload);
+  ASSERT_EQ(kept[665], (intptr_t)payload);
+  kept.pop_back();
+  LLIteratorRewind(lli);
+  for (int i = 0; i < 665; i++) {
+    ASSERT_TRUE(LLIterator_Remove(lli, &Test_LinkedList::StubbedFree));
+    kept.pop_front();
+    VerifyUnrolled(llp, kept);
+  }
+  ASSERT_FALSE(LLIterator_Remove(lli, &Test_LinkedList::StubbedFree));
+  ASSERT_FALSE(LLIterator_IsValid(lli));
+  ASSERT_EQ(NULL, llp->head_chunk);
+  ASSERT_EQ(NULL, llp->tail_chunk);
+  ASSERT_EQ(1000, freeInvocations_);
+  LLIterator_Free(lli);
+  LinkedList_Free(llp, &Test_LinkedList::StubbedFree);
+  ASSERT_EQ(1000, freeInvocations_);
+
+  // Sorting sorts the payloads in place, stably.
+  const int kNumItems = 1000;
+  SortItem *items = new SortItem[kNumItems];
+  x = 999;
+  for (int i = 0; i < kNumItems; i++) {
+    x = x * 1103515245 + 12345;
+    items[i].key = (x >> 16) % 64;
+    items[i].seq = i;
+  }
+  for (int variant = 0; variant < 3; variant++) {
+    llp = LinkedList_AllocateUnrolled();
+    LinkedList *node_list = LinkedList_Allocate();
+    for (int i = 0; i < kNumItems; i++) {
+      LinkedList_Append(llp, &items[i]);
+      LinkedList_Append(node_list, &items[i]);
+    }
+    if (variant == 0) {
+      LinkedList_Sort(llp, false, &SortItemComparator);
+    } else if (variant == 1) {
+      LinkedList_SortParallel(llp, false, &SortItemComparator, 4);
+    } else {
+      LinkedList_SortByKey(llp, false, &SortItemKey);
+    }
+    LinkedList_Sort(node_list, false, &SortItemComparator);
+    VerifySorted(node_list, kNumItems, false);
+
+    std::deque<intptr_t> sorted;
+    for (LinkedListNode *node = node_list->head; node != NULL;
+         node = node->next) {
+      sorted.push_back((intptr_t)node->payload);
+    }
+    VerifyUnrolled(llp, sorted);
+    LinkedList_Free(node_list, NULL);
+    LinkedList_Free(llp, NULL);
+  }
+  delete[] items;
+}
+
 TEST_F(Test_LinkedList, TestLLIteratorBasic) {
   HW1Environment::OpenTestCase();
   // Create a linked list.
@@ -371,5 +751,51 @@ TEST_F(Test_LinkedList, TestLLIteratorBasic) {
   LinkedList_Free(llp, &Test_LinkedList::StubbedFree);
 }
 
+TEST_F(Test_LinkedList, Pooled) {
+  LinkedList *llp = LinkedList_AllocatePooled();
+  ASSERT_TRUE(llp->pool != NULL);
+  ASSERT_TRUE(llp->owns_pool);
+
+  // A pooled list behaves exactly like a malloc'd one.
+  LinkedList_Push(llp, kTwo);
+  LinkedList_Push(llp, kOne);
+  LinkedList_Append(llp, kThree);
+  ASSERT_EQ(3, LinkedList_NumElements(llp));
+  ASSERT_EQ(kOne, llp->head->payload);
+  ASSERT_EQ(kThree, llp->tail->payload);
+
+  LLPayload_t payload;
+  ASSERT_TRUE(LLSlice(llp, &payload));
+  ASSERT_EQ(kThree, payload);
+  ASSERT_TRUE(LinkedList_Pop(llp, &payload));
+  ASSERT_EQ(kOne, payload);
+
+  LLIterator *lli = LLIterator_Allocate(llp);
+  ASSERT_FALSE(LLIterator_Remove(lli, &Test_LinkedList::StubbedFree));
+  LLIterator_Free(lli);
+  ASSERT_EQ(1, freeInvocations_);
+  ASSERT_EQ(0, llp->pool->num_live);
+
+  // Freed nodes are recycled rather than growing the pool.
+  for (int i = 0; i < 100; i++) {
+    LinkedList_Append(llp, kFour);
+    ASSERT_TRUE(LinkedList_Pop(llp, &payload));
+  }
+  ASSERT_EQ(1, llp->pool->num_slabs);
+
+  for (int i = 0; i < 1000; i++) {
+    LinkedList_Append(llp, kFive);
+  }
+  ASSERT_EQ(1000, llp->pool->num_live);
+  LinkedList_Free(llp, &Test_LinkedList::StubbedFree);
+  ASSERT_EQ(1001, freeInvocations_);
+
+  // Passing a NULL free function skips the payloads entirely.
+  llp = LinkedList_AllocatePooled();
+  LinkedList_Push(llp, kOne);
+  LinkedList_Free(llp, NULL);
+  ASSERT_EQ(1001, freeInvocations_);
+}
+
 }  // namespace hw1
 
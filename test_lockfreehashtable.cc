@@ -0,0 +1,243 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+extern "C" {
+  #include "./LockFreeHashTable.h"
+}
+
+#include "gtest/gtest.h"
+
+#include "./test_suite.h"
+
+namespace hw1 {
+
+// Values encode their key and a version, so that readers can check that
+// whatever they find belongs to the key they asked for.
+static HTValue_t MakeValue(HTKey_t key, int version) {
+  return reinterpret_cast<HTValue_t>(
+      static_cast<uintptr_t>((key << 8) | (version & 0xFF) | 1));
+}
+
+static bool ValueMatchesKey(HTValue_t value, HTKey_t key) {
+  return (reinterpret_cast<uintptr_t>(value) >> 8) == key;
+}
+
+TEST(Test_LockFreeHashTable, InsertFindRemove) {
+  LockFreeHashTable *table = LockFreeHashTable_Allocate(3);
+  HTKeyValue_t newkv, oldkv;
+
+  ASSERT_EQ(4, LockFreeHashTable_NumBuckets(table));
+  ASSERT_EQ(0, LockFreeHashTable_NumElements(table));
+  ASSERT_FALSE(LockFreeHashTable_Find(table, 0, &oldkv));
+  ASSERT_FALSE(LockFreeHashTable_Remove(table, 0, &oldkv));
+
+  // Insert and replace enough keys to double the buckets many times over.
+  for (int i = 0; i < 10000; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = MakeValue(newkv.key, 0);
+    ASSERT_FALSE(LockFreeHashTable_Insert(table, newkv, &oldkv));
+    newkv.value = MakeValue(newkv.key, 1);
+    ASSERT_TRUE(LockFreeHashTable_Insert(table, newkv, &oldkv));
+    ASSERT_EQ(newkv.key, oldkv.key);
+    ASSERT_EQ(MakeValue(newkv.key, 0), oldkv.value);
+  }
+  ASSERT_EQ(10000, LockFreeHashTable_NumElements(table));
+  ASSERT_LE(4096, LockFreeHashTable_NumBuckets(table));
+
+  // Every key is still reachable after all that growth.
+  for (int i = 0; i < 10000; i++) {
+    HTKey_t key = static_cast<HTKey_t>(i);
+    ASSERT_TRUE(LockFreeHashTable_Find(table, key, &oldkv));
+    ASSERT_EQ(key, oldkv.key);
+    ASSERT_EQ(MakeValue(key, 1), oldkv.value);
+  }
+  ASSERT_FALSE(LockFreeHashTable_Find(table, 10000, &oldkv));
+
+  // Remove the even keys, then put one back.
+  for (int i = 0; i < 10000; i += 2) {
+    HTKey_t key = static_cast<HTKey_t>(i);
+    ASSERT_TRUE(LockFreeHashTable_Remove(table, key, &oldkv));
+    ASSERT_EQ(MakeValue(key, 1), oldkv.value);
+    ASSERT_FALSE(LockFreeHashTable_Remove(table, key, &oldkv));
+    ASSERT_FALSE(LockFreeHashTable_Find(table, key, &oldkv));
+  }
+  ASSERT_EQ(5000, LockFreeHashTable_NumElements(table));
+  newkv.key = 0;
+  newkv.value = NULL;
+  ASSERT_FALSE(LockFreeHashTable_Insert(table, newkv, &oldkv));
+  ASSERT_TRUE(LockFreeHashTable_Find(table, 0, &oldkv));
+  ASSERT_EQ(NULL, oldkv.value);
+
+  LockFreeHashTable_Free(table, NULL);
+}
+
+TEST(Test_LockFreeHashTable, ConcurrentDisjoint) {
+  const int kThreads = 4;
+  const int kKeysPerThread = 20000;
+  LockFreeHashTable *table = LockFreeHashTable_Allocate(1);
+  std::vector<std::thread> threads;
+
+  // Writers on disjoint keys, racing each other to grow the table: every
+  // insert must land, and every remove must find its key.
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([table, t]() {
+      HTKeyValue_t newkv, oldkv;
+      for (int i = 0; i < kKeysPerThread; i++) {
+        newkv.key = static_cast<HTKey_t>(t * kKeysPerThread + i);
+        newkv.value = MakeValue(newkv.key, 0);
+        EXPECT_FALSE(LockFreeHashTable_Insert(table, newkv, &oldkv));
+      }
+      for (int i = 1; i < kKeysPerThread; i += 2) {
+        HTKey_t key = static_cast<HTKey_t>(t * kKeysPerThread + i);
+        EXPECT_TRUE(LockFreeHashTable_Remove(table, key, &oldkv));
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(kThreads * kKeysPerThread / 2,
+            LockFreeHashTable_NumElements(table));
+  for (int i = 0; i < kThreads * kKeysPerThread; i++) {
+    HTKeyValue_t kv;
+    HTKey_t key = static_cast<HTKey_t>(i);
+    ASSERT_EQ(i % 2 == 0, LockFreeHashTable_Find(table, key, &kv));
+  }
+  LockFreeHashTable_Free(table, NULL);
+}
+
+TEST(Test_LockFreeHashTable, ConcurrentChurn) {
+  const int kThreads = 4;
+  const int kKeys = 256;
+  const int kOpsPerThread = 50000;
+  LockFreeHashTable *table = LockFreeHashTable_Allocate(1);
+  std::atomic<int> bad_values(0);
+  std::atomic<int> net_inserts(0);
+  std::vector<std::thread> threads;
+
+  // Every thread inserts, replaces, finds and removes the same small set
+  // of keys at random, so operations on a key collide constantly and the
+  // reclaimer has plenty to do.  Each thread tracks how many elements it
+  // added or took away; the totals must agree with the table.
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([table, t, &bad_values, &net_inserts]() {
+      uint64_t x = 0x9e3779b97f4a7c15ULL * (t + 1);
+      int net = 0;
+      for (int i = 0; i < kOpsPerThread; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        HTKey_t key = static_cast<HTKey_t>(x % kKeys);
+        HTKeyValue_t kv, oldkv;
+        switch ((x >> 32) % 3) {
+          case 0:
+            kv.key = key;
+            kv.value = MakeValue(key, t);
+            if (LockFreeHashTable_Insert(table, kv, &oldkv)) {
+              if (!ValueMatchesKey(oldkv.value, key)) bad_values++;
+            } else {
+              net++;
+            }
+            break;
+          case 1:
+            if (LockFreeHashTable_Find(table, key, &kv) &&
+                !ValueMatchesKey(kv.value, key)) {
+              bad_values++;
+            }
+            break;
+          default:
+            if (LockFreeHashTable_Remove(table, key, &kv)) {
+              if (!ValueMatchesKey(kv.value, key)) bad_values++;
+              net--;
+            }
+            break;
+        }
+      }
+      net_inserts += net;
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(0, bad_values.load());
+  int present = 0;
+  for (int i = 0; i < kKeys; i++) {
+    HTKeyValue_t kv;
+    present += LockFreeHashTable_Find(table, static_cast<HTKey_t>(i), &kv);
+  }
+  ASSERT_EQ(net_inserts.load(), present);
+  ASSERT_EQ(present, LockFreeHashTable_NumElements(table));
+  LockFreeHashTable_Free(table, NULL);
+}
+
+TEST(Test_LockFreeHashTable, ShortLivedThreads) {
+  const int kRounds = 20;
+  const int kThreads = 3;
+  const int kKeys = 100;
+  const int kPasses = 20;
+  LockFreeHashTable *table = LockFreeHashTable_Allocate(16);
+  std::atomic<int> bad_values(0);
+
+  // Each round's threads retire enough nodes apiece to advance the epoch a
+  // few times, and exit with more still in limbo; a long-lived reader keeps finding the same keys
+  // meanwhile.  The orphaned nodes are freed as later rounds advance the
+  // epoch, which must never pull a node out from under the reader.
+  std::atomic<bool> done(false);
+  std::thread reader([table, &bad_values, &done]() {
+    while (!done.load()) {
+      for (int i = 0; i < kKeys; i++) {
+        HTKeyValue_t kv;
+        HTKey_t key = static_cast<HTKey_t>(i);
+        if (LockFreeHashTable_Find(table, key, &kv) &&
+            !ValueMatchesKey(kv.value, key)) {
+          bad_values++;
+        }
+      }
+    }
+  });
+  for (int round = 0; round < kRounds; round++) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+      threads.emplace_back([table, round, t]() {
+        for (int pass = 0; pass < kPasses; pass++) {
+          for (int i = t; i < kKeys; i += kThreads) {
+            HTKeyValue_t kv, oldkv;
+            kv.key = static_cast<HTKey_t>(i);
+            kv.value = MakeValue(kv.key, round);
+            LockFreeHashTable_Insert(table, kv, &oldkv);
+            if ((i + round) % 2 == 0) {
+              LockFreeHashTable_Remove(table, kv.key, &oldkv);
+            }
+          }
+        }
+      });
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+  }
+  done = true;
+  reader.join();
+
+  ASSERT_EQ(0, bad_values.load());
+  ASSERT_EQ(kKeys / 2, LockFreeHashTable_NumElements(table));
+  LockFreeHashTable_Free(table, NULL);
+}
+
+}  // namespace hw1
@@ -0,0 +1,74 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+extern "C" {
+  #include "./MemPool.h"
+  #include "./MemPool_priv.h"
+}
+
+#include "gtest/gtest.h"
+
+#include "./test_suite.h"
+
+namespace hw1 {
+
+TEST(Test_MemPool, AllocFree) {
+  // Tiny objects are padded out so that freed ones can hold a link.
+  MemPool *pool = MemPool_Allocate(1);
+  ASSERT_TRUE(pool != NULL);
+  ASSERT_LE(sizeof(void *), pool->object_size);
+  ASSERT_EQ(0, pool->num_slabs);
+  ASSERT_EQ(0, pool->num_live);
+  MemPool_Free(pool);
+}
+
+TEST(Test_MemPool, ReuseAndGrowth) {
+  MemPool *pool = MemPool_Allocate(24);
+  void *objects[1000];
+
+  // Objects are distinct, aligned and writable.
+  for (int i = 0; i < 1000; i++) {
+    objects[i] = MemPool_AllocObject(pool);
+    ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(objects[i]) %
+                  alignof(max_align_t));
+    memset(objects[i], i & 0xFF, 24);
+    if (i > 0) {
+      ASSERT_NE(objects[i - 1], objects[i]);
+    }
+  }
+  ASSERT_EQ(1000, pool->num_live);
+
+  // Slabs double in size, so 1000 objects need only a handful of them.
+  int num_slabs = pool->num_slabs;
+  ASSERT_GE(7, num_slabs);
+
+  // Freed objects are reused (most recently freed first) before any new
+  // slab is allocated.
+  for (int i = 0; i < 1000; i += 2) {
+    MemPool_FreeObject(pool, objects[i]);
+  }
+  ASSERT_EQ(500, pool->num_live);
+  ASSERT_EQ(objects[998], MemPool_AllocObject(pool));
+  ASSERT_EQ(objects[996], MemPool_AllocObject(pool));
+  for (int i = 0; i < 498; i++) {
+    MemPool_AllocObject(pool);
+  }
+  ASSERT_EQ(1000, pool->num_live);
+  ASSERT_EQ(num_slabs, pool->num_slabs);
+
+  // Freeing the pool with objects outstanding releases everything.
+  MemPool_Free(pool);
+}
+
+}  // namespace hw1
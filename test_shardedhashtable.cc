@@ -0,0 +1,202 @@
+/*
+ * Copyright ©2024 Hannah C. Tang.  All rights reserved.  Permission is
+ * hereby granted to students registered for University of Washington
+ * CSE 333 for use solely during Autumn Quarter 2024 for purposes of
+ * the course.  No other use, copying, distribution, or modification
+ * is permitted without prior written consent. Copyrights for
+ * third-party components of this work must be honored.  Instructors
+ * interested in reusing these course materials should contact the
+ * author.
+ */
+
+#include <stdint.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+extern "C" {
+  #include "./HashTable_priv.h"
+  #include "./ShardedHashTable.h"
+  #include "./ShardedHashTable_priv.h"
+}
+
+#include "gtest/gtest.h"
+
+#include "./test_suite.h"
+
+namespace hw1 {
+
+static HTValue_t KeyValue(HTKey_t key) {
+  return reinterpret_cast<HTValue_t>(static_cast<uintptr_t>(key * 2 + 1));
+}
+
+TEST(Test_ShardedHashTable, InsertFindRemove) {
+  ShardedHashTable *table = ShardedHashTable_Allocate(6, 100);
+  HTKeyValue_t newkv, oldkv;
+
+  // Shard counts are rounded up to a power of two, and shard headers and
+  // their tables' records are padded out to whole cache lines.
+  ASSERT_EQ(8, ShardedHashTable_NumShards(table));
+  ASSERT_EQ(0U, sizeof(SHTShard) % SHT_CACHE_LINE);
+  ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(table->shards) % SHT_CACHE_LINE);
+  for (int s = 0; s < 8; s++) {
+    ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(table->shards[s].table) %
+                  HT_CACHE_LINE);
+  }
+  ASSERT_EQ(0, ShardedHashTable_NumElements(table));
+
+  for (int i = 0; i < 20000; i++) {
+    newkv.key = static_cast<HTKey_t>(i);
+    newkv.value = KeyValue(newkv.key);
+    ASSERT_FALSE(ShardedHashTable_Insert(table, newkv, &oldkv));
+    ASSERT_TRUE(ShardedHashTable_Insert(table, newkv, &oldkv));
+    ASSERT_EQ(newkv.key, oldkv.key);
+  }
+  ASSERT_EQ(20000, ShardedHashTable_NumElements(table));
+
+  // Keys are spread fairly over the shards, and each lives where it should.
+  for (int s = 0; s < 8; s++) {
+    HashTable *shard_table = table->shards[s].table;
+    ASSERT_LT(20000 / 8 * 9 / 10, HashTable_NumElements(shard_table));
+    HTIterator *it = HTIterator_Allocate(shard_table);
+    while (HTIterator_IsValid(it)) {
+      ASSERT_TRUE(HTIterator_Get(it, &oldkv));
+      ASSERT_EQ(s, ShardedHashTable_ShardOf(table, oldkv.key));
+      HTIterator_Next(it);
+    }
+    HTIterator_Free(it);
+  }
+
+  for (int i = 0; i < 20000; i++) {
+    HTKey_t key = static_cast<HTKey_t>(i);
+    ASSERT_TRUE(ShardedHashTable_Find(table, key, &oldkv));
+    ASSERT_EQ(KeyValue(key), oldkv.value);
+    if (i % 2 == 0) {
+      ASSERT_TRUE(ShardedHashTable_Remove(table, key, &oldkv));
+      ASSERT_FALSE(ShardedHashTable_Remove(table, key, &oldkv));
+      ASSERT_FALSE(ShardedHashTable_Find(table, key, &oldkv));
+    }
+  }
+  ASSERT_EQ(10000, ShardedHashTable_NumElements(table));
+  ShardedHashTable_Free(table, NULL);
+
+  // By default, there's a shard per CPU.
+  table = ShardedHashTable_Allocate(0, 1);
+  ASSERT_LE(static_cast<int>(std::thread::hardware_concurrency()),
+            ShardedHashTable_NumShards(table));
+  ShardedHashTable_Free(table, NULL);
+}
+
+TEST(Test_ShardedHashTable, Iterator) {
+  ShardedHashTable *table = ShardedHashTable_Allocate(16, 16);
+  HTKeyValue_t kv;
+
+  // An empty table's iterator is invalid from the start.
+  HTIterator *it = ShardedHashTable_IteratorAllocate(table);
+  ASSERT_FALSE(HTIterator_IsValid(it));
+  ASSERT_FALSE(HTIterator_Get(it, &kv));
+  ASSERT_FALSE(HTIterator_Next(it));
+  HTIterator_Free(it);
+
+  // A single key, in whichever shard, is found by skipping the empty ones.
+  kv.key = 12345;
+  kv.value = KeyValue(kv.key);
+  ShardedHashTable_Insert(table, kv, &kv);
+  it = ShardedHashTable_IteratorAllocate(table);
+  ASSERT_TRUE(HTIterator_IsValid(it));
+  ASSERT_TRUE(HTIterator_Get(it, &kv));
+  ASSERT_EQ(12345U, kv.key);
+  ASSERT_FALSE(HTIterator_Next(it));
+  ASSERT_FALSE(HTIterator_IsValid(it));
+  ASSERT_FALSE(HTIterator_Next(it));
+  HTIterator_Free(it);
+  ShardedHashTable_Remove(table, 12345, &kv);
+
+  // Every element of every shard is visited exactly once.
+  for (int i = 0; i < 5000; i++) {
+    kv.key = static_cast<HTKey_t>(i * 7);
+    kv.value = KeyValue(kv.key);
+    ShardedHashTable_Insert(table, kv, &kv);
+  }
+  std::set<HTKey_t> seen;
+  it = ShardedHashTable_IteratorAllocate(table);
+  for (; HTIterator_IsValid(it); HTIterator_Next(it)) {
+    ASSERT_TRUE(HTIterator_Get(it, &kv));
+    ASSERT_EQ(KeyValue(kv.key), kv.value);
+    ASSERT_TRUE(seen.insert(kv.key).second);
+  }
+  HTIterator_Free(it);
+  ASSERT_EQ(5000U, seen.size());
+
+  // Removing through the iterator empties every shard.
+  it = ShardedHashTable_IteratorAllocate(table);
+  int removed = 0;
+  while (HTIterator_Remove(it, &kv)) {
+    ASSERT_EQ(1U, seen.erase(kv.key));
+    removed++;
+  }
+  HTIterator_Free(it);
+  ASSERT_EQ(5000, removed);
+  ASSERT_EQ(0, ShardedHashTable_NumElements(table));
+  ShardedHashTable_Free(table, NULL);
+}
+
+TEST(Test_ShardedHashTable, ThreadAffine) {
+  const int kThreads = 4;
+  const int kKeysPerThread = 20000;
+  const int kRounds = 3;
+  ShardedHashTable *table = ShardedHashTable_Allocate(kThreads, 16);
+  std::vector<std::thread> threads;
+
+  // Each thread counts occurrences of its own shard's keys, through its
+  // locked shard table; meanwhile another thread inserts, and removes
+  // again, keys from every shard through the locked functions.
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([table, t]() {
+      for (int round = 0; round < kRounds; round++) {
+        HashTable *shard_table = ShardedHashTable_AcquireShard(table, t);
+        for (int i = 0; i < kKeysPerThread; i++) {
+          HTKeyValue_t kv, old;
+          kv.key = static_cast<HTKey_t>(i);
+          if (ShardedHashTable_ShardOf(table, kv.key) != t) {
+            continue;
+          }
+          uintptr_t count = 0;
+          if (HashTable_Find(shard_table, kv.key, &old)) {
+            count = reinterpret_cast<uintptr_t>(old.value);
+          }
+          kv.value = reinterpret_cast<HTValue_t>(count + 1);
+          HashTable_Insert(shard_table, kv, &old);
+        }
+        ShardedHashTable_ReleaseShard(table, t);
+      }
+    });
+  }
+  threads.emplace_back([table]() {
+    for (int i = 0; i < kKeysPerThread; i++) {
+      HTKeyValue_t kv, old;
+      kv.key = static_cast<HTKey_t>(kKeysPerThread + i);
+      kv.value = KeyValue(kv.key);
+      ShardedHashTable_Insert(table, kv, &old);
+      if (i % 2 == 1) {
+        ShardedHashTable_Remove(table, kv.key, &old);
+      }
+    }
+  });
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(kKeysPerThread + kKeysPerThread / 2,
+            ShardedHashTable_NumElements(table));
+  for (int i = 0; i < kKeysPerThread; i++) {
+    HTKeyValue_t kv;
+    ASSERT_TRUE(ShardedHashTable_Find(table, static_cast<HTKey_t>(i), &kv));
+    ASSERT_EQ(static_cast<uintptr_t>(kRounds),
+              reinterpret_cast<uintptr_t>(kv.value));
+  }
+  ShardedHashTable_Free(table, NULL);
+}
+
+}  // namespace hw1